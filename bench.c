@@ -0,0 +1,1453 @@
+#include "src/cvector.h"
+#include "src/cvector_bits.h"
+#include "src/cvector_concurrent.h"
+#include "src/cvector_deque.h"
+#include "src/cvector_file.h"
+#include "src/cvector_incremental.h"
+#include "src/cvector_map.h"
+#include "src/cvector_mmap.h"
+#include "src/cvector_packed.h"
+#include "src/cvector_parallel.h"
+#include "src/cvector_sharded.h"
+#include "src/cvector_simd.h"
+#include "src/cvector_soa.h"
+#include "src/cvector_sorted.h"
+#include "src/cvector_stable.h"
+#include "src/cvector_typed.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/* Monotonic clock in nanoseconds. */
+static double bench__now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((double)ts.tv_sec * 1e9) + (double)ts.tv_nsec;
+}
+
+/* Peak resident set size of the calling process in KiB. */
+static long bench__peak_rss_kb() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+/* Time stamp counter, 0 where there is none. */
+static unsigned long long bench__cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+/* Machine readable results, one line per run: name n ns/op cycles/op allocs peak_rss_kib. */
+#define BENCH__OUTPUT "bench_output.txt"
+
+/* Results of a previous run to compare against, see 'bench__compare'. */
+#define BENCH__BASELINE "bench_baseline.txt"
+
+/* A run is flagged when its ns/op is more than this ratio of the baseline's. */
+#ifndef BENCH__REGRESSION_RATIO
+#define BENCH__REGRESSION_RATIO 1.25
+#endif
+
+/* Number of allocator calls (alloc and realloc) made through 'bench__counting' since the timer
+ * was last reset. */
+static size_t bench__allocs;
+
+static void *bench__counting_alloc(void *ctx, size_t size) {
+  (void)ctx;
+  bench__allocs++;
+  return malloc(size);
+}
+
+static void *bench__counting_realloc(void *ctx, void *mem, size_t old_size, size_t new_size) {
+  (void)ctx;
+  (void)old_size;
+  bench__allocs++;
+  return realloc(mem, new_size);
+}
+
+static void bench__counting_free(void *ctx, void *mem, size_t size) {
+  (void)ctx;
+  (void)size;
+  free(mem);
+}
+
+/* libc allocator that counts calls, bind vectors to it with 'cvector__init_with_allocator'. */
+static const cvector_allocator_t bench__counting = {
+    .cvector_allocator__alloc_m = bench__counting_alloc,
+    .cvector_allocator__realloc_m = bench__counting_realloc,
+    .cvector_allocator__free_m = bench__counting_free,
+};
+
+/* Start of the measured part of the current run. */
+static double bench__start_ns;
+static unsigned long long bench__start_cycles;
+
+/* Restarts measurement, for benchmarks that must prepare data before the part they measure. */
+static void bench__reset_timer() {
+  bench__allocs = 0;
+  bench__start_ns = bench__now_ns();
+  bench__start_cycles = bench__cycles();
+}
+
+/* Runs 'fn(n)' in a forked child so that each run reports its own peak RSS.
+ * 'fn' returns the number of operations it performed. Only runs whose name starts with the
+ * BENCH_FILTER environment variable run, when it is set. */
+static void bench__run(const char *name, size_t (*fn)(size_t), size_t n) {
+  const char *filter = getenv("BENCH_FILTER");
+  if ((filter != NULL) && (strncmp(name, filter, strlen(filter)) != 0)) {
+    return;
+  }
+
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0) {
+    // The first clock read of a fresh process faults in the vDSO data, keep it out of the run.
+    bench__now_ns();
+    bench__reset_timer();
+    size_t ops = fn(n);
+    double cycles = (double)(bench__cycles() - bench__start_cycles);
+    double elapsed = bench__now_ns() - bench__start_ns;
+    printf("%-28s n=%-10zu %8.2f ns/op %8.1f cyc/op %10.1f Mop/s  allocs=%-6zu peak_rss=%ld KiB\n",
+           name, n, elapsed / ops, cycles / ops, (ops / elapsed) * 1e3, bench__allocs,
+           bench__peak_rss_kb());
+
+    FILE *output = fopen(BENCH__OUTPUT, "a");
+    if (output != NULL) {
+      fprintf(output, "%s %zu %.3f %.1f %zu %ld\n", name, n, elapsed / ops, cycles / ops,
+              bench__allocs, bench__peak_rss_kb());
+      fclose(output);
+    }
+    exit(0);
+  }
+  waitpid(pid, NULL, 0);
+}
+
+/* Compares every run of BENCH__OUTPUT with the same run of BENCH__BASELINE, if there is one.
+ * Returns the number of runs slower than BENCH__REGRESSION_RATIO times the baseline. */
+static int bench__compare() {
+  FILE *baseline = fopen(BENCH__BASELINE, "r");
+  FILE *output = fopen(BENCH__OUTPUT, "r");
+  int regressions = 0;
+  if ((baseline == NULL) || (output == NULL)) {
+    printf("\nno %s to compare with, 'make bench-baseline' records one\n", BENCH__BASELINE);
+  } else {
+    char name[64], base_name[64];
+    size_t n, base_n;
+    double ns, base_ns;
+    while (fscanf(output, "%63s %zu %lf %*f %*u %*d", name, &n, &ns) == 3) {
+      rewind(baseline);
+      while (fscanf(baseline, "%63s %zu %lf %*f %*u %*d", base_name, &base_n, &base_ns) == 3) {
+        if ((base_n == n) && (strcmp(base_name, name) == 0)) {
+          if (ns > base_ns * BENCH__REGRESSION_RATIO) {
+            printf("REGRESSION %-28s n=%-10zu %8.2f -> %8.2f ns/op (%+.0f%%)\n", name, n, base_ns,
+                   ns, (ns / base_ns - 1) * 100);
+            regressions++;
+          }
+          break;
+        }
+      }
+    }
+    printf("\n%d regression(s) against %s\n", regressions, BENCH__BASELINE);
+  }
+  if (baseline != NULL) {
+    fclose(baseline);
+  }
+  if (output != NULL) {
+    fclose(output);
+  }
+  return regressions;
+}
+
+typedef struct {
+  unsigned long a;
+  unsigned long b;
+  unsigned long c;
+  unsigned long d;
+} bench__record_t;
+
+CVector(bench__record_t) bench__vector_record_t;
+
+typedef struct {
+  unsigned long v[16];
+} bench__elem128_t;
+
+/* Element-ops done by one run of the core benchmarks, small sizes repeat to reach it. */
+#define BENCH__CORE_WORK ((size_t)1 << 24)
+
+/* Core benchmarks are skipped for vectors bigger than this. */
+#define BENCH__CORE_MAX_BYTES ((size_t)1 << 30)
+
+/* PRIVATE: Number of repetitions of an 'n' element pass in a core benchmark. */
+#define bench__core_repeat_(n) (((n) >= BENCH__CORE_WORK) ? 1 : BENCH__CORE_WORK / (n))
+
+/* PRIVATE: Element of type 'T' whose first word is 'i'. */
+#define bench__core_value_(T, i)                                                                   \
+  ({                                                                                               \
+    T bench__value_m;                                                                              \
+    memset(&bench__value_m, 0, sizeof(bench__value_m));                                            \
+    size_t bench__word_m = (i);                                                                    \
+    memcpy(&bench__value_m, &bench__word_m, sizeof(bench__word_m));                                \
+    bench__value_m;                                                                                \
+  })
+
+/* PRIVATE: First word of element. */
+#define bench__core_word_(elem)                                                                    \
+  ({                                                                                               \
+    size_t bench__word_m;                                                                          \
+    memcpy(&bench__word_m, &(elem), sizeof(bench__word_m));                                        \
+    bench__word_m;                                                                                 \
+  })
+
+/*
+ * PRIVATE: Generates the core benchmarks of vectors of 'T' (add, pop, index, iterate and
+ * init_with_cap on 'n' elements) and table 'bench__core_tag' of them. Every vector goes through
+ * the counting allocator.
+ */
+#define BENCH__CORE_(T, tag)                                                                       \
+  CVector(T) bench__core_##tag##_t;                                                                \
+  CVector_iterator(bench__core_##tag##_t) bench__core_##tag##_iterator_t;                          \
+                                                                                                   \
+  static size_t bench__core_add_##tag(size_t n) {                                                  \
+    size_t repeat = bench__core_repeat_(n);                                                        \
+    for (size_t r = 0; r < repeat; r++) {                                                          \
+      bench__core_##tag##_t vector;                                                                \
+      cvector__init_with_allocator(&vector, &bench__counting);                                     \
+      for (size_t i = 0; i < n; i++) {                                                             \
+        cvector__add(&vector, bench__core_value_(T, i));                                           \
+      }                                                                                            \
+      cvector__free(&vector);                                                                      \
+    }                                                                                              \
+    return repeat * n;                                                                             \
+  }                                                                                                \
+                                                                                                   \
+  /* Pops every element of enough vectors of 'n' elements, filled before measuring. */             \
+  static size_t bench__core_pop_##tag(size_t n) {                                                  \
+    size_t count = (n >= ((size_t)1 << 20)) ? 1 : ((size_t)1 << 20) / n;                           \
+    bench__core_##tag##_t *vectors = malloc(count * sizeof(*vectors));                             \
+    for (size_t k = 0; k < count; k++) {                                                           \
+      cvector__init_with_allocator(&vectors[k], &bench__counting);                                 \
+      for (size_t i = 0; i < n; i++) {                                                             \
+        cvector__add(&vectors[k], bench__core_value_(T, i));                                       \
+      }                                                                                            \
+    }                                                                                              \
+    bench__reset_timer();                                                                          \
+    volatile size_t sink = 0;                                                                      \
+    for (size_t k = 0; k < count; k++) {                                                           \
+      while (cvector__size(&vectors[k]) > 0) {                                                     \
+        T value = cvector__pop(&vectors[k]);                                                       \
+        sink += bench__core_word_(value);                                                          \
+      }                                                                                            \
+      cvector__free(&vectors[k]);                                                                  \
+    }                                                                                              \
+    free(vectors);                                                                                 \
+    return count * n;                                                                              \
+  }                                                                                                \
+                                                                                                   \
+  /* Reads every element with 'cvector__index', vector filled before measuring. */                 \
+  static size_t bench__core_index_##tag(size_t n) {                                                \
+    bench__core_##tag##_t vector;                                                                  \
+    cvector__init_with_allocator(&vector, &bench__counting);                                       \
+    for (size_t i = 0; i < n; i++) {                                                               \
+      cvector__add(&vector, bench__core_value_(T, i));                                             \
+    }                                                                                              \
+    bench__reset_timer();                                                                          \
+    size_t repeat = bench__core_repeat_(n);                                                        \
+    volatile size_t sink = 0;                                                                      \
+    (void)sink;                                                                                    \
+    for (size_t r = 0; r < repeat; r++) {                                                          \
+      size_t sum = 0;                                                                              \
+      for (size_t i = 0; i < n; i++) {                                                             \
+        sum += bench__core_word_(cvector__index(&vector, i));                                      \
+      }                                                                                            \
+      sink = sum;                                                                                  \
+    }                                                                                              \
+    cvector__free(&vector);                                                                        \
+    return repeat * n;                                                                             \
+  }                                                                                                \
+                                                                                                   \
+  /* Same with the iterator. */                                                                    \
+  static size_t bench__core_iterate_##tag(size_t n) {                                              \
+    bench__core_##tag##_t vector;                                                                  \
+    cvector__init_with_allocator(&vector, &bench__counting);                                       \
+    for (size_t i = 0; i < n; i++) {                                                               \
+      cvector__add(&vector, bench__core_value_(T, i));                                             \
+    }                                                                                              \
+    bench__reset_timer();                                                                          \
+    size_t repeat = bench__core_repeat_(n);                                                        \
+    volatile size_t sink = 0;                                                                      \
+    (void)sink;                                                                                    \
+    for (size_t r = 0; r < repeat; r++) {                                                          \
+      bench__core_##tag##_iterator_t iterator;                                                     \
+      cvector_iterator__init(&iterator, &vector);                                                  \
+      size_t sum = 0;                                                                              \
+      while (!cvector_iterator__done(&iterator)) {                                                 \
+        sum += bench__core_word_(*cvector_iterator__next_ref(&iterator));                          \
+      }                                                                                            \
+      sink = sum;                                                                                  \
+    }                                                                                              \
+    cvector__free(&vector);                                                                        \
+    return repeat * n;                                                                             \
+  }                                                                                                \
+                                                                                                   \
+  /* Creates and frees vectors of cap 'n', an op is one vector. Same as 'cvector__init_with_cap'   \
+   * but through the counting allocator. */                                                        \
+  static size_t bench__core_init_with_cap_##tag(size_t n) {                                        \
+    size_t repeat = (bench__core_repeat_(n) > 65536) ? 65536 : bench__core_repeat_(n);             \
+    for (size_t r = 0; r < repeat; r++) {                                                          \
+      bench__core_##tag##_t vector;                                                                \
+      cvector__init_with_allocator(&vector, &bench__counting);                                     \
+      cvector__reserve(&vector, n);                                                                \
+      cvector__free(&vector);                                                                      \
+    }                                                                                              \
+    return repeat;                                                                                 \
+  }                                                                                                \
+                                                                                                   \
+  static size_t (*const bench__core_##tag[])(size_t) = {                                           \
+      bench__core_add_##tag, bench__core_pop_##tag, bench__core_index_##tag,                       \
+      bench__core_iterate_##tag, bench__core_init_with_cap_##tag};
+
+BENCH__CORE_(unsigned long, 8)
+BENCH__CORE_(bench__record_t, 32)
+BENCH__CORE_(bench__elem128_t, 128)
+
+/* Growth strategy used by cvector__resize_ before it switched to realloc:
+ * fresh block, copy 'size' elements, free the old block. */
+#define bench__resize_copy_(vec, cap)                                                              \
+  do {                                                                                             \
+    void *bench__mem_m = malloc((cvector__elem_size_(vec)) * (cap));                               \
+    memcpy((bench__mem_m), (cvector__elem_(vec)),                                                  \
+           ((cvector__elem_size_(vec)) * (cvector__size(vec))));                                   \
+    free(cvector__elem_(vec));                                                                     \
+    cvector__set_elem_((vec), (bench__mem_m));                                                     \
+    cvector__setcap_((vec), (cap));                                                                \
+  } while (0)
+
+static size_t bench__append_copy(size_t n) {
+  bench__vector_record_t vector;
+  cvector__init(&vector);
+  for (size_t i = 0; i < n; i++) {
+    if (cvector__size(&vector) >= cvector__cap_(&vector)) {
+      bench__resize_copy_(&vector, (cvector__cap_(&vector) == 0) ? 1 : cvector__cap_(&vector) * 2);
+    }
+    cvector__index(&vector, cvector__size(&vector)) = ((bench__record_t){.a = i});
+    cvector__setsize_(&vector, cvector__size(&vector) + 1);
+  }
+  cvector__free(&vector);
+  return n;
+}
+
+static size_t bench__append(size_t n) {
+  bench__vector_record_t vector;
+  cvector__init(&vector);
+  for (size_t i = 0; i < n; i++) {
+    cvector__add(&vector, ((bench__record_t){.a = i}));
+  }
+  cvector__free(&vector);
+  return n;
+}
+
+/* Appends 'n' records to a vector backed by anonymous mmap with hugepage hint. */
+static size_t bench__append_mmap(size_t n) {
+  cvector_mmap_t huge;
+  cvector_mmap__init(&huge, CVECTOR_MMAP__THRESHOLD, true);
+
+  bench__vector_record_t vector;
+  cvector__init_with_allocator(&vector, cvector_mmap__allocator(&huge));
+  for (size_t i = 0; i < n; i++) {
+    cvector__add(&vector, ((bench__record_t){.a = i}));
+  }
+  cvector__free(&vector);
+  return n;
+}
+
+CVector_stable(bench__record_t) bench__stable_record_t;
+
+/* Appends 'n' records to a segmented vector, growth never copies. */
+static size_t bench__append_stable(size_t n) {
+  bench__stable_record_t vector;
+  cvector__stable_init(&vector);
+  for (size_t i = 0; i < n; i++) {
+    cvector__stable_add(&vector, ((bench__record_t){.a = i}));
+  }
+  cvector__stable_free(&vector);
+  return n;
+}
+
+/* Log-linear histogram of single operation latencies: 8 buckets per power of two of ns. */
+static unsigned long bench__histogram[64 * 8];
+static double bench__histogram_max;
+
+static void bench__histogram_add(double ns) {
+  unsigned long value = (ns < 8) ? 8 : (unsigned long)ns;
+  int exponent = 63 - __builtin_clzl(value);
+  bench__histogram[exponent * 8 + ((value >> (exponent - 3)) & 7)]++;
+  bench__histogram_max = (ns > bench__histogram_max) ? ns : bench__histogram_max;
+}
+
+/* Upper bound in ns of the bucket holding the 'p' quantile of 'total' recorded latencies. */
+static double bench__histogram_quantile(double p, size_t total) {
+  unsigned long seen = 0;
+  for (int bucket = 0; bucket < 64 * 8; bucket++) {
+    seen += bench__histogram[bucket];
+    if (seen >= p * total) {
+      int exponent = bucket / 8;
+      return (double)((8UL + bucket % 8 + 1) << (exponent - 3));
+    }
+  }
+  return bench__histogram_max;
+}
+
+static void bench__histogram_report(const char *name, size_t n) {
+  printf("%-28s n=%-10zu p50=%.0f ns  p99=%.0f ns  p99.9=%.0f ns  max=%.0f ns\n", name, n,
+         bench__histogram_quantile(0.5, n), bench__histogram_quantile(0.99, n),
+         bench__histogram_quantile(0.999, n), bench__histogram_max);
+}
+
+/* Times every single add of 'n' records to a vector whose resize copies (like allocators that
+ * can't extend or remap a block). */
+static size_t bench__latency_copy(size_t n) {
+  bench__vector_record_t vector;
+  cvector__init(&vector);
+  for (size_t i = 0; i < n; i++) {
+    double start = bench__now_ns();
+    if (cvector__size(&vector) >= cvector__cap_(&vector)) {
+      bench__resize_copy_(&vector, (cvector__cap_(&vector) == 0) ? 1 : cvector__cap_(&vector) * 2);
+    }
+    cvector__index(&vector, cvector__size(&vector)) = ((bench__record_t){.a = i});
+    cvector__setsize_(&vector, cvector__size(&vector) + 1);
+    bench__histogram_add(bench__now_ns() - start);
+  }
+  bench__histogram_report("latency/malloc+memcpy", n);
+  cvector__free(&vector);
+  return n;
+}
+
+/* Times every single add of 'n' records to a plain vector. */
+static size_t bench__latency_add(size_t n) {
+  bench__vector_record_t vector;
+  cvector__init(&vector);
+  for (size_t i = 0; i < n; i++) {
+    double start = bench__now_ns();
+    cvector__add(&vector, ((bench__record_t){.a = i}));
+    bench__histogram_add(bench__now_ns() - start);
+  }
+  bench__histogram_report("latency/cvector__add", n);
+  cvector__free(&vector);
+  return n;
+}
+
+CVector_incremental(bench__record_t) bench__incremental_record_t;
+
+/* Same with an incrementally resized vector. */
+static size_t bench__latency_incremental(size_t n) {
+  bench__incremental_record_t vector;
+  cvector__incremental_init(&vector);
+  for (size_t i = 0; i < n; i++) {
+    double start = bench__now_ns();
+    cvector__incremental_add(&vector, ((bench__record_t){.a = i}));
+    bench__histogram_add(bench__now_ns() - start);
+  }
+  bench__histogram_report("latency/incremental_add", n);
+  cvector__incremental_free(&vector);
+  return n;
+}
+
+/* Ingests 'n' records in decoded batches of 4096, one element at a time. */
+static size_t bench__batch_add(size_t n) {
+  bench__record_t batch[4096] = {0};
+  bench__vector_record_t vector;
+  cvector__init(&vector);
+  for (size_t i = 0; i < n; i += 4096) {
+    for (size_t j = 0; j < 4096; j++) {
+      cvector__add(&vector, batch[j]);
+    }
+  }
+  cvector__free(&vector);
+  return n;
+}
+
+/* Ingests 'n' records in decoded batches of 4096 with a single bulk append per batch. */
+static size_t bench__batch_add_n(size_t n) {
+  bench__record_t batch[4096] = {0};
+  bench__vector_record_t vector;
+  cvector__init(&vector);
+  for (size_t i = 0; i < n; i += 4096) {
+    cvector__add_n(&vector, batch, 4096);
+  }
+  cvector__free(&vector);
+  return n;
+}
+
+/* Fills vector to 'n' elements and drains it back to empty 16 times with given growth policy,
+ * with or without implicit shrinking. */
+static size_t bench__churn(size_t n, unsigned int policy, bool shrink) {
+  bench__vector_record_t vector;
+  cvector__init(&vector);
+  cvector__set_growth(&vector, policy);
+  cvector__set_shrink(&vector, shrink);
+  for (int cycle = 0; cycle < 16; cycle++) {
+    for (size_t i = 0; i < n; i++) {
+      cvector__add(&vector, ((bench__record_t){.a = i}));
+    }
+    for (size_t i = 0; i < n; i++) {
+      cvector__pop(&vector);
+    }
+  }
+  cvector__free(&vector);
+  return 32 * n;
+}
+
+CVector(long) bench__vector_long_t;
+CVector_iterator(bench__vector_long_t) bench__iterator_long_t;
+
+/* Shrink test used by cvector__pop before it went integer only: double division on every pop. */
+#define bench__pop_fp_(vec)                                                                        \
+  ({                                                                                               \
+    double bench__load_factor_m = (((double)cvector__size(vec)) / ((double)cvector__cap_(vec)));   \
+    if ((bench__load_factor_m <= CVECTOR__LOAD_FACTOR) &&                                          \
+        (cvector__size(vec) >= CVECTOR__MIN_SHRINK_SIZE)) {                                        \
+      cvector__resize_((vec), (cvector__size(vec) * 2));                                           \
+    }                                                                                              \
+    cvector__setsize_((vec), (cvector__size(vec) - 1));                                            \
+    (cvector__index((vec), cvector__size(vec)));                                                   \
+  })
+
+/* Stack workload: vector stays at 'n' elements, every iteration pops the top and pushes it back,
+ * so each pop pays for the shrink decision without ever shrinking. */
+#define bench__pop_variant_(name, pop)                                                             \
+  static size_t name(size_t n) {                                                                   \
+    bench__vector_long_t vector;                                                                   \
+    cvector__init(&vector);                                                                        \
+    for (size_t i = 0; i < n; i++) {                                                               \
+      cvector__add(&vector, (long)i);                                                              \
+    }                                                                                              \
+    volatile long sink = 0;                                                                        \
+    for (size_t i = 0; i < 64 * n; i++) {                                                          \
+      long value = pop(&vector);                                                                   \
+      sink += value;                                                                               \
+      cvector__add(&vector, value);                                                                \
+    }                                                                                              \
+    cvector__free(&vector);                                                                        \
+    return 64 * n;                                                                                 \
+  }
+
+bench__pop_variant_(bench__pop_fp, bench__pop_fp_);
+bench__pop_variant_(bench__pop, cvector__pop);
+bench__pop_variant_(bench__pop_noshrink, cvector__pop_noshrink);
+
+#define bench__churn_variant_(name, policy, shrink)                                                \
+  static size_t name(size_t n) { return bench__churn(n, (policy), (shrink)); }
+
+bench__churn_variant_(bench__churn_double, CVECTOR__GROWTH_DOUBLE, true);
+bench__churn_variant_(bench__churn_double_noshrink, CVECTOR__GROWTH_DOUBLE, false);
+bench__churn_variant_(bench__churn_1_5x, CVECTOR__GROWTH_1_5X, true);
+bench__churn_variant_(bench__churn_1_5x_noshrink, CVECTOR__GROWTH_1_5X, false);
+bench__churn_variant_(bench__churn_page, CVECTOR__GROWTH_PAGE, true);
+bench__churn_variant_(bench__churn_page_noshrink, CVECTOR__GROWTH_PAGE, false);
+bench__churn_variant_(bench__churn_chunk, CVECTOR__GROWTH_CHUNK, true);
+bench__churn_variant_(bench__churn_chunk_noshrink, CVECTOR__GROWTH_CHUNK, false);
+
+/* Number of writer threads of the multi-threaded append benchmarks. */
+static size_t bench__threads = 1;
+
+/* Shared result vector of the mutex based append benchmark. */
+static bench__vector_long_t bench__locked_vector;
+static pthread_mutex_t bench__locked_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+CVector_concurrent(long) bench__concurrent_long_t;
+
+/* Shared result vector of the lock-free append benchmark. */
+static bench__concurrent_long_t bench__concurrent_vector;
+
+static void *bench__locked_writer(void *arg) {
+  size_t n = (size_t)arg;
+  for (size_t i = 0; i < n; i++) {
+    pthread_mutex_lock(&bench__locked_mutex);
+    cvector__add(&bench__locked_vector, (long)i);
+    pthread_mutex_unlock(&bench__locked_mutex);
+  }
+  return NULL;
+}
+
+static void *bench__concurrent_writer(void *arg) {
+  size_t n = (size_t)arg;
+  for (size_t i = 0; i < n; i++) {
+    cvector__concurrent_add(&bench__concurrent_vector, (long)i);
+  }
+  return NULL;
+}
+
+/* Runs 'bench__threads' threads appending 'n' elements in total through 'writer'. */
+static void bench__spawn(void *(*writer)(void *), size_t n) {
+  pthread_t threads[64];
+  for (size_t i = 0; i < bench__threads; i++) {
+    pthread_create(&threads[i], NULL, writer, (void *)(n / bench__threads));
+  }
+  for (size_t i = 0; i < bench__threads; i++) {
+    pthread_join(threads[i], NULL);
+  }
+}
+
+/* Many threads appending to one CVector behind a mutex. */
+static size_t bench__mt_append_locked(size_t n) {
+  cvector__init(&bench__locked_vector);
+  bench__spawn(bench__locked_writer, n);
+  cvector__free(&bench__locked_vector);
+  return n;
+}
+
+/* Many threads appending to one CVector_concurrent. */
+static size_t bench__mt_append_concurrent(size_t n) {
+  cvector__concurrent_init(&bench__concurrent_vector);
+  bench__spawn(bench__concurrent_writer, n);
+  cvector__concurrent_free(&bench__concurrent_vector);
+  return n;
+}
+
+CVector_sharded(long) bench__sharded_long_t;
+
+/* Per-thread result shards of the sharded append benchmark. */
+static bench__sharded_long_t bench__sharded_vector;
+static size_t bench__sharded_per_thread;
+
+static void *bench__sharded_writer(void *arg) {
+  size_t shard = (size_t)arg;
+  for (size_t i = 0; i < bench__sharded_per_thread; i++) {
+    cvector__add(cvector__sharded_shard(&bench__sharded_vector, shard), (long)i);
+  }
+  return NULL;
+}
+
+/* Many threads appending to their own shard, then collected into one CVector. */
+static size_t bench__mt_append_sharded(size_t n) {
+  cvector__sharded_init(&bench__sharded_vector, bench__threads);
+  bench__sharded_per_thread = n / bench__threads;
+
+  pthread_t threads[64];
+  for (size_t i = 0; i < bench__threads; i++) {
+    pthread_create(&threads[i], NULL, bench__sharded_writer, (void *)i);
+  }
+  for (size_t i = 0; i < bench__threads; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  bench__vector_long_t all;
+  cvector__init(&all);
+  cvector__sharded_collect(&bench__sharded_vector, &all);
+  cvector__free(&all);
+  cvector__sharded_free(&bench__sharded_vector);
+  return n;
+}
+
+CVECTOR_DEFINE(bench__typed_long, long)
+
+/* PRIVATE: Repeats a statement once per vector of the call site benchmarks. */
+#define BENCH__SITES_(stmt)                                                                        \
+  stmt(0) stmt(1) stmt(2) stmt(3) stmt(4) stmt(5) stmt(6) stmt(7) stmt(8) stmt(9) stmt(10)         \
+      stmt(11) stmt(12) stmt(13) stmt(14) stmt(15)
+
+#define BENCH__MACRO_ADD_(k) cvector__add(&vectors[k], (long)(i + k));
+#define BENCH__TYPED_ADD_(k) bench__typed_long_add(&vectors[k], (long)(i + k));
+
+/* Appends to 16 vectors from 16 call sites, each 'cvector__add' expanding its growth path. */
+static size_t bench__sites_macro(size_t n) {
+  bench__vector_long_t vectors[16];
+  for (size_t k = 0; k < 16; k++) {
+    cvector__init(&vectors[k]);
+  }
+  for (size_t i = 0; i < n / 16; i++) {
+    BENCH__SITES_(BENCH__MACRO_ADD_)
+  }
+  for (size_t k = 0; k < 16; k++) {
+    cvector__free(&vectors[k]);
+  }
+  return n / 16 * 16;
+}
+
+/* Same with the generated functions, call sites only carry the inline fast path. */
+static size_t bench__sites_typed(size_t n) {
+  bench__typed_long_t vectors[16];
+  for (size_t k = 0; k < 16; k++) {
+    bench__typed_long_init(&vectors[k]);
+  }
+  for (size_t i = 0; i < n / 16; i++) {
+    BENCH__SITES_(BENCH__TYPED_ADD_)
+  }
+  for (size_t k = 0; k < 16; k++) {
+    bench__typed_long_free(&vectors[k]);
+  }
+  return n / 16 * 16;
+}
+
+/* Depth of the work queue in the FIFO benchmarks. */
+#define BENCH__FIFO_DEPTH 1024
+
+/* Work queue on a plain vector: push at the back, remove from the front by shifting. */
+static size_t bench__fifo_vector(size_t n) {
+  bench__vector_long_t queue;
+  cvector__init(&queue);
+  volatile long sink = 0;
+  (void)sink;
+  for (size_t i = 0; i < n; i++) {
+    cvector__add(&queue, (long)i);
+    if (cvector__size(&queue) > BENCH__FIFO_DEPTH) {
+      sink = cvector__first(&queue);
+      cvector__erase_range(&queue, 0, 1);
+    }
+  }
+  cvector__free(&queue);
+  return n;
+}
+
+CVector_deque(long) bench__deque_long_t;
+
+/* Same work queue on a deque. */
+static size_t bench__fifo_deque(size_t n) {
+  bench__deque_long_t queue;
+  cvector__deque_init(&queue);
+  volatile long sink = 0;
+  (void)sink;
+  for (size_t i = 0; i < n; i++) {
+    cvector__deque_push_back(&queue, (long)i);
+    if (cvector__size(&queue) > BENCH__FIFO_DEPTH) {
+      sink = cvector__deque_pop_front(&queue);
+    }
+  }
+  cvector__deque_free(&queue);
+  return n;
+}
+
+CVector_deque_spsc(long) bench__spsc_long_t;
+
+static bench__spsc_long_t bench__spsc;
+
+static void *bench__spsc_producer(void *arg) {
+  size_t n = (size_t)arg;
+  for (size_t i = 0; i < n; i++) {
+    while (!cvector__deque_spsc_push(&bench__spsc, (long)i)) {
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+
+/* One thread handing 'n' elements to another through the SPSC ring. */
+static size_t bench__fifo_spsc(size_t n) {
+  cvector__deque_spsc_init(&bench__spsc, BENCH__FIFO_DEPTH);
+  pthread_t producer;
+  pthread_create(&producer, NULL, bench__spsc_producer, (void *)n);
+  volatile long sink = 0;
+  (void)sink;
+  long value;
+  for (size_t i = 0; i < n; i++) {
+    while (!cvector__deque_spsc_pop(&bench__spsc, &value)) {
+      sched_yield();
+    }
+    sink = value;
+  }
+  pthread_join(producer, NULL);
+  cvector__deque_spsc_free(&bench__spsc);
+  return n;
+}
+
+static int bench__compare_long(const void *a, const void *b) {
+  long x = *(const long *)a;
+  long y = *(const long *)b;
+  return (x > y) - (x < y);
+}
+
+static void bench__sum_long(void *acc, const void *elem, void *ctx) {
+  (void)ctx;
+  *(long *)acc += *(const long *)elem;
+}
+
+/* Fills vector with 'n' pseudo random values. */
+static void bench__fill_random(bench__vector_long_t *vector, size_t n) {
+  unsigned long seed = 42;
+  cvector__init_with_cap(vector, n);
+  for (size_t i = 0; i < n; i++) {
+    seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+    cvector__add(vector, (long)(seed >> 16));
+  }
+}
+
+/* Sorting 'n' elements with libc qsort. */
+static size_t bench__sort_qsort(size_t n) {
+  bench__vector_long_t vector;
+  bench__fill_random(&vector, n);
+  qsort(cvector__wrapped_buffer(&vector), n, sizeof(long), bench__compare_long);
+  cvector__free(&vector);
+  return n;
+}
+
+/* Sorting 'n' elements with the parallel merge sort, one worker per CPU.
+ * The pool is started in the benchmark itself, threads don't survive the fork of 'bench__run'. */
+static size_t bench__sort_parallel(size_t n) {
+  cvector_parallel_t parallel;
+  cvector_parallel__init(&parallel, 0);
+  bench__vector_long_t vector;
+  bench__fill_random(&vector, n);
+  cvector__parallel_sort(&parallel, &vector, bench__compare_long);
+  cvector__free(&vector);
+  cvector_parallel__destroy(&parallel);
+  return n;
+}
+
+/* Sorting 'n' elements with introsort. */
+static size_t bench__sort_intro(size_t n) {
+  bench__vector_long_t vector;
+  bench__fill_random(&vector, n);
+  cvector__sort(&vector, bench__compare_long);
+  cvector__free(&vector);
+  return n;
+}
+
+/* Sorting 'n' elements with radix sort. */
+static size_t bench__sort_radix(size_t n) {
+  bench__vector_long_t vector;
+  bench__fill_random(&vector, n);
+  cvector__radix_sort(&vector);
+  cvector__free(&vector);
+  return n;
+}
+
+CVector_eytzinger(long) bench__eytzinger_long_t;
+
+/* Lookup method of 'bench__lookup': 0 linear scan, 1 binary search, 2 Eytzinger view. */
+static int bench__lookup_method;
+
+/* Random lookups in a sorted table of 'n' even numbers, half of them misses. */
+static size_t bench__lookup(size_t n) {
+  bench__vector_long_t table;
+  cvector__init_with_cap(&table, n);
+  for (size_t i = 0; i < n; i++) {
+    cvector__add(&table, (long)(2 * i));
+  }
+
+  bench__eytzinger_long_t view;
+  cvector__eytzinger_build(&view, &table);
+
+  // Linear scans get fewer lookups so that big tables finish.
+  size_t lookups = (bench__lookup_method == 0) ? ((size_t)1 << 28) / n + 1 : (size_t)1 << 20;
+  unsigned long seed = 42;
+  size_t hits = 0;
+  for (size_t i = 0; i < lookups; i++) {
+    seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+    long key = (long)((seed >> 20) % (2 * n));
+    if (bench__lookup_method == 0) {
+      bench__iterator_long_t iterator;
+      cvector_iterator__init(&iterator, &table);
+      while (!cvector_iterator__done(&iterator)) {
+        if (cvector_iterator__next(&iterator) == key) {
+          hits++;
+          break;
+        }
+      }
+    } else if (bench__lookup_method == 1) {
+      hits += (cvector__binary_search(&table, key, bench__compare_long) != -1);
+    } else {
+      hits += (cvector__eytzinger_find(&view, key, bench__compare_long) != NULL);
+    }
+  }
+
+  volatile size_t sink = hits;
+  (void)sink;
+  cvector__eytzinger_free(&view);
+  cvector__free(&table);
+  return lookups;
+}
+
+typedef struct {
+  long key;
+  long value;
+} bench__pair_t;
+
+CVector(bench__pair_t) bench__vector_pair_t;
+CVector_iterator(bench__vector_pair_t) bench__iterator_pair_t;
+CMap(long, long) bench__map_long_t;
+
+/* Map of 'bench__map_lookup': 0 vector of pairs scanned linearly, 1 CMap. */
+static int bench__map_method;
+
+/* Random lookups of values among 'n' scattered keys, half of them misses. */
+static size_t bench__map_lookup(size_t n) {
+  bench__vector_pair_t pairs;
+  bench__map_long_t map;
+  cvector__init(&pairs);
+  cmap__init(&map);
+  for (size_t i = 0; i < n; i++) {
+    long key = (long)(i * 2654435761u) * 2;
+    if (bench__map_method == 0) {
+      cvector__add(&pairs, ((bench__pair_t){key, (long)i}));
+    } else {
+      cmap__put(&map, key, (long)i);
+    }
+  }
+  bench__reset_timer();
+
+  // Linear scans get fewer lookups so that big maps finish.
+  size_t lookups = (bench__map_method == 0) ? ((size_t)1 << 28) / n + 1 : (size_t)1 << 22;
+  unsigned long seed = 42;
+  long sum = 0;
+  for (size_t i = 0; i < lookups; i++) {
+    seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+    long key = (long)(((seed >> 20) % n) * 2654435761u) * 2 + (long)((seed >> 10) & 1);
+    if (bench__map_method == 0) {
+      bench__iterator_pair_t iterator;
+      cvector_iterator__init(&iterator, &pairs);
+      while (!cvector_iterator__done(&iterator)) {
+        bench__pair_t pair = cvector_iterator__next(&iterator);
+        if (pair.key == key) {
+          sum += pair.value;
+          break;
+        }
+      }
+    } else {
+      sum += cmap__get(&map, key, 0L);
+    }
+  }
+
+  volatile long sink = sum;
+  (void)sink;
+  cvector__free(&pairs);
+  cmap__free(&map);
+  return lookups;
+}
+
+/* Reducing 'n' elements through the same combiner on one thread. */
+static size_t bench__reduce_serial(size_t n) {
+  bench__vector_long_t vector;
+  bench__fill_random(&vector, n);
+  long sum = 0;
+  for (size_t i = 0; i < n; i++) {
+    bench__sum_long(&sum, &cvector__index(&vector, i), NULL);
+  }
+  volatile long sink = sum;
+  (void)sink;
+  cvector__free(&vector);
+  return n;
+}
+
+/* Reducing 'n' elements with the pool, one worker per CPU. */
+static size_t bench__reduce_parallel(size_t n) {
+  cvector_parallel_t parallel;
+  cvector_parallel__init(&parallel, 0);
+  bench__vector_long_t vector;
+  bench__fill_random(&vector, n);
+  volatile long sink = cvector__parallel_reduce(&parallel, &vector, 0L, bench__sum_long, NULL);
+  (void)sink;
+  cvector__free(&vector);
+  cvector_parallel__destroy(&parallel);
+  return n;
+}
+
+CVector(float) bench__vector_float_t;
+CVector_iterator(bench__vector_float_t) bench__iterator_float_t;
+
+/* Column scanned by the SIMD benchmarks, filled once before the runs fork. */
+static bench__vector_float_t bench__column;
+
+/* Scan measured by 'bench__scan': 0 find, 1 count, 2 minmax, 3 sum. */
+static int bench__scan_op;
+/* Kernel level of 'bench__scan', -1 for a plain 'cvector_iterator__next' loop. */
+static int bench__scan_level;
+
+/* Same scan written with the iterator macros. */
+static float bench__scan_iterator(bench__vector_float_t *column, size_t n) {
+  bench__iterator_float_t iterator;
+  cvector_iterator__init(&iterator, column);
+  float result = 0;
+  float min = cvector__first(column);
+  float max = min;
+  long found = -1;
+  for (size_t i = 0; i < n; i++) {
+    float value = cvector_iterator__next(&iterator);
+    if (bench__scan_op == 0) {
+      if (value == -1.0f) {
+        found = (long)i;
+        break;
+      }
+    } else if (bench__scan_op == 1) {
+      result += (value == 0.0f);
+    } else if (bench__scan_op == 2) {
+      min = (value < min) ? value : min;
+      max = (value > max) ? value : max;
+    } else {
+      result += value;
+    }
+  }
+  return result + min + max + (float)found;
+}
+
+/* Scans first 'n' elements of the column, repeated so that every size scans 2^26 elements. */
+static size_t bench__scan(size_t n) {
+  size_t repeat = ((size_t)1 << 26) / n;
+  bench__vector_float_t column = bench__column;
+  cvector__setsize_(&column, n);
+  if (bench__scan_level >= 0) {
+    cvector_simd__set_level(bench__scan_level);
+  }
+
+  volatile float sink = 0;
+  (void)sink;
+  float min, max;
+  for (size_t r = 0; r < repeat; r++) {
+    if (bench__scan_level < 0) {
+      sink = bench__scan_iterator(&column, n);
+    } else if (bench__scan_op == 0) {
+      sink = (float)cvector__find(&column, -1.0f);
+    } else if (bench__scan_op == 1) {
+      sink = (float)cvector__count(&column, 0.0f);
+    } else if (bench__scan_op == 2) {
+      cvector__minmax(&column, &min, &max);
+      sink = min + max;
+    } else {
+      sink = cvector__sum(&column);
+    }
+  }
+  return repeat * n;
+}
+
+#define BENCH__BODY_FIELDS(X)                                                                      \
+  X(double, x) X(double, y) X(double, z) X(double, vx) X(double, vy) X(double, vz) X(float, mass)  \
+  X(int, id)
+
+typedef struct {
+  BENCH__BODY_FIELDS(CVECTOR_SOA__FIELD)
+} bench__body_t;
+
+CVector(bench__body_t) bench__vector_body_t;
+CVector_soa(bench__body_t, BENCH__BODY_FIELDS) bench__soa_body_t;
+
+/* Sums field 'mass' of 'n' bodies, repeated so that every size scans 2^26 bodies. */
+static size_t bench__scan_aos(size_t n) {
+  bench__vector_body_t bodies;
+  cvector__init_with_cap(&bodies, n);
+  for (size_t i = 0; i < n; i++) {
+    cvector__add(&bodies, ((bench__body_t){.mass = (float)(i % 100), .id = (int)i}));
+  }
+
+  size_t repeat = ((size_t)1 << 26) / n;
+  volatile float sink = 0;
+  (void)sink;
+  for (size_t r = 0; r < repeat; r++) {
+    float sum = 0;
+    for (size_t i = 0; i < n; i++) {
+      sum += cvector__index(&bodies, i).mass;
+    }
+    sink = sum;
+  }
+  cvector__free(&bodies);
+  return repeat * n;
+}
+
+/* Same scan over the 'mass' column of a structure of arrays vector. */
+static size_t bench__scan_soa(size_t n) {
+  bench__soa_body_t bodies;
+  cvector__soa_init(&bodies, BENCH__BODY_FIELDS);
+  cvector__soa_reserve(&bodies, n);
+  for (size_t i = 0; i < n; i++) {
+    cvector__soa_add(&bodies, ((bench__body_t){.mass = (float)(i % 100), .id = (int)i}));
+  }
+
+  size_t repeat = ((size_t)1 << 26) / n;
+  volatile float sink = 0;
+  (void)sink;
+  for (size_t r = 0; r < repeat; r++) {
+    const float *mass = cvector__soa_column(&bodies, mass);
+    float sum = 0;
+    for (size_t i = 0; i < n; i++) {
+      sum += mass[i];
+    }
+    sink = sum;
+  }
+  cvector__soa_free(&bodies);
+  return repeat * n;
+}
+
+CVector(uint64_t) bench__vector_u64_t;
+CVector_packed(uint64_t) bench__packed_u64_t;
+CVector_packed_iterator(bench__packed_u64_t) bench__packed_u64_iterator_t;
+
+/* Sorted ids with gaps of up to 10 bits, the 'i'-th of the sequence started by 'id'. */
+static uint64_t bench__next_id(uint64_t id, size_t i) {
+  return id + ((uint32_t)(i * 2654435761u) >> 22);
+}
+
+/* Sums 'n' sorted ids, repeated so that every size scans 2^26 ids. */
+static size_t bench__scan_ids(size_t n) {
+  bench__vector_u64_t ids;
+  cvector__init_with_cap(&ids, n);
+  uint64_t id = 1000000000;
+  for (size_t i = 0; i < n; i++) {
+    id = bench__next_id(id, i);
+    cvector__add(&ids, id);
+  }
+  bench__reset_timer();
+
+  size_t repeat = ((size_t)1 << 26) / n;
+  volatile uint64_t sink = 0;
+  (void)sink;
+  for (size_t r = 0; r < repeat; r++) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; i++) {
+      sum += cvector__index(&ids, i);
+    }
+    sink = sum;
+  }
+  cvector__free(&ids);
+  return repeat * n;
+}
+
+/* Same scan over a packed vector, decoded a block at a time by its iterator. */
+static size_t bench__scan_ids_packed(size_t n) {
+  bench__packed_u64_t ids;
+  cvector__packed_init(&ids);
+  uint64_t id = 1000000000;
+  for (size_t i = 0; i < n; i++) {
+    id = bench__next_id(id, i);
+    cvector__packed_add(&ids, id);
+  }
+  bench__reset_timer();
+
+  size_t repeat = ((size_t)1 << 26) / n;
+  volatile uint64_t sink = 0;
+  (void)sink;
+  for (size_t r = 0; r < repeat; r++) {
+    bench__packed_u64_iterator_t iterator;
+    cvector_packed_iterator__init(&iterator, &ids);
+    uint64_t sum = 0;
+    while (!cvector_packed_iterator__done(&iterator)) {
+      sum += cvector_packed_iterator__next(&iterator);
+    }
+    sink = sum;
+  }
+  cvector__packed_free(&ids);
+  return repeat * n;
+}
+
+CVector(bool) bench__vector_bool_t;
+CVector_bits bench__bits_t;
+
+/* Random flags, about one in 'one_in' set, untimed for the filter benchmarks. */
+static bool bench__flag(unsigned long *seed, unsigned int one_in) {
+  *seed = *seed * 6364136223846793005UL + 1442695040888963407UL;
+  return ((*seed >> 33) % one_in) == 0;
+}
+
+/* Evaluates filter '(filter | a) & b' over 'n' flags and counts its hits, repeated so that every
+ * size evaluates 2^28 flags. */
+static size_t bench__filter_bool(size_t n) {
+  bench__vector_bool_t a, b, filter;
+  cvector__init_with_cap(&a, n);
+  cvector__init_with_cap(&b, n);
+  cvector__init_with_cap(&filter, n);
+  unsigned long seed = 42;
+  for (size_t i = 0; i < n; i++) {
+    cvector__add(&a, bench__flag(&seed, 4));
+    cvector__add(&b, bench__flag(&seed, 2));
+    cvector__add(&filter, false);
+  }
+  bench__reset_timer();
+
+  size_t repeat = ((size_t)1 << 28) / n;
+  volatile size_t sink = 0;
+  (void)sink;
+  for (size_t r = 0; r < repeat; r++) {
+    size_t hits = 0;
+    for (size_t i = 0; i < n; i++) {
+      bool hit = (cvector__index(&filter, i) | cvector__index(&a, i)) & cvector__index(&b, i);
+      cvector__set_at_index(&filter, i, hit);
+      hits += hit;
+    }
+    sink = hits;
+  }
+  cvector__free(&a);
+  cvector__free(&b);
+  cvector__free(&filter);
+  return repeat * n;
+}
+
+/* Same filter over bit vectors, combined and counted by the bulk kernels. */
+static size_t bench__filter_bits(size_t n) {
+  bench__bits_t a, b, filter;
+  cvector__bits_init(&a);
+  cvector__bits_init(&b);
+  cvector__bits_init(&filter);
+  cvector__bits_resize(&filter, n);
+  unsigned long seed = 42;
+  for (size_t i = 0; i < n; i++) {
+    cvector__bits_add(&a, bench__flag(&seed, 4));
+    cvector__bits_add(&b, bench__flag(&seed, 2));
+  }
+  bench__reset_timer();
+
+  size_t repeat = ((size_t)1 << 28) / n;
+  volatile size_t sink = 0;
+  (void)sink;
+  for (size_t r = 0; r < repeat; r++) {
+    cvector__bits_or(&filter, &a);
+    cvector__bits_and(&filter, &b);
+    sink = cvector__bits_count(&filter);
+  }
+  cvector__bits_free(&a);
+  cvector__bits_free(&b);
+  cvector__bits_free(&filter);
+  return repeat * n;
+}
+
+/* Readers handed the vector by the fan-out benchmarks. */
+#define BENCH__READERS 8
+
+/* Builds vector of 'n' records, untimed, for the fan-out benchmarks. */
+static void bench__fanout_prepare(bench__vector_record_t *vector, size_t n) {
+  cvector__init_with_cap(vector, n);
+  for (size_t i = 0; i < n; i++) {
+    cvector__add(vector, ((bench__record_t){.a = i}));
+  }
+  bench__reset_timer();
+}
+
+/* Hands a vector of 'n' records to readers by deep copy. One reader of them writes.
+ * Reports one op per reader. */
+static size_t bench__fanout_copy(size_t n) {
+  bench__vector_record_t vector;
+  bench__fanout_prepare(&vector, n);
+  for (size_t r = 0; r < BENCH__READERS; r++) {
+    bench__vector_record_t reader;
+    cvector__init_with_cap(&reader, n);
+    memcpy(cvector__wrapped_buffer(&reader), cvector__wrapped_buffer(&vector),
+           n * sizeof(bench__record_t));
+    cvector__setsize_(&reader, n);
+    if (r == 0) {
+      cvector__add(&reader, ((bench__record_t){.a = r}));
+    }
+    volatile unsigned long sink = cvector__last(&reader).a;
+    (void)sink;
+    cvector__free(&reader);
+  }
+  cvector__free(&vector);
+  return BENCH__READERS;
+}
+
+/* Same readers with 'cvector__share', only the writer copies. */
+static size_t bench__fanout_share(size_t n) {
+  bench__vector_record_t vector;
+  bench__fanout_prepare(&vector, n);
+  for (size_t r = 0; r < BENCH__READERS; r++) {
+    bench__vector_record_t reader;
+    cvector__share(&reader, &vector);
+    if (r == 0) {
+      cvector__add(&reader, ((bench__record_t){.a = r}));
+    }
+    volatile unsigned long sink = cvector__last(&reader).a;
+    (void)sink;
+    cvector__free(&reader);
+  }
+  cvector__free(&vector);
+  return BENCH__READERS;
+}
+
+/* Vector file used by the startup benchmarks. */
+static char bench__file_path[] = "/tmp/cvector_bench_XXXXXX";
+
+/* Writes vector file of 'n' records for the startup benchmarks. */
+static void bench__file_prepare(size_t n) {
+  bench__vector_record_t vector;
+  cvector_file_t file;
+  if (cvector__file_open(&vector, &file, bench__file_path, CVECTOR_FILE__RDWR) == -1) {
+    perror(bench__file_path);
+    exit(1);
+  }
+  cvector__setsize_(&vector, 0);
+  for (size_t i = 0; i < n; i++) {
+    cvector__add(&vector, ((bench__record_t){.a = i}));
+  }
+  cvector__file_close(&vector, &file);
+}
+
+/* Startup by reading the whole file into a heap vector. Reports one op per startup. */
+static size_t bench__startup_read(size_t n) {
+  (void)n;
+  int fd = open(bench__file_path, O_RDONLY);
+  cvector_file_header_t header;
+  read(fd, &header, sizeof(header));
+  lseek(fd, CVECTOR_FILE__HEADER_SIZE, SEEK_SET);
+
+  size_t size = header.cvector_file_header__size_m;
+  bench__vector_record_t vector;
+  cvector__init_with_cap(&vector, size);
+  read(fd, cvector__wrapped_buffer(&vector), size * sizeof(bench__record_t));
+  cvector__setsize_(&vector, size);
+  close(fd);
+
+  volatile unsigned long sink = cvector__last(&vector).a;
+  (void)sink;
+  cvector__free(&vector);
+  return 1;
+}
+
+/* Startup by attaching to the file, pages are faulted in on demand. */
+static size_t bench__startup_attach(size_t n) {
+  (void)n;
+  bench__vector_record_t vector;
+  cvector_file_t file;
+  if (cvector__file_open(&vector, &file, bench__file_path, CVECTOR_FILE__RDONLY) == -1) {
+    perror(bench__file_path);
+    exit(1);
+  }
+
+  volatile unsigned long sink = cvector__last(&vector).a;
+  (void)sink;
+  cvector__file_close(&vector, &file);
+  return 1;
+}
+
+int main() {
+  remove(BENCH__OUTPUT);
+  char name[64];
+
+  const char *core_ops[] = {"add", "pop", "index", "iterate", "init_with_cap"};
+  size_t core_sizes[] = {16, 1 << 10, 1 << 16, 1 << 20, 1 << 24, 100000000};
+  size_t core_elem_sizes[] = {8, 32, 128};
+  size_t (*const *core_fns[])(size_t) = {bench__core_8, bench__core_32, bench__core_128};
+  for (size_t i = 0; i < sizeof(core_sizes) / sizeof(core_sizes[0]); i++) {
+    for (size_t e = 0; e < 3; e++) {
+      if (core_sizes[i] * core_elem_sizes[e] > BENCH__CORE_MAX_BYTES) {
+        continue;
+      }
+      for (size_t op = 0; op < 5; op++) {
+        snprintf(name, sizeof(name), "core/%s/%zuB", core_ops[op], core_elem_sizes[e]);
+        bench__run(name, core_fns[e][op], core_sizes[i]);
+      }
+    }
+  }
+
+  size_t sizes[] = {1 << 10, 1 << 16, 1 << 20, 1 << 23};
+
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    bench__run("append/malloc+memcpy", bench__append_copy, sizes[i]);
+    bench__run("append/cvector__add", bench__append, sizes[i]);
+    bench__run("append/mmap+hugepages", bench__append_mmap, sizes[i]);
+    bench__run("append/cvector__stable_add", bench__append_stable, sizes[i]);
+    bench__run("sites/cvector__add", bench__sites_macro, sizes[i]);
+    bench__run("sites/CVECTOR_DEFINE", bench__sites_typed, sizes[i]);
+    bench__run("batch/cvector__add", bench__batch_add, sizes[i]);
+    bench__run("batch/cvector__add_n", bench__batch_add_n, sizes[i]);
+    bench__run("pop/double-division", bench__pop_fp, sizes[i]);
+    bench__run("pop/cvector__pop", bench__pop, sizes[i]);
+    bench__run("pop/cvector__pop_noshrink", bench__pop_noshrink, sizes[i]);
+    bench__run("churn/double", bench__churn_double, sizes[i]);
+    bench__run("churn/double/noshrink", bench__churn_double_noshrink, sizes[i]);
+    bench__run("churn/1.5x", bench__churn_1_5x, sizes[i]);
+    bench__run("churn/1.5x/noshrink", bench__churn_1_5x_noshrink, sizes[i]);
+    bench__run("churn/page", bench__churn_page, sizes[i]);
+    bench__run("churn/page/noshrink", bench__churn_page_noshrink, sizes[i]);
+    bench__run("churn/chunk", bench__churn_chunk, sizes[i]);
+    bench__run("churn/chunk/noshrink", bench__churn_chunk_noshrink, sizes[i]);
+  }
+
+  for (size_t i = 2; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    bench__run("latency/malloc+memcpy", bench__latency_copy, sizes[i]);
+    bench__run("latency/cvector__add", bench__latency_add, sizes[i]);
+    bench__run("latency/incremental_add", bench__latency_incremental, sizes[i]);
+  }
+
+  for (bench__threads = 1; bench__threads <= 32; bench__threads *= 2) {
+    snprintf(name, sizeof(name), "mt_append/mutex/%zut", bench__threads);
+    bench__run(name, bench__mt_append_locked, 1 << 22);
+    snprintf(name, sizeof(name), "mt_append/concurrent/%zut", bench__threads);
+    bench__run(name, bench__mt_append_concurrent, 1 << 22);
+    snprintf(name, sizeof(name), "mt_append/sharded+collect/%zut", bench__threads);
+    bench__run(name, bench__mt_append_sharded, 1 << 22);
+  }
+
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    bench__run("fifo/cvector__erase_range", bench__fifo_vector, sizes[i]);
+    bench__run("fifo/cvector__deque", bench__fifo_deque, sizes[i]);
+    bench__run("fifo/cvector__deque_spsc/2t", bench__fifo_spsc, sizes[i]);
+  }
+
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    bench__run("sort/qsort", bench__sort_qsort, sizes[i]);
+    bench__run("sort/cvector__parallel_sort", bench__sort_parallel, sizes[i]);
+    bench__run("sort/cvector__sort", bench__sort_intro, sizes[i]);
+    bench__run("sort/cvector__radix_sort", bench__sort_radix, sizes[i]);
+    bench__run("reduce/serial", bench__reduce_serial, sizes[i]);
+    bench__run("reduce/cvector__parallel_reduce", bench__reduce_parallel, sizes[i]);
+  }
+
+  const char *lookup_methods[] = {"iterator", "cvector__binary_search", "cvector__eytzinger_find"};
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    for (bench__lookup_method = 0; bench__lookup_method < 3; bench__lookup_method++) {
+      snprintf(name, sizeof(name), "lookup/%s", lookup_methods[bench__lookup_method]);
+      bench__run(name, bench__lookup, sizes[i]);
+    }
+  }
+
+  const char *map_methods[] = {"CVector(pair)+iterator", "CMap"};
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    for (bench__map_method = 0; bench__map_method < 2; bench__map_method++) {
+      snprintf(name, sizeof(name), "map/%s", map_methods[bench__map_method]);
+      bench__run(name, bench__map_lookup, sizes[i]);
+    }
+  }
+
+  const char *scan_ops[] = {"find", "count", "minmax", "sum"};
+  const char *scan_levels[] = {"iterator", "scalar", "sse2", "avx2", "avx512"};
+  cvector__init_with_cap(&bench__column, sizes[3]);
+  for (size_t i = 0; i < sizes[3]; i++) {
+    cvector__add(&bench__column, (float)(i % 1000));
+  }
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    for (bench__scan_op = 0; bench__scan_op < 4; bench__scan_op++) {
+      for (bench__scan_level = -1; bench__scan_level <= cvector_simd__level();
+           bench__scan_level++) {
+        snprintf(name, sizeof(name), "scan/%s/%s", scan_ops[bench__scan_op],
+                 scan_levels[bench__scan_level + 1]);
+        bench__run(name, bench__scan, sizes[i]);
+      }
+    }
+  }
+  cvector__free(&bench__column);
+
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    bench__run("scan_field/CVector(struct)", bench__scan_aos, sizes[i]);
+    bench__run("scan_field/CVector_soa", bench__scan_soa, sizes[i]);
+    bench__run("scan_ids/CVector(uint64_t)", bench__scan_ids, sizes[i]);
+    bench__run("scan_ids/CVector_packed", bench__scan_ids_packed, sizes[i]);
+  }
+
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    bench__run("filter/CVector(bool)", bench__filter_bool, sizes[i]);
+    bench__run("filter/CVector_bits", bench__filter_bits, sizes[i]);
+  }
+
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    bench__run("fanout/wrapped_buffer+memcpy", bench__fanout_copy, sizes[i]);
+    bench__run("fanout/cvector__share", bench__fanout_share, sizes[i]);
+  }
+
+  close(mkstemp(bench__file_path));
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    bench__file_prepare(sizes[i]);
+    bench__run("startup/read", bench__startup_read, sizes[i]);
+    bench__run("startup/cvector__file_open", bench__startup_attach, sizes[i]);
+  }
+  unlink(bench__file_path);
+
+  return (bench__compare() > 0) ? 1 : 0;
+}
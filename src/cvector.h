@@ -36,6 +36,8 @@
  *   int* cvector__elem_m;
  *   size_t cvecor__size_m;
  *   size_t cvector__cap_m;
+ *   const cvector_allocator_t *cvector__allocator_m;
+ *   unsigned int cvector__flags_m;
  *   bool cvector__initialized_m;
  * } cvector_int_t;
  *
@@ -44,12 +46,16 @@
  *   char* cvector__elem_m;
  *   size_t cvecor__size_m;
  *   size_t cvector__cap_m;
+ *   const cvector_allocator_t *cvector__allocator_m;
+ *   unsigned int cvector__flags_m;
  *   bool cvector__initialized_m;
  * } cvector_char_t;
  *
  * Here 'cvector__elem_m' [private] points to the actual buffer of data that holds value of type
  *'char'. 'cvector__size_m' [private] keeps track of size and 'cvector__cap_m' keeps track of
- *capacity. 'cvector__initialized_m' [private] is used to determine if the initial constructor is
+ *capacity. 'cvector__allocator_m' [private] is the allocator that owns the buffer (NULL for libc).
+ *'cvector__flags_m' [private] holds CVECTOR__FLAG_* bits describing where the buffer lives.
+ *'cvector__initialized_m' [private] is used to determine if the initial constructor is
  *called or not.
  *
  * Initial constructor is called using 'cvector__init(&vector_a)'. This is used to set initial cap
@@ -63,6 +69,294 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "cvector_stats.h"
+
+/*
+ * Allocator used by a vector to manage its buffer.
+ *
+ * Every vector carries a pointer to one of these. When the pointer is NULL (the default set by
+ * 'cvector__init' and 'cvector__init_with_cap') the vector goes through libc realloc/free.
+ * Callbacks receive 'ctx' as first argument, and 'realloc'/'free' are told the current size of
+ * the block in bytes so that arena or pool backends don't need to keep per-block headers.
+ *
+ * For example:
+ *
+ * static void *my_alloc(void *ctx, size_t size);
+ * static void *my_realloc(void *ctx, void *mem, size_t old_size, size_t new_size);
+ * static void my_free(void *ctx, void *mem, size_t size);
+ *
+ * cvector_allocator_t allocator;
+ * cvector_allocator__init(&allocator, my_alloc, my_realloc, my_free, &my_ctx);
+ *
+ * cvector__init_with_allocator(&vector_int, &allocator);
+ *
+ * See 'cvector_alloc.h' for ready made arena and pool backends.
+ */
+typedef struct cvector_allocator_t {
+  /* Allocates block of 'size' bytes. */
+  void *(*cvector_allocator__alloc_m)(void *ctx, size_t size);
+  /* Resizes block of 'old_size' bytes to 'new_size' bytes preserving its content. */
+  void *(*cvector_allocator__realloc_m)(void *ctx, void *mem, size_t old_size, size_t new_size);
+  /* Releases block of 'size' bytes. */
+  void (*cvector_allocator__free_m)(void *ctx, void *mem, size_t size);
+  /* User context passed to every callback. */
+  void *cvector_allocator__ctx_m;
+} cvector_allocator_t;
+
+/* PUBLIC: Initializes allocator with callbacks and context. */
+#define cvector_allocator__init(allocator, alloc, realloc, free, ctx)                              \
+  do {                                                                                             \
+    (allocator)->cvector_allocator__alloc_m = (alloc);                                             \
+    (allocator)->cvector_allocator__realloc_m = (realloc);                                         \
+    (allocator)->cvector_allocator__free_m = (free);                                               \
+    (allocator)->cvector_allocator__ctx_m = (ctx);                                                 \
+  } while (0)
+
+/* PRIVATE: Resizes 'mem' from 'old_size' to 'new_size' bytes through 'allocator' (libc if NULL). */
+static inline void *cvector__realloc_(const cvector_allocator_t *allocator, void *mem,
+                                      size_t old_size, size_t new_size) {
+  if (allocator == NULL) {
+    return realloc(mem, new_size);
+  }
+
+  if (mem == NULL) {
+    return allocator->cvector_allocator__alloc_m(allocator->cvector_allocator__ctx_m, new_size);
+  }
+
+  return allocator->cvector_allocator__realloc_m(allocator->cvector_allocator__ctx_m, mem,
+                                                 old_size, new_size);
+}
+
+/* PRIVATE: Releases 'mem' of 'size' bytes through 'allocator' (libc if NULL). */
+static inline void cvector__dealloc_(const cvector_allocator_t *allocator, void *mem, size_t size) {
+  if (allocator == NULL) {
+    free(mem);
+    return;
+  }
+
+  if (mem != NULL) {
+    allocator->cvector_allocator__free_m(allocator->cvector_allocator__ctx_m, mem, size);
+  }
+}
+
+/* PRIVATE: Buffer is the inline storage of a 'CVector_small' and must never be freed. */
+#define CVECTOR__FLAG_INLINE_ (1u << 0)
+/* PRIVATE: 'cvector__pop' and 'cvector__erase_range' never shrink the vector implicitly. */
+#define CVECTOR__FLAG_NOSHRINK_ (1u << 1)
+/* PRIVATE: Buffer is shared with other vectors (see 'cvector__share'). The vector's allocator
+ * pointer then points to the buffer's 'cvector_share_t' instead. */
+#define CVECTOR__FLAG_SHARED_ (1u << 2)
+
+/* Growth policies (see 'cvector__set_growth'). Stored in bits 4-5 of the vector's flags. */
+/* Cap doubles: 1, 2, 4, 8, ... (default) */
+#define CVECTOR__GROWTH_DOUBLE 0u
+/* Cap grows by half: 1, 2, 3, 4, 6, 9, 13, ... Less slack, more resizes. */
+#define CVECTOR__GROWTH_1_5X 1u
+/* Cap doubles and is rounded up so the buffer is a multiple of CVECTOR__PAGE_SIZE bytes. Elements
+ * whose size doesn't divide the page size round to lcm(elem_size, CVECTOR__PAGE_SIZE) bytes. */
+#define CVECTOR__GROWTH_PAGE 2u
+/* Cap grows by fixed step of CVECTOR__GROWTH_CHUNK_SIZE bytes. Bounded slack for huge vectors. */
+#define CVECTOR__GROWTH_CHUNK 3u
+
+/* PRIVATE: Position and mask of growth policy in flags. */
+#define CVECTOR__GROWTH_SHIFT_ 4
+#define CVECTOR__GROWTH_MASK_ (3u << CVECTOR__GROWTH_SHIFT_)
+
+/* Growth policy of vectors initialized by 'cvector__init' and friends. */
+#ifndef CVECTOR__DEFAULT_GROWTH
+#define CVECTOR__DEFAULT_GROWTH CVECTOR__GROWTH_DOUBLE
+#endif
+
+/* Page size used by CVECTOR__GROWTH_PAGE, a power of 2. */
+#ifndef CVECTOR__PAGE_SIZE
+#define CVECTOR__PAGE_SIZE 4096
+#endif
+
+/* Step used by CVECTOR__GROWTH_CHUNK. */
+#ifndef CVECTOR__GROWTH_CHUNK_SIZE
+#define CVECTOR__GROWTH_CHUNK_SIZE (64 * 1024 * 1024)
+#endif
+
+/* PRIVATE: Next cap for growth policy in 'flags' that fits at least 'min_cap' elements of
+ * 'elem_size' bytes, starting from current 'cap'. */
+static inline size_t cvector__grow_cap_(unsigned int flags, size_t elem_size, size_t cap,
+                                        size_t min_cap) {
+  switch ((flags & CVECTOR__GROWTH_MASK_) >> CVECTOR__GROWTH_SHIFT_) {
+  case CVECTOR__GROWTH_1_5X:
+    cap = (cap == 0) ? 1 : cap;
+    while (cap < min_cap) {
+      cap += (cap >> 1) + (cap == 1);
+    }
+    return cap;
+
+  case CVECTOR__GROWTH_PAGE: {
+    // Fewest elements filling whole pages: lcm(elem_size, page) / elem_size = page / gcd, and the
+    // gcd with a power of 2 is the lowest set bit of elem_size, at most the page itself.
+    size_t low_bit = elem_size & (~elem_size + 1);
+    size_t unit = (low_bit < CVECTOR__PAGE_SIZE) ? CVECTOR__PAGE_SIZE / low_bit : 1;
+    cap = (cap * 2 > min_cap) ? cap * 2 : min_cap;
+    return ((cap + unit - 1) / unit) * unit;
+  }
+
+  case CVECTOR__GROWTH_CHUNK: {
+    size_t step = CVECTOR__GROWTH_CHUNK_SIZE / elem_size;
+    step = (step == 0) ? 1 : step;
+    return cap + (((min_cap - cap) + step - 1) / step) * step;
+  }
+
+  default:
+    cap = (cap == 0) ? 1 : cap;
+    while (cap < min_cap) {
+      cap *= 2;
+    }
+    return cap;
+  }
+}
+
+/* PRIVATE: Reference count of a buffer shared by 'cvector__share'. */
+typedef struct {
+  /* Number of vectors sharing the buffer, updated atomically */
+  size_t cvector_share__refs_m;
+  /* Allocator that owns the buffer */
+  const cvector_allocator_t *cvector_share__allocator_m;
+  /* Cap of the buffer, in elements */
+  size_t cvector_share__cap_m;
+} cvector_share_t;
+
+/* PRIVATE: Returns share of a vector whose CVECTOR__FLAG_SHARED_ is set, from its allocator. */
+#define cvector__share_of_(allocator) ((cvector_share_t *)(void *)(allocator))
+
+/* PRIVATE: Drops reference of a vector to shared buffer '*mem' holding 'size' elements, and
+ * replaces it with a private buffer with the same elements and room for '*cap' of them. The last
+ * vector holding the buffer keeps it, and gets its cap back in '*cap'. Restores the vector's
+ * allocator.
+ * Returns -1 (error) if the private buffer can't be allocated, the vector then still shares it.
+ */
+static inline int cvector__unshare_buffer_(const cvector_allocator_t **allocator,
+                                           unsigned int *flags, void **mem, size_t elem_size,
+                                           size_t size, size_t *cap) {
+  cvector_share_t *share = cvector__share_of_(*allocator);
+  const cvector_allocator_t *owner = share->cvector_share__allocator_m;
+
+  // No other vector holds the buffer, and none can get it any more.
+  if (__atomic_load_n(&(share->cvector_share__refs_m), __ATOMIC_ACQUIRE) == 1) {
+    *allocator = owner;
+    (*flags) &= ~CVECTOR__FLAG_SHARED_;
+    *cap = share->cvector_share__cap_m;
+    free(share);
+    return 0;
+  }
+
+  // Copy before dropping the reference, the others may free the buffer right after.
+  void *copy = cvector__realloc_(owner, NULL, 0, elem_size * (*cap));
+  if ((copy == NULL) && (elem_size * (*cap) > 0)) {
+    return -1;
+  }
+  if (copy != NULL) {
+    memcpy(copy, *mem, elem_size * size);
+  }
+  *allocator = owner;
+  (*flags) &= ~CVECTOR__FLAG_SHARED_;
+  if (__atomic_sub_fetch(&(share->cvector_share__refs_m), 1, __ATOMIC_ACQ_REL) == 0) {
+    cvector__dealloc_(owner, *mem, elem_size * share->cvector_share__cap_m);
+    free(share);
+  }
+  *mem = copy;
+  return 0;
+}
+
+/* PRIVATE: Moves buffer '*mem' holding 'size' elements of 'elem_size' bytes from '*cap' to
+ * 'new_cap' elements, updating '*mem' and '*cap'. Inline buffers are spilled to the heap when
+ * they need to grow and stay inline otherwise. Shared buffers are copied into a private buffer
+ * of 'new_cap' elements (see 'cvector__share').
+ * Returns -1 (error) if memory can't be allocated. '*mem' and '*cap' then still describe a valid
+ * buffer holding the elements: the old one, unless a shared buffer was taken back.
+ */
+static inline int cvector__resize_buffer_(const cvector_allocator_t **allocator,
+                                          unsigned int *flags, void **mem, size_t elem_size,
+                                          size_t size, size_t *cap, size_t new_cap) {
+  if ((*flags) & CVECTOR__FLAG_SHARED_) {
+    size_t unshared_cap = new_cap;
+    if (cvector__unshare_buffer_(allocator, flags, mem, elem_size, size, &unshared_cap) != 0) {
+      return -1;
+    }
+    *cap = unshared_cap;
+    if (unshared_cap == new_cap) {
+      return 0;
+    }
+  }
+
+  if ((*flags) & CVECTOR__FLAG_INLINE_) {
+    if (new_cap <= *cap) {
+      return 0;
+    }
+
+    void *heap = cvector__realloc_(*allocator, NULL, 0, elem_size * new_cap);
+    if (heap == NULL) {
+      return -1;
+    }
+    memcpy(heap, *mem, elem_size * size);
+    (*flags) &= ~CVECTOR__FLAG_INLINE_;
+    *mem = heap;
+    *cap = new_cap;
+    return 0;
+  }
+
+  // realloc of 0 bytes may free the buffer and return NULL, release it explicitly instead.
+  if (elem_size * new_cap == 0) {
+    cvector__dealloc_(*allocator, *mem, elem_size * (*cap));
+    *mem = NULL;
+    *cap = new_cap;
+    return 0;
+  }
+
+  void *resized = cvector__realloc_(*allocator, *mem, elem_size * (*cap), elem_size * new_cap);
+  if (resized == NULL) {
+    return -1;
+  }
+  *mem = resized;
+  *cap = new_cap;
+  return 0;
+}
+
+/* PRIVATE: Releases buffer 'mem' of 'cap' elements of 'elem_size' bytes unless it is inline.
+ * Shared buffers are released by the last vector holding them. */
+static inline void cvector__release_buffer_(const cvector_allocator_t **allocator,
+                                            unsigned int *flags, void *mem, size_t elem_size,
+                                            size_t cap) {
+  if ((*flags) & CVECTOR__FLAG_SHARED_) {
+    cvector_share_t *share = cvector__share_of_(*allocator);
+    *allocator = share->cvector_share__allocator_m;
+    (*flags) &= ~CVECTOR__FLAG_SHARED_;
+    if (__atomic_sub_fetch(&(share->cvector_share__refs_m), 1, __ATOMIC_ACQ_REL) == 0) {
+      cvector__dealloc_(*allocator, mem, elem_size * share->cvector_share__cap_m);
+      free(share);
+    }
+    return;
+  }
+
+  if (!((*flags) & CVECTOR__FLAG_INLINE_)) {
+    cvector__dealloc_(*allocator, mem, elem_size * cap);
+  }
+}
+
+/* PRIVATE: Fields shared by every vector type, so that all vector macros work on each of them. */
+#define CVECTOR__FIELDS_(cvector__elem_type_)                                                      \
+  /* Pointer to buffer */                                                                          \
+  cvector__elem_type_ *cvector__elem_m;                                                            \
+  /* Size of Vector */                                                                             \
+  size_t cvector__size_m;                                                                          \
+  /* Cap of Vector */                                                                              \
+  size_t cvector__cap_m;                                                                           \
+  /* Allocator that owns the buffer (NULL for libc). */                                            \
+  const cvector_allocator_t *cvector__allocator_m;                                                 \
+  /* CVECTOR__FLAG_* bits. */                                                                      \
+  unsigned int cvector__flags_m;                                                                   \
+  /* Flag to check whether vector is initialized or not. */                                        \
+  bool cvector__initialized_m;                                                                     \
+  /* Counters, only with CVECTOR_STATS (see cvector_stats.h). */                                   \
+  CVECTOR_STATS__FIELDS_
+
 /*
  * Macro to create type by wrapping container type i.e cvector__elem_type_.
  * This is root API before operating on vector such as adding, removing, indexing, etc.
@@ -86,14 +380,36 @@
  */
 #define CVector(cvector__elem_type_)                                                               \
   typedef struct {                                                                                 \
-    /* Pointer to buffer */                                                                        \
-    cvector__elem_type_ *cvector__elem_m;                                                          \
-    /* Size of Vector */                                                                           \
-    size_t cvector__size_m;                                                                        \
-    /* Cap of Vector */                                                                            \
-    size_t cvector__cap_m;                                                                         \
-    /* Flag to check whether vector is initialized or not. */                                      \
-    bool cvector__initialized_m;                                                                   \
+    CVECTOR__FIELDS_(cvector__elem_type_)                                                          \
+  }
+
+/*
+ * Macro to create small vector type that keeps up to 'cvector__inline_cap_' elements inside the
+ * struct and spills to the heap only once it grows past that. Every vector API (add, index, pop,
+ * iterator, ...) works on it unchanged. Only initialization differs: use 'cvector__init_small'.
+ *
+ * For example:
+ *
+ * CVector_small(int, 16) cvector_small_int_t;
+ *
+ * int main() {
+ *   cvector_small_int_t cvector_small_int;
+ *   cvector__init_small(&cvector_small_int);
+ *
+ *   // No heap allocation up to 16 elements.
+ *   cvector__add(&cvector_small_int, 1);
+ *
+ *   cvector__free(&cvector_small_int);
+ * }
+ *
+ * NOTE: While elements are inline the buffer points into the struct itself, so the vector must
+ * not be copied or moved by value (pass it around by pointer).
+ */
+#define CVector_small(cvector__elem_type_, cvector__inline_cap_)                                   \
+  typedef struct {                                                                                 \
+    CVECTOR__FIELDS_(cvector__elem_type_)                                                          \
+    /* Inline storage used until the vector outgrows it */                                         \
+    cvector__elem_type_ cvector__inline_m[cvector__inline_cap_];                                   \
   }
 
 /* Size should be more than or equal to shrink the vector. We won't bother
@@ -110,6 +426,11 @@
 #define CVECTOR__LOAD_FACTOR 0.25
 #endif
 
+/* PRIVATE: CVECTOR__LOAD_FACTOR in 1/1024 units. Folded at compile time so that the shrink test
+ * is integer only: Size / Cap <= LF  <=>  Size * 1024 <= Cap * LF_Q10.
+ */
+#define CVECTOR__LOAD_FACTOR_Q10_ ((size_t)(CVECTOR__LOAD_FACTOR * 1024))
+
 /* PRIVATE: macro to access data buffer */
 #define cvector__elem_(vec) ((vec)->cvector__elem_m)
 /* PRIVATE: macro to set data buffer */
@@ -130,6 +451,16 @@
 /* PRIVATE: macro set set capacity to vector */
 #define cvector__setcap_(vec, cap) (cvector__cap_(vec) = (cap))
 
+/* PRIVATE: macro to access allocator */
+#define cvector__allocator_(vec) ((vec)->cvector__allocator_m)
+/* PRIVATE: macro to set allocator */
+#define cvector__set_allocator_(vec, allocator) (cvector__allocator_(vec) = (allocator))
+
+/* PRIVATE: macro to access CVECTOR__FLAG_* bits */
+#define cvector__flags_(vec) ((vec)->cvector__flags_m)
+/* PRIVATE: macro to set CVECTOR__FLAG_* bits */
+#define cvector__set_flags_(vec, flags) (cvector__flags_(vec) = (flags))
+
 /* PRIVATE: macro to access initialization flag */
 #define cvector__initialized_(vec) ((vec)->cvector__initialized_m)
 /* PRIVATE: macro to set initialzation flag */
@@ -155,9 +486,47 @@
     cvector__setcap_((vec), 0);                                                                    \
     cvector__setsize_((vec), 0);                                                                   \
     cvector__set_elem_((vec), (NULL));                                                             \
+    cvector__set_allocator_((vec), (NULL));                                                        \
+    cvector__set_flags_((vec), (CVECTOR__DEFAULT_GROWTH << CVECTOR__GROWTH_SHIFT_));               \
+    cvector__stats_init_(vec);                                                                     \
     cvector__set_initialized_((vec), true);                                                        \
   } while (0)
 
+/* PUBLIC: macro function to initialized vector whose buffer is managed by 'allocator'.
+ *   - Same as 'cvector__init' but every resize and free goes through 'allocator'.
+ *   - 'allocator' must outlive the vector.
+ *
+ *   USAGE:
+ *
+ *   cvector_arena_t arena;
+ *   cvector_arena__init(&arena, 4096);
+ *
+ *   cvector_int_t cvector_int;
+ *   cvector__init_with_allocator(&cvector_int, cvector_arena__allocator(&arena));
+ *
+ *   // No need to free the vector, resetting the arena releases it.
+ *   cvector_arena__reset(&arena);
+ */
+#define cvector__init_with_allocator(vec, allocator)                                               \
+  do {                                                                                             \
+    cvector__init(vec);                                                                            \
+    cvector__set_allocator_((vec), (allocator));                                                   \
+  } while (0)
+
+/* PUBLIC: macro function to initialized small vector (see 'CVector_small').
+ *   - It sets cap to the inline capacity.
+ *   - It sets size to 0.
+ *   - It sets buffer to the inline storage, so no heap allocation is made until cap is exceeded.
+ *   - Finally, it set initialization to `true`
+ */
+#define cvector__init_small(vec)                                                                   \
+  do {                                                                                             \
+    cvector__init(vec);                                                                            \
+    cvector__set_elem_((vec), ((vec)->cvector__inline_m));                                         \
+    cvector__setcap_((vec), (sizeof((vec)->cvector__inline_m) / cvector__elem_size_(vec)));        \
+    cvector__set_flags_((vec), (cvector__flags_(vec) | CVECTOR__FLAG_INLINE_));                    \
+  } while (0)
+
 /* PUBLIC: macro function to initialized vector with user defined capacity.
  *   - It sets cap to value passed by the user.
  *   - It sets size to 0.
@@ -183,42 +552,198 @@
     cvector__setsize_((vec), 0);                                                                   \
     cvector__setcap_((vec), 0);                                                                    \
     cvector__set_elem_((vec), (NULL));                                                             \
+    cvector__set_allocator_((vec), (NULL));                                                        \
+    cvector__set_flags_((vec), (CVECTOR__DEFAULT_GROWTH << CVECTOR__GROWTH_SHIFT_));               \
+    cvector__stats_init_(vec);                                                                     \
     cvector__resize_((vec), (cap));                                                                \
     cvector__set_initialized_((vec), true);                                                        \
   } while (0)
 
 /* PRIVATE: Resizes vector with new cap.
+ * Goes through the vector's allocator. With the default (libc) one it uses realloc, so the block
+ * is extended in place whenever the heap has room behind it and only copied when it must move.
+ * glibc serves large blocks (>= M_MMAP_THRESHOLD) from mmap and grows them with mremap, so huge
+ * buffers are remapped instead of copied and never resident twice. Inline buffers of small
+ * vectors are spilled to the heap here. If memory can't be allocated the vector keeps its buffer
+ * and cap, so callers check the cap afterwards.
  * INVARIANTS:
  *  Cap must be more than equal to current vector's size.
  */
 #define cvector__resize_(vec, cap)                                                                 \
   do {                                                                                             \
-    void *cvector__mem_m = malloc((cvector__elem_size_(vec)) * (cap));                             \
-    memcpy((cvector__mem_m), (cvector__elem_(vec)),                                                \
-           ((cvector__elem_size_(vec)) * (cvector__size(vec))));                                   \
-    free(cvector__elem_(vec));                                                                     \
-    cvector__set_elem_((vec), (cvector__mem_m));                                                   \
-    cvector__setcap_((vec), (cap));                                                                \
+    void *cvector__buffer_m = cvector__elem_(vec);                                                 \
+    size_t cvector__buffer_cap_m = cvector__cap_(vec);                                             \
+    if (cvector__resize_buffer_(&(cvector__allocator_(vec)), &(cvector__flags_(vec)),              \
+                                &cvector__buffer_m, (cvector__elem_size_(vec)),                    \
+                                (cvector__size(vec)), &cvector__buffer_cap_m, (cap)) == 0) {       \
+      cvector__stats_resize_((vec), cvector__buffer_m, cvector__buffer_cap_m);                     \
+    }                                                                                              \
+    cvector__set_elem_((vec), cvector__buffer_m);                                                  \
+    cvector__setcap_((vec), cvector__buffer_cap_m);                                                \
   } while (0)
 
 /* PUBLIC: Add element to vector.
  * Resizes vector if current size is more than equal to current's cap.
- * Cap grows by powers of 2.
+ * Cap grows according to vector's growth policy (by powers of 2 by default).
+ * The element is dropped if memory can't be allocated.
  */
 #define cvector__add(vec, val)                                                                     \
   do {                                                                                             \
     if (cvector__size(vec) >= cvector__cap_(vec)) {                                                \
-      cvector__resize_((vec), ((cvector__cap_(vec) == 0) ? 1 : ((cvector__cap_(vec)) * 2)));       \
+      cvector__grow_((vec), (cvector__size(vec) + 1));                                             \
+    }                                                                                              \
+    if (cvector__size(vec) < cvector__cap_(vec)) {                                                 \
+      (((cvector__elem_(vec))[cvector__size(vec)]) = (val));                                       \
+      cvector__setsize_((vec), (cvector__size(vec) + 1));                                          \
+      cvector__stats_add_((vec), 1);                                                               \
+    }                                                                                              \
+  } while (0)
+
+/* PRIVATE: Makes room for at least 'min_cap' elements with at most one resize.
+ * New cap follows the vector's growth policy. */
+#define cvector__grow_(vec, min_cap)                                                               \
+  do {                                                                                             \
+    size_t cvector__min_cap_m = (min_cap);                                                         \
+    if (cvector__min_cap_m > cvector__cap_(vec)) {                                                 \
+      size_t cvector__new_cap_m =                                                                  \
+          cvector__grow_cap_((cvector__flags_(vec)), (cvector__elem_size_(vec)),                   \
+                             (cvector__cap_(vec)), cvector__min_cap_m);                            \
+      cvector__resize_((vec), cvector__new_cap_m);                                                 \
+    }                                                                                              \
+  } while (0)
+
+/* PUBLIC: Makes room for at least 'cap' elements so that no resize happens until size exceeds it.
+ * Allocates exactly 'cap' elements. Does nothing if vector's cap is already big enough.
+ */
+#define cvector__reserve(vec, cap)                                                                 \
+  do {                                                                                             \
+    size_t cvector__min_cap_m = (cap);                                                             \
+    if (cvector__min_cap_m > cvector__cap_(vec)) {                                                 \
+      cvector__resize_((vec), cvector__min_cap_m);                                                 \
+    }                                                                                              \
+  } while (0)
+
+/* PUBLIC: Shrinks cap down to size, giving unused memory back. An empty vector releases its buffer.
+ * Inline buffers of small vectors are left alone.
+ */
+#define cvector__shrink_to_fit(vec)                                                                \
+  do {                                                                                             \
+    if ((cvector__size(vec) < cvector__cap_(vec)) &&                                               \
+        !(cvector__flags_(vec) & CVECTOR__FLAG_INLINE_)) {                                         \
+      if (cvector__size(vec) == 0) {                                                               \
+        cvector__free(vec);                                                                        \
+        cvector__setcap_((vec), 0);                                                                \
+      } else {                                                                                     \
+        cvector__resize_((vec), (cvector__size(vec)));                                             \
+      }                                                                                            \
     }                                                                                              \
-    (((cvector__elem_(vec))[cvector__size(vec)]) = (val));                                         \
-    cvector__setsize_((vec), (cvector__size(vec) + 1));                                            \
   } while (0)
 
-/* PUBLIC: Set element to vector at index.
- * Returns -1 (error) if element is not set because index is out of bound.
+/* PUBLIC: Sets growth policy of vector to one of CVECTOR__GROWTH_*. Applies to later growth. */
+#define cvector__set_growth(vec, policy)                                                           \
+  (cvector__set_flags_((vec), ((cvector__flags_(vec) & ~CVECTOR__GROWTH_MASK_) |                   \
+                               (((unsigned int)(policy)) << CVECTOR__GROWTH_SHIFT_))))
+
+/* PUBLIC: Turns implicit shrinking in 'cvector__pop' / 'cvector__erase_range' on (true) or off
+ * (false). Turn it off for workloads that fill and drain in cycles. It is on by default.
+ */
+#define cvector__set_shrink(vec, enabled)                                                          \
+  (cvector__set_flags_((vec), ((enabled) ? (cvector__flags_(vec) & ~CVECTOR__FLAG_NOSHRINK_)       \
+                                         : (cvector__flags_(vec) | CVECTOR__FLAG_NOSHRINK_))))
+
+/* PUBLIC: Appends 'n' elements copied from array 'values' (pointer to elements).
+ * Does at most one resize and one memcpy, no matter how big 'n' is.
+ * Nothing is added if memory can't be allocated.
+ * NOTE: 'values' must not point into the vector's own buffer (use 'cvector__extend' for that).
+ */
+#define cvector__add_n(vec, values, n)                                                             \
+  do {                                                                                             \
+    size_t cvector__count_m = (n);                                                                 \
+    if (cvector__count_m > 0) {                                                                    \
+      cvector__grow_((vec), (cvector__size(vec) + cvector__count_m));                              \
+    }                                                                                              \
+    if ((cvector__count_m > 0) && (cvector__count_m <= cvector__cap_(vec) - cvector__size(vec))) { \
+      memcpy(((cvector__elem_(vec)) + cvector__size(vec)), (values),                               \
+             (cvector__elem_size_(vec) * cvector__count_m));                                       \
+      cvector__setsize_((vec), (cvector__size(vec) + cvector__count_m));                           \
+      cvector__stats_add_((vec), cvector__count_m);                                                \
+    }                                                                                              \
+  } while (0)
+
+/* PUBLIC: Alias of 'cvector__add_n'. */
+#define cvector__extend_from(vec, values, n) cvector__add_n((vec), (values), (n))
+
+/* PUBLIC: Appends every element of vector 'other' (of the same type) to 'vec'.
+ * 'other' may be 'vec' itself, in which case the vector is doubled. */
+#define cvector__extend(vec, other)                                                                \
+  cvector__add_n((vec), (cvector__elem_(other)), (cvector__size(other)))
+
+/* PUBLIC: Inserts 'n' elements copied from array 'values' before element at 'index'.
+ * Elements from 'index' onwards are shifted with a single memmove after at most one resize.
+ * Returns -1 (error) if nothing is inserted because index is out of bound (index > size) or
+ * memory can't be allocated.
+ * NOTE: 'values' must not point into the vector's own buffer.
+ */
+#define cvector__insert_range(vec, index, values, n)                                               \
+  ({                                                                                               \
+    size_t cvector__at_m = (index);                                                                \
+    size_t cvector__count_m = (n);                                                                 \
+    int cvector__result_m = -1;                                                                    \
+    if (cvector__at_m <= cvector__size(vec)) {                                                     \
+      if (cvector__count_m > 0) {                                                                  \
+        cvector__grow_((vec), (cvector__size(vec) + cvector__count_m));                            \
+      }                                                                                            \
+      if (cvector__count_m <= cvector__cap_(vec) - cvector__size(vec)) {                           \
+        if (cvector__count_m > 0) {                                                                \
+          memmove(((cvector__elem_(vec)) + cvector__at_m + cvector__count_m),                      \
+                  ((cvector__elem_(vec)) + cvector__at_m),                                         \
+                  (cvector__elem_size_(vec) * (cvector__size(vec) - cvector__at_m)));              \
+          memcpy(((cvector__elem_(vec)) + cvector__at_m), (values),                                \
+                 (cvector__elem_size_(vec) * cvector__count_m));                                   \
+          cvector__setsize_((vec), (cvector__size(vec) + cvector__count_m));                       \
+          cvector__stats_add_((vec), cvector__count_m);                                            \
+        }                                                                                          \
+        cvector__result_m = 0;                                                                     \
+      }                                                                                            \
+    }                                                                                              \
+    cvector__result_m;                                                                             \
+  })
+
+/* PUBLIC: Removes 'n' elements starting at 'index', shifting the tail with a single memmove.
+ * Like 'cvector__pop' it may shrink the vector afterwards.
+ * Returns -1 (error) if nothing is removed because range is out of bound (index + n > size) or
+ * a shared buffer can't be copied.
+ */
+#define cvector__erase_range(vec, index, n)                                                        \
+  ({                                                                                               \
+    size_t cvector__at_m = (index);                                                                \
+    size_t cvector__count_m = (n);                                                                 \
+    int cvector__result_m = -1;                                                                    \
+    if ((cvector__at_m <= cvector__size(vec)) &&                                                   \
+        (cvector__count_m <= cvector__size(vec) - cvector__at_m)) {                                \
+      if (cvector__count_m == 0) {                                                                 \
+        cvector__result_m = 0;                                                                     \
+      } else if (cvector__unshare(vec) == 0) {                                                     \
+        memmove(((cvector__elem_(vec)) + cvector__at_m),                                           \
+                ((cvector__elem_(vec)) + cvector__at_m + cvector__count_m),                        \
+                (cvector__elem_size_(vec) *                                                        \
+                 (cvector__size(vec) - cvector__at_m - cvector__count_m)));                        \
+        cvector__setsize_((vec), (cvector__size(vec) - cvector__count_m));                         \
+        cvector__shrink_(vec);                                                                     \
+        cvector__result_m = 0;                                                                     \
+      }                                                                                            \
+    }                                                                                              \
+    cvector__result_m;                                                                             \
+  })
+
+/* PUBLIC: Set element to vector at index. A shared buffer is copied first (see 'cvector__share').
+ * Returns -1 (error) if element is not set because index is out of bound or a shared buffer can't
+ * be copied.
  */
 #define cvector__set_at_index(vec, index, val)                                                     \
-  (((index) < cvector__size(vec)) ? (((cvector__elem_(vec))[(index)]) = (val), 0) : -1)
+  ((((index) < cvector__size(vec)) && (cvector__unshare(vec) == 0))                                \
+       ? (((cvector__elem_(vec))[(index)]) = (val), 0)                                             \
+       : -1)
 
 /* PUBLIC: Returns element at given index. */
 #define cvector__index(vec, index) (((cvector__elem_(vec))[(index)]))
@@ -229,19 +754,110 @@
 /* PUBLIC: Frees the vector and sets buffer to NULL. */
 #define cvector__free(vec)                                                                         \
   do {                                                                                             \
-    free(cvector__elem_(vec));                                                                     \
+    cvector__stats_release_(vec);                                                                  \
+    cvector__release_buffer_(&(cvector__allocator_(vec)), &(cvector__flags_(vec)),                 \
+                             (cvector__elem_(vec)), (cvector__elem_size_(vec)),                    \
+                             (cvector__cap_(vec)));                                                \
     cvector__set_elem_((vec), NULL);                                                               \
   } while (0)
 
+/* PUBLIC: Makes 'dst' hold the same elements as 'src' (a vector of the same type) without copying
+ * them: both vectors share the buffer, and the first one to write to it copies it privately
+ * (copy on write). 'dst' must not hold a buffer, it is initialized here. Both must be freed.
+ *   - Sharing is O(1): the buffer gets a reference count and both caps are set to size, so the
+ *     next 'cvector__add' (or 'add_n', 'insert_range', ...) takes the growth path, which copies.
+ *   - 'cvector__set_at_index' and 'cvector__erase_range' copy before writing. 'cvector__pop'
+ *     only lowers the cap of the popping vector and copies nothing.
+ *   - The last vector holding the buffer gets it back without a copy.
+ *   - Vectors sharing a buffer may be used from different threads, the count is atomic.
+ * Inline buffers of small vectors are copied right away.
+ * Returns -1 (error) if the buffer can't be shared, 'dst' is then empty.
+ *
+ *   USAGE:
+ *
+ *   cvector_int_t reader;
+ *   cvector__share(&reader, &vector_int);    // no copy
+ *   cvector__add(&reader, 42);               // 'reader' copies, 'vector_int' is unchanged
+ *
+ *   cvector__free(&reader);
+ *   cvector__free(&vector_int);
+ *
+ * NOTE: Writes through pointers ('cvector__index_ref', 'cvector_iterator__next_ref', ...) don't
+ * copy, call 'cvector__unshare' before writing through them.
+ */
+#define cvector__share(dst, src)                                                                   \
+  ({                                                                                               \
+    int cvector__result_m = 0;                                                                     \
+    if ((cvector__elem_(src) != NULL) && !(cvector__flags_(src) & CVECTOR__FLAG_INLINE_) &&        \
+        !(cvector__flags_(src) & CVECTOR__FLAG_SHARED_)) {                                         \
+      cvector_share_t *cvector__share_m = malloc(sizeof(cvector_share_t));                         \
+      if (cvector__share_m != NULL) {                                                              \
+        cvector__share_m->cvector_share__refs_m = 1;                                               \
+        cvector__share_m->cvector_share__allocator_m = cvector__allocator_(src);                   \
+        cvector__share_m->cvector_share__cap_m = cvector__cap_(src);                               \
+        cvector__set_allocator_((src), (const cvector_allocator_t *)(void *)cvector__share_m);     \
+        cvector__set_flags_((src), (cvector__flags_(src) | CVECTOR__FLAG_SHARED_));                \
+        cvector__setcap_((src), cvector__size(src));                                               \
+      }                                                                                            \
+    }                                                                                              \
+    if (cvector__flags_(src) & CVECTOR__FLAG_SHARED_) {                                            \
+      __atomic_add_fetch(&(cvector__share_of_(cvector__allocator_(src))->cvector_share__refs_m),   \
+                         1, __ATOMIC_RELAXED);                                                     \
+      cvector__init(dst);                                                                          \
+      cvector__set_elem_((dst), cvector__elem_(src));                                              \
+      cvector__setsize_((dst), cvector__size(src));                                                \
+      cvector__setcap_((dst), cvector__size(src));                                                 \
+      cvector__set_allocator_((dst), cvector__allocator_(src));                                    \
+      cvector__set_flags_((dst), cvector__flags_(src));                                            \
+    } else if (cvector__flags_(src) & CVECTOR__FLAG_INLINE_) {                                     \
+      cvector__init_with_allocator((dst), cvector__allocator_(src));                               \
+      cvector__add_n((dst), cvector__elem_(src), cvector__size(src));                              \
+    } else {                                                                                       \
+      cvector__init_with_allocator((dst), cvector__allocator_(src));                               \
+      cvector__result_m = (cvector__elem_(src) != NULL) ? -1 : 0;                                  \
+    }                                                                                              \
+    cvector__result_m;                                                                             \
+  })
+
+/* PUBLIC: Returns whether vector's buffer is shared (see 'cvector__share'). */
+#define cvector__shared(vec) ((bool)(cvector__flags_(vec) & CVECTOR__FLAG_SHARED_))
+
+/* PUBLIC: Gives vector a private copy of its buffer if it is shared, so that it can be written
+ * through pointers. The last vector holding a shared buffer takes it over without a copy.
+ * Returns -1 (error) if the copy can't be allocated, the buffer is then still shared. */
+#define cvector__unshare(vec)                                                                      \
+  ({                                                                                               \
+    int cvector__result_m = 0;                                                                     \
+    if (cvector__flags_(vec) & CVECTOR__FLAG_SHARED_) {                                            \
+      void *cvector__buffer_m = cvector__elem_(vec);                                               \
+      cvector__result_m = cvector__unshare_buffer_(                                                \
+          &(cvector__allocator_(vec)), &(cvector__flags_(vec)), &cvector__buffer_m,                \
+          cvector__elem_size_(vec), cvector__size(vec), &(cvector__cap_(vec)));                    \
+      cvector__set_elem_((vec), cvector__buffer_m);                                                \
+    }                                                                                              \
+    cvector__result_m;                                                                             \
+  })
+
+/* PRIVATE: Shared vectors keep cap equal to size, so that no add can write to the shared buffer
+ * without going through 'cvector__grow_'. */
+#define cvector__share_trim_(vec)                                                                  \
+  do {                                                                                             \
+    if (cvector__flags_(vec) & CVECTOR__FLAG_SHARED_) {                                            \
+      cvector__setcap_((vec), cvector__size(vec));                                                 \
+    }                                                                                              \
+  } while (0)
+
 /* PRIVATE: Shrinks the vector is Load Factor is less than CVECTOR__LOAD_FACTOR.
  * Also, resize happens only when Size is >= CVECTOR__MIN_SHRINK_SIZE.
+ * Inline buffers of small vectors and vectors with shrinking turned off are never shrunk.
+ * The load factor test is integer only (shifts for the default 0.25) and is checked first, so
+ * the common case costs one compare. An empty vector (Cap = 0) never passes the size test.
  */
 #define cvector__shrink_(vec)                                                                      \
   do {                                                                                             \
-    double cvector__current_load_factor =                                                          \
-        (((double)cvector__size(vec)) / ((double)cvector__cap_(vec)));                             \
-    if ((cvector__current_load_factor <= CVECTOR__LOAD_FACTOR) &&                                  \
-        (cvector__size(vec) >= CVECTOR__MIN_SHRINK_SIZE)) {                                        \
+    if (((cvector__size(vec) << 10) <= (cvector__cap_(vec) * CVECTOR__LOAD_FACTOR_Q10_)) &&        \
+        (cvector__size(vec) >= CVECTOR__MIN_SHRINK_SIZE) &&                                        \
+        !(cvector__flags_(vec) & (CVECTOR__FLAG_INLINE_ | CVECTOR__FLAG_NOSHRINK_))) {             \
       cvector__resize_((vec), (cvector__size(vec) * 2));                                           \
     }                                                                                              \
   } while (0)
@@ -251,6 +867,15 @@
   ({                                                                                               \
     cvector__shrink_(vec);                                                                         \
     cvector__setsize_((vec), (cvector__size(vec) - 1));                                            \
+    cvector__share_trim_(vec);                                                                     \
+    (cvector__index((vec), cvector__size(vec)));                                                   \
+  })
+
+/* PUBLIC: Pops the element from the last index in the vector without ever shrinking it. */
+#define cvector__pop_noshrink(vec)                                                                 \
+  ({                                                                                               \
+    cvector__setsize_((vec), (cvector__size(vec) - 1));                                            \
+    cvector__share_trim_(vec);                                                                     \
     (cvector__index((vec), cvector__size(vec)));                                                   \
   })
 
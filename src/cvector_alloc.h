@@ -0,0 +1,339 @@
+/*
+ * Allocator backends for cvector.
+ *
+ * Every 'CVector(T)' can be bound to a 'cvector_allocator_t' with 'cvector__init_with_allocator'.
+ * This header ships two backends built on that interface.
+ *
+ * Arena ('cvector_arena_t'): bump allocator made of chunks. Growing the most recent block is done
+ * in place, individual frees are (almost) no-ops and 'cvector_arena__reset' releases everything
+ * allocated from the arena at once. Ideal for per-request scratch vectors.
+ *
+ *   cvector_arena_t arena;
+ *   cvector_arena__init(&arena, 64 * 1024);
+ *
+ *   cvector_int_t scratch;
+ *   cvector__init_with_allocator(&scratch, cvector_arena__allocator(&arena));
+ *   ...
+ *   cvector_arena__reset(&arena);   // scratch is gone, no cvector__free needed
+ *   cvector_arena__destroy(&arena);
+ *
+ * Pool ('cvector_pool_t'): power of two size classes from CVECTOR_POOL__MIN_CLASS to
+ * CVECTOR_POOL__MAX_CLASS bytes, each with its own free list carved out of slabs. Freed blocks
+ * are recycled without touching the global heap. Bigger blocks fall through to libc.
+ *
+ *   cvector_pool_t pool;
+ *   cvector_pool__init(&pool);
+ *
+ *   cvector_int_t vector_int;
+ *   cvector__init_with_allocator(&vector_int, cvector_pool__allocator(&pool));
+ *   ...
+ *   cvector__free(&vector_int);
+ *   cvector_pool__destroy(&pool);
+ *
+ * NOTE: Neither backend is synchronized. Keep one per thread (or per request) which is exactly
+ * what takes the global allocator lock out of the hot path.
+ */
+
+#ifndef cvector_alloc_h
+#define cvector_alloc_h
+
+#include "cvector.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Alignment of every block handed out by the arena and the pool. */
+#define CVECTOR_ALLOC__ALIGN (_Alignof(max_align_t))
+
+/* PRIVATE: Rounds 'size' up to multiple of CVECTOR_ALLOC__ALIGN. */
+#define cvector_alloc__align_(size)                                                                \
+  (((size) + (CVECTOR_ALLOC__ALIGN - 1)) & ~((size_t)CVECTOR_ALLOC__ALIGN - 1))
+
+/* PRIVATE: Header of chunk of memory owned by arena. Data follows the (aligned) header. */
+typedef struct cvector_arena_chunk_t {
+  /* Previously filled chunk. */
+  struct cvector_arena_chunk_t *cvector_arena_chunk__prev_m;
+  /* Bytes available after header. */
+  size_t cvector_arena_chunk__cap_m;
+} cvector_arena_chunk_t;
+
+/* PRIVATE: Size of chunk header including padding up to alignment. */
+#define cvector_arena__header_size_ (cvector_alloc__align_(sizeof(cvector_arena_chunk_t)))
+
+/* PRIVATE: Start of data of chunk. */
+#define cvector_arena__chunk_data_(chunk) (((char *)(chunk)) + cvector_arena__header_size_)
+
+typedef struct {
+  /* Chunk that is currently bumped. */
+  cvector_arena_chunk_t *cvector_arena__chunk_m;
+  /* Bytes used in current chunk. */
+  size_t cvector_arena__used_m;
+  /* Minimum size of new chunk. */
+  size_t cvector_arena__chunk_size_m;
+  /* Last block handed out, the only one that can be grown or released in place. */
+  char *cvector_arena__last_m;
+  /* Interface handed to vectors. */
+  cvector_allocator_t cvector_arena__allocator_m;
+} cvector_arena_t;
+
+/* PRIVATE: Starts new chunk able to hold at least 'size' bytes. */
+static inline bool cvector_arena__new_chunk_(cvector_arena_t *arena, size_t size) {
+  size_t cap = arena->cvector_arena__chunk_size_m;
+  if (size > cap) {
+    cap = size;
+  }
+
+  cvector_arena_chunk_t *chunk = malloc(cvector_arena__header_size_ + cap);
+  if (chunk == NULL) {
+    return false;
+  }
+
+  chunk->cvector_arena_chunk__prev_m = arena->cvector_arena__chunk_m;
+  chunk->cvector_arena_chunk__cap_m = cap;
+  arena->cvector_arena__chunk_m = chunk;
+  arena->cvector_arena__used_m = 0;
+  arena->cvector_arena__last_m = NULL;
+  return true;
+}
+
+/* PRIVATE: Bumps 'size' bytes. */
+static inline void *cvector_arena__alloc_(void *ctx, size_t size) {
+  cvector_arena_t *arena = ctx;
+  size = cvector_alloc__align_(size);
+
+  cvector_arena_chunk_t *chunk = arena->cvector_arena__chunk_m;
+  if ((chunk == NULL) ||
+      ((chunk->cvector_arena_chunk__cap_m - arena->cvector_arena__used_m) < size)) {
+    if (!cvector_arena__new_chunk_(arena, size)) {
+      return NULL;
+    }
+    chunk = arena->cvector_arena__chunk_m;
+  }
+
+  char *mem = cvector_arena__chunk_data_(chunk) + arena->cvector_arena__used_m;
+  arena->cvector_arena__used_m += size;
+  arena->cvector_arena__last_m = mem;
+  return mem;
+}
+
+/* PRIVATE: Grows last block in place when the chunk has room, otherwise bumps and copies. */
+static inline void *cvector_arena__realloc_(void *ctx, void *mem, size_t old_size,
+                                            size_t new_size) {
+  cvector_arena_t *arena = ctx;
+
+  if (mem == arena->cvector_arena__last_m) {
+    cvector_arena_chunk_t *chunk = arena->cvector_arena__chunk_m;
+    size_t offset = (size_t)((char *)mem - cvector_arena__chunk_data_(chunk));
+    if (cvector_alloc__align_(new_size) <= chunk->cvector_arena_chunk__cap_m - offset) {
+      arena->cvector_arena__used_m = offset + cvector_alloc__align_(new_size);
+      return mem;
+    }
+  }
+
+  void *new_mem = cvector_arena__alloc_(ctx, new_size);
+  if (new_mem != NULL) {
+    memcpy(new_mem, mem, (old_size < new_size) ? old_size : new_size);
+  }
+  return new_mem;
+}
+
+/* PRIVATE: Gives back last block, anything else waits for reset. */
+static inline void cvector_arena__free_(void *ctx, void *mem, size_t size) {
+  cvector_arena_t *arena = ctx;
+  (void)size;
+
+  if (mem == arena->cvector_arena__last_m) {
+    arena->cvector_arena__used_m =
+        (size_t)((char *)mem - cvector_arena__chunk_data_(arena->cvector_arena__chunk_m));
+    arena->cvector_arena__last_m = NULL;
+  }
+}
+
+/* PUBLIC: Initializes arena. Chunks are allocated lazily and hold at least 'chunk_size' bytes. */
+#define cvector_arena__init(arena, chunk_size)                                                     \
+  do {                                                                                             \
+    (arena)->cvector_arena__chunk_m = NULL;                                                        \
+    (arena)->cvector_arena__used_m = 0;                                                            \
+    (arena)->cvector_arena__chunk_size_m = (chunk_size);                                           \
+    (arena)->cvector_arena__last_m = NULL;                                                         \
+    cvector_allocator__init(&((arena)->cvector_arena__allocator_m), cvector_arena__alloc_,         \
+                            cvector_arena__realloc_, cvector_arena__free_, (arena));               \
+  } while (0)
+
+/* PUBLIC: Returns allocator to pass to 'cvector__init_with_allocator'. */
+#define cvector_arena__allocator(arena) (&((arena)->cvector_arena__allocator_m))
+
+/* PUBLIC: Releases every block handed out by the arena. Keeps the current chunk for reuse.
+ * Vectors bound to the arena must not be used after reset (re-init them instead). */
+static inline void cvector_arena__reset(cvector_arena_t *arena) {
+  cvector_arena_chunk_t *chunk = arena->cvector_arena__chunk_m;
+  if (chunk != NULL) {
+    cvector_arena_chunk_t *prev = chunk->cvector_arena_chunk__prev_m;
+    while (prev != NULL) {
+      cvector_arena_chunk_t *next = prev->cvector_arena_chunk__prev_m;
+      free(prev);
+      prev = next;
+    }
+    chunk->cvector_arena_chunk__prev_m = NULL;
+  }
+
+  arena->cvector_arena__used_m = 0;
+  arena->cvector_arena__last_m = NULL;
+}
+
+/* PUBLIC: Releases all memory owned by arena. */
+static inline void cvector_arena__destroy(cvector_arena_t *arena) {
+  cvector_arena__reset(arena);
+  free(arena->cvector_arena__chunk_m);
+  arena->cvector_arena__chunk_m = NULL;
+}
+
+/* Smallest size class of pool (must be power of 2). */
+#ifndef CVECTOR_POOL__MIN_CLASS
+#define CVECTOR_POOL__MIN_CLASS 16
+#endif
+
+/* Biggest size class of pool (must be power of 2). Bigger blocks go to libc. */
+#ifndef CVECTOR_POOL__MAX_CLASS
+#define CVECTOR_POOL__MAX_CLASS (64 * 1024)
+#endif
+
+/* Bytes carved at once when free list of a size class runs dry. */
+#ifndef CVECTOR_POOL__SLAB_SIZE
+#define CVECTOR_POOL__SLAB_SIZE (64 * 1024)
+#endif
+
+/* PRIVATE: Number of size classes between CVECTOR_POOL__MIN_CLASS and CVECTOR_POOL__MAX_CLASS. */
+#define cvector_pool__classes_                                                                     \
+  ((size_t)(__builtin_ctzll(CVECTOR_POOL__MAX_CLASS) - __builtin_ctzll(CVECTOR_POOL__MIN_CLASS) +  \
+            1))
+
+/* PRIVATE: Free block of pool. The link lives inside the block itself. */
+typedef struct cvector_pool_block_t {
+  struct cvector_pool_block_t *cvector_pool_block__next_m;
+} cvector_pool_block_t;
+
+typedef struct {
+  /* Free list per size class. */
+  cvector_pool_block_t *cvector_pool__free_m[cvector_pool__classes_];
+  /* Slabs allocated so far, chained through their first bytes. */
+  cvector_pool_block_t *cvector_pool__slabs_m;
+  /* Interface handed to vectors. */
+  cvector_allocator_t cvector_pool__allocator_m;
+} cvector_pool_t;
+
+/* PRIVATE: Size class index serving 'size' bytes (size <= CVECTOR_POOL__MAX_CLASS). */
+static inline size_t cvector_pool__class_(size_t size) {
+  if (size <= CVECTOR_POOL__MIN_CLASS) {
+    return 0;
+  }
+  return (size_t)((64 - __builtin_clzll((unsigned long long)(size - 1))) -
+                  __builtin_ctzll(CVECTOR_POOL__MIN_CLASS));
+}
+
+/* PRIVATE: Byte size of size class. */
+#define cvector_pool__class_size_(index) (((size_t)CVECTOR_POOL__MIN_CLASS) << (index))
+
+/* PRIVATE: Refills free list of size class from new slab. */
+static inline bool cvector_pool__refill_(cvector_pool_t *pool, size_t index) {
+  size_t class_size = cvector_pool__class_size_(index);
+  size_t count = CVECTOR_POOL__SLAB_SIZE / class_size;
+  if (count == 0) {
+    count = 1;
+  }
+
+  size_t header = cvector_alloc__align_(sizeof(cvector_pool_block_t));
+  char *slab = malloc(header + count * class_size);
+  if (slab == NULL) {
+    return false;
+  }
+
+  ((cvector_pool_block_t *)slab)->cvector_pool_block__next_m = pool->cvector_pool__slabs_m;
+  pool->cvector_pool__slabs_m = (cvector_pool_block_t *)slab;
+
+  for (size_t i = count; i > 0; i--) {
+    cvector_pool_block_t *block = (cvector_pool_block_t *)(slab + header + (i - 1) * class_size);
+    block->cvector_pool_block__next_m = pool->cvector_pool__free_m[index];
+    pool->cvector_pool__free_m[index] = block;
+  }
+  return true;
+}
+
+/* PRIVATE: Pops block from free list of matching size class. */
+static inline void *cvector_pool__alloc_(void *ctx, size_t size) {
+  cvector_pool_t *pool = ctx;
+  if (size > CVECTOR_POOL__MAX_CLASS) {
+    return malloc(size);
+  }
+
+  size_t index = cvector_pool__class_(size);
+  if ((pool->cvector_pool__free_m[index] == NULL) && !cvector_pool__refill_(pool, index)) {
+    return NULL;
+  }
+
+  cvector_pool_block_t *block = pool->cvector_pool__free_m[index];
+  pool->cvector_pool__free_m[index] = block->cvector_pool_block__next_m;
+  return block;
+}
+
+/* PRIVATE: Pushes block back to free list of matching size class. */
+static inline void cvector_pool__free_(void *ctx, void *mem, size_t size) {
+  cvector_pool_t *pool = ctx;
+  if (size > CVECTOR_POOL__MAX_CLASS) {
+    free(mem);
+    return;
+  }
+
+  size_t index = cvector_pool__class_(size);
+  cvector_pool_block_t *block = mem;
+  block->cvector_pool_block__next_m = pool->cvector_pool__free_m[index];
+  pool->cvector_pool__free_m[index] = block;
+}
+
+/* PRIVATE: Keeps block when new size maps to the same size class, otherwise moves it. */
+static inline void *cvector_pool__realloc_(void *ctx, void *mem, size_t old_size,
+                                           size_t new_size) {
+  if ((old_size > CVECTOR_POOL__MAX_CLASS) && (new_size > CVECTOR_POOL__MAX_CLASS)) {
+    return realloc(mem, new_size);
+  }
+
+  if ((old_size <= CVECTOR_POOL__MAX_CLASS) && (new_size <= CVECTOR_POOL__MAX_CLASS) &&
+      (cvector_pool__class_(old_size) == cvector_pool__class_(new_size))) {
+    return mem;
+  }
+
+  void *new_mem = cvector_pool__alloc_(ctx, new_size);
+  if (new_mem != NULL) {
+    memcpy(new_mem, mem, (old_size < new_size) ? old_size : new_size);
+    cvector_pool__free_(ctx, mem, old_size);
+  }
+  return new_mem;
+}
+
+/* PUBLIC: Initializes pool with empty free lists. */
+#define cvector_pool__init(pool)                                                                   \
+  do {                                                                                             \
+    memset((pool)->cvector_pool__free_m, 0, sizeof((pool)->cvector_pool__free_m));                 \
+    (pool)->cvector_pool__slabs_m = NULL;                                                          \
+    cvector_allocator__init(&((pool)->cvector_pool__allocator_m), cvector_pool__alloc_,            \
+                            cvector_pool__realloc_, cvector_pool__free_, (pool));                  \
+  } while (0)
+
+/* PUBLIC: Returns allocator to pass to 'cvector__init_with_allocator'. */
+#define cvector_pool__allocator(pool) (&((pool)->cvector_pool__allocator_m))
+
+/* PUBLIC: Releases all slabs owned by pool. Blocks bigger than CVECTOR_POOL__MAX_CLASS are owned
+ * by libc and must be released with 'cvector__free' before. */
+static inline void cvector_pool__destroy(cvector_pool_t *pool) {
+  cvector_pool_block_t *slab = pool->cvector_pool__slabs_m;
+  while (slab != NULL) {
+    cvector_pool_block_t *next = slab->cvector_pool_block__next_m;
+    free(slab);
+    slab = next;
+  }
+
+  memset(pool->cvector_pool__free_m, 0, sizeof(pool->cvector_pool__free_m));
+  pool->cvector_pool__slabs_m = NULL;
+}
+
+#endif /* cvector_alloc_h */
@@ -0,0 +1,365 @@
+/*
+ * Bit vectors for cvector.
+ *
+ * 'CVector(bool)' spends a byte per flag. 'CVector_bits' packs 64 flags per 'uint64_t' word, 8
+ * times less memory, and works on whole words:
+ *
+ *   - set/clear/test of one bit are a shift and a mask.
+ *   - AND, OR, XOR and ANDNOT combine two vectors in place. Counting set bits (popcount) and
+ *     finding the next set bit (trailing zero count) look at 64 bits at a time.
+ *   - Combining and counting run on the kernels picked by 'cvector_simd__level()' (see
+ *     cvector_simd.h): scalar, SSE2 or AVX2 (which also serves AVX-512 CPUs), so filters over
+ *     big vectors run at memory bandwidth.
+ *
+ * Bits past the size in the last word are always 0, so counting and searching never see them.
+ *
+ * For example:
+ *
+ * CVector_bits cvector_bits_t;
+ *
+ * cvector_bits_t active, paid;
+ * cvector__bits_init(&active);
+ * cvector__bits_init(&paid);
+ * cvector__bits_resize(&active, 1000000);          // all clear
+ * cvector__bits_resize(&paid, 1000000);
+ *
+ * cvector__bits_set(&active, 42);
+ * cvector__bits_set(&paid, 42);
+ * cvector__bits_and(&active, &paid);               // active = active & paid
+ * size_t both = cvector__bits_count(&active);
+ *
+ * for (ptrdiff_t i = cvector__bits_find_next(&active, 0); i >= 0;
+ *      i = cvector__bits_find_next(&active, i + 1)) {
+ *   // bit i is set
+ * }
+ *
+ * cvector__bits_free(&active);
+ * cvector__bits_free(&paid);
+ */
+
+#ifndef cvector_bits_h
+#define cvector_bits_h
+
+#include "cvector.h"
+#include "cvector_simd.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* PRIVATE: Number of words holding 'size' bits. */
+#define cvector_bits__words_for_(size) (((size) + 63) / 64)
+
+/* PRIVATE: Word of bit 'index', and mask of the bit in it. */
+#define cvector_bits__word_(index) ((index) / 64)
+#define cvector_bits__mask_(index) ((uint64_t)1 << ((index) % 64))
+
+/* PRIVATE: Combining operations. */
+#define CVECTOR_BITS__AND_ 0
+#define CVECTOR_BITS__OR_ 1
+#define CVECTOR_BITS__XOR_ 2
+#define CVECTOR_BITS__ANDNOT_ 3
+
+/*
+ * PRIVATE: Scalar kernel 'name' storing 'expr' of words 'd' (of 'dst') and 's' (of 'src') in 'dst'.
+ * Also the tail loops of the vector kernels.
+ */
+#define CVECTOR_BITS__SCALAR_KERNEL_(name, expr)                                                   \
+  static inline void cvector_bits__##name##_scalar_(uint64_t *dst, const uint64_t *src,            \
+                                                    size_t words) {                                \
+    for (size_t i = 0; i < words; i++) {                                                           \
+      uint64_t d = dst[i];                                                                         \
+      uint64_t s = src[i];                                                                         \
+      dst[i] = (expr);                                                                             \
+    }                                                                                              \
+  }
+
+CVECTOR_BITS__SCALAR_KERNEL_(and, d & s)
+CVECTOR_BITS__SCALAR_KERNEL_(or, d | s)
+CVECTOR_BITS__SCALAR_KERNEL_(xor, d ^ s)
+CVECTOR_BITS__SCALAR_KERNEL_(andnot, d & ~s)
+
+/* PRIVATE: Number of set bits of 'words' words. */
+static inline size_t cvector_bits__count_scalar_(const uint64_t *words, size_t size) {
+  size_t count = 0;
+  for (size_t i = 0; i < size; i++) {
+    count += (size_t)__builtin_popcountll(words[i]);
+  }
+  return count;
+}
+
+#ifdef CVECTOR_SIMD__X86_
+
+/*
+ * PRIVATE: Vector kernel 'name' of instruction set 'isa', storing 'expr' of vectors 'd' and 's'
+ * of type 'V' (holding 'W' words) in 'dst'.
+ */
+#define CVECTOR_BITS__VECTOR_KERNEL_(isa, name, V, W, load, store, expr)                           \
+  CVECTOR_SIMD__OP_(isa)                                                                           \
+  void cvector_bits__##name##_##isa##_(uint64_t *dst, const uint64_t *src, size_t words) {         \
+    size_t i = 0;                                                                                  \
+    for (; i + (W) <= words; i += (W)) {                                                           \
+      V d = load((const V *)(dst + i));                                                            \
+      V s = load((const V *)(src + i));                                                            \
+      store((V *)(dst + i), (expr));                                                               \
+    }                                                                                              \
+    cvector_bits__##name##_scalar_(dst + i, src + i, words - i);                                   \
+  }
+
+CVECTOR_BITS__VECTOR_KERNEL_(sse2, and, __m128i, 2, _mm_loadu_si128, _mm_storeu_si128,
+                             _mm_and_si128(d, s))
+CVECTOR_BITS__VECTOR_KERNEL_(sse2, or, __m128i, 2, _mm_loadu_si128, _mm_storeu_si128,
+                             _mm_or_si128(d, s))
+CVECTOR_BITS__VECTOR_KERNEL_(sse2, xor, __m128i, 2, _mm_loadu_si128, _mm_storeu_si128,
+                             _mm_xor_si128(d, s))
+CVECTOR_BITS__VECTOR_KERNEL_(sse2, andnot, __m128i, 2, _mm_loadu_si128, _mm_storeu_si128,
+                             _mm_andnot_si128(s, d))
+
+CVECTOR_BITS__VECTOR_KERNEL_(avx2, and, __m256i, 4, _mm256_loadu_si256, _mm256_storeu_si256,
+                             _mm256_and_si256(d, s))
+CVECTOR_BITS__VECTOR_KERNEL_(avx2, or, __m256i, 4, _mm256_loadu_si256, _mm256_storeu_si256,
+                             _mm256_or_si256(d, s))
+CVECTOR_BITS__VECTOR_KERNEL_(avx2, xor, __m256i, 4, _mm256_loadu_si256, _mm256_storeu_si256,
+                             _mm256_xor_si256(d, s))
+CVECTOR_BITS__VECTOR_KERNEL_(avx2, andnot, __m256i, 4, _mm256_loadu_si256, _mm256_storeu_si256,
+                             _mm256_andnot_si256(s, d))
+
+/* PRIVATE: Counts bits 2 words at a time: bit pairs, nibbles and bytes are summed in place (SWAR),
+ * then bytes are summed per word by 'psadbw'. */
+CVECTOR_SIMD__OP_(sse2) size_t cvector_bits__count_sse2_(const uint64_t *words, size_t size) {
+  __m128i m1 = _mm_set1_epi8(0x55);
+  __m128i m2 = _mm_set1_epi8(0x33);
+  __m128i m4 = _mm_set1_epi8(0x0f);
+  __m128i acc = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 2 <= size; i += 2) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(words + i));
+    v = _mm_sub_epi8(v, _mm_and_si128(_mm_srli_epi64(v, 1), m1));
+    v = _mm_add_epi8(_mm_and_si128(v, m2), _mm_and_si128(_mm_srli_epi64(v, 2), m2));
+    v = _mm_and_si128(_mm_add_epi8(v, _mm_srli_epi64(v, 4)), m4);
+    acc = _mm_add_epi64(acc, _mm_sad_epu8(v, _mm_setzero_si128()));
+  }
+  uint64_t lanes[2];
+  _mm_storeu_si128((__m128i *)lanes, acc);
+  return (size_t)(lanes[0] + lanes[1]) + cvector_bits__count_scalar_(words + i, size - i);
+}
+
+/* PRIVATE: Counts bits 4 words at a time: both nibbles of every byte are counted with a 16 entry
+ * table ('vpshufb'), then bytes are summed per word by 'vpsadbw'. */
+CVECTOR_SIMD__OP_(avx2) size_t cvector_bits__count_avx2_(const uint64_t *words, size_t size) {
+  __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2,
+                                   2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  __m256i low = _mm256_set1_epi8(0x0f);
+  __m256i acc = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(words + i));
+    __m256i counts =
+        _mm256_add_epi8(_mm256_shuffle_epi8(table, _mm256_and_si256(v, low)),
+                        _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), low)));
+    acc = _mm256_add_epi64(acc, _mm256_sad_epu8(counts, _mm256_setzero_si256()));
+  }
+  uint64_t lanes[4];
+  _mm256_storeu_si256((__m256i *)lanes, acc);
+  return (size_t)(lanes[0] + lanes[1] + lanes[2] + lanes[3]) +
+         cvector_bits__count_scalar_(words + i, size - i);
+}
+
+/* PRIVATE: Calls flavour of 'kernel' matching the level in use, AVX2 from AVX2 up. */
+#define CVECTOR_BITS__DISPATCH_(kernel, ...)                                                       \
+  ((cvector_simd__level() >= CVECTOR_SIMD__AVX2)   ? kernel##avx2_(__VA_ARGS__)                    \
+   : (cvector_simd__level() == CVECTOR_SIMD__SSE2) ? kernel##sse2_(__VA_ARGS__)                    \
+                                                   : kernel##scalar_(__VA_ARGS__))
+
+#else
+
+/* PRIVATE: Only scalar kernels outside x86. */
+#define CVECTOR_BITS__DISPATCH_(kernel, ...) (kernel##scalar_(__VA_ARGS__))
+
+#endif /* CVECTOR_SIMD__X86_ */
+
+/* PRIVATE: Combines 'size' bits of 'dst' with 'src' of 'src_size' bits by operation 'op', bits
+ * of 'src' past its size counting as 0. Bits of 'dst' past its size stay 0. */
+static inline void cvector_bits__combine_(int op, uint64_t *dst, size_t size, const uint64_t *src,
+                                          size_t src_size) {
+  size_t dst_words = cvector_bits__words_for_(size);
+  size_t src_words = cvector_bits__words_for_(src_size);
+  size_t words = (dst_words < src_words) ? dst_words : src_words;
+  switch (op) {
+  case CVECTOR_BITS__AND_:
+    CVECTOR_BITS__DISPATCH_(cvector_bits__and_, dst, src, words);
+    if (dst_words > words) {
+      memset(dst + words, 0, (dst_words - words) * sizeof(uint64_t));
+    }
+    break;
+  case CVECTOR_BITS__OR_:
+    CVECTOR_BITS__DISPATCH_(cvector_bits__or_, dst, src, words);
+    break;
+  case CVECTOR_BITS__XOR_:
+    CVECTOR_BITS__DISPATCH_(cvector_bits__xor_, dst, src, words);
+    break;
+  default:
+    CVECTOR_BITS__DISPATCH_(cvector_bits__andnot_, dst, src, words);
+    break;
+  }
+  if ((size % 64) != 0) {
+    dst[dst_words - 1] &= cvector_bits__mask_(size) - 1;
+  }
+}
+
+/* PRIVATE: Index of first set bit at or after 'from' among 'size' bits, or -1 if there is none. */
+static inline ptrdiff_t cvector_bits__find_next_(const uint64_t *words, size_t size, size_t from) {
+  if (from >= size) {
+    return -1;
+  }
+  size_t last = cvector_bits__words_for_(size) - 1;
+  size_t at = cvector_bits__word_(from);
+  uint64_t word = words[at] & ~(cvector_bits__mask_(from) - 1);
+  while (word == 0) {
+    if (at == last) {
+      return -1;
+    }
+    word = words[++at];
+  }
+  return (ptrdiff_t)(at * 64 + (size_t)__builtin_ctzll(word));
+}
+
+/*
+ * Macro to create bit vector type. Its size is its number of bits, the words are a regular
+ * vector of 'uint64_t'.
+ */
+#define CVector_bits                                                                               \
+  typedef struct {                                                                                 \
+    /* Words, 64 bits each */                                                                      \
+    struct {                                                                                       \
+      CVECTOR__FIELDS_(uint64_t)                                                                   \
+    } cvector_bits__words_m;                                                                       \
+    /* Number of bits */                                                                           \
+    size_t cvector__size_m;                                                                        \
+  }
+
+/* PRIVATE: Vector of words. */
+#define cvector_bits__vec_(vec) (&((vec)->cvector_bits__words_m))
+
+/* PRIVATE: Words of bit vector. */
+#define cvector_bits__elem_(vec) (cvector__elem_(cvector_bits__vec_(vec)))
+
+/* PUBLIC: Initializes empty bit vector, no allocation is made until the first bit. */
+#define cvector__bits_init(vec)                                                                    \
+  do {                                                                                             \
+    cvector__init(cvector_bits__vec_(vec));                                                        \
+    cvector__setsize_((vec), 0);                                                                   \
+  } while (0)
+
+/* PUBLIC: Sets number of bits to 'size'. Added bits are clear.
+ * Returns -1 (error) if memory can't be allocated, the vector is then unchanged. */
+#define cvector__bits_resize(vec, size)                                                            \
+  ({                                                                                               \
+    size_t cvector__bits_m = (size);                                                               \
+    size_t cvector__words_m = cvector_bits__words_for_(cvector__bits_m);                           \
+    size_t cvector__old_words_m = cvector__size(cvector_bits__vec_(vec));                          \
+    int cvector__result_m = 0;                                                                     \
+    if (cvector__words_m > cvector__old_words_m) {                                                 \
+      cvector__reserve(cvector_bits__vec_(vec), cvector__words_m);                                 \
+      if (cvector__cap_(cvector_bits__vec_(vec)) >= cvector__words_m) {                            \
+        memset(cvector_bits__elem_(vec) + cvector__old_words_m, 0,                                 \
+               (cvector__words_m - cvector__old_words_m) * sizeof(uint64_t));                      \
+      } else {                                                                                     \
+        cvector__result_m = -1;                                                                    \
+      }                                                                                            \
+    }                                                                                              \
+    if (cvector__result_m == 0) {                                                                  \
+      cvector__setsize_(cvector_bits__vec_(vec), cvector__words_m);                                \
+      cvector__setsize_((vec), cvector__bits_m);                                                   \
+      if ((cvector__bits_m % 64) != 0) {                                                           \
+        cvector_bits__elem_(vec)[cvector__words_m - 1] &=                                          \
+            cvector_bits__mask_(cvector__bits_m) - 1;                                              \
+      }                                                                                            \
+    }                                                                                              \
+    cvector__result_m;                                                                             \
+  })
+
+/* PUBLIC: Adds bit 'value' at the back.
+ * The bit is dropped if memory can't be allocated, like 'cvector__add'. */
+#define cvector__bits_add(vec, value)                                                              \
+  do {                                                                                             \
+    size_t cvector__at_m = cvector__size(vec);                                                     \
+    if ((cvector__at_m % 64) == 0) {                                                               \
+      cvector__add(cvector_bits__vec_(vec), 0);                                                    \
+    }                                                                                              \
+    if (cvector__size(cvector_bits__vec_(vec)) > cvector_bits__word_(cvector__at_m)) {             \
+      if (value) {                                                                                 \
+        cvector_bits__elem_(vec)[cvector_bits__word_(cvector__at_m)] |=                            \
+            cvector_bits__mask_(cvector__at_m);                                                    \
+      }                                                                                            \
+      cvector__setsize_((vec), cvector__at_m + 1);                                                 \
+    }                                                                                              \
+  } while (0)
+
+/* PUBLIC: Sets bit at given index, which must be less than size. */
+#define cvector__bits_set(vec, index)                                                              \
+  do {                                                                                             \
+    size_t cvector__at_m = (index);                                                                \
+    cvector_bits__elem_(vec)[cvector_bits__word_(cvector__at_m)] |=                                \
+        cvector_bits__mask_(cvector__at_m);                                                        \
+  } while (0)
+
+/* PUBLIC: Clears bit at given index, which must be less than size. */
+#define cvector__bits_clear(vec, index)                                                            \
+  do {                                                                                             \
+    size_t cvector__at_m = (index);                                                                \
+    cvector_bits__elem_(vec)[cvector_bits__word_(cvector__at_m)] &=                                \
+        ~cvector_bits__mask_(cvector__at_m);                                                       \
+  } while (0)
+
+/* PUBLIC: Returns whether bit at given index is set. */
+#define cvector__bits_test(vec, index)                                                             \
+  ({                                                                                               \
+    size_t cvector__at_m = (index);                                                                \
+    (bool)((cvector_bits__elem_(vec)[cvector_bits__word_(cvector__at_m)] &                         \
+            cvector_bits__mask_(cvector__at_m)) != 0);                                             \
+  })
+
+/* PUBLIC: Clears every bit, keeping size. */
+#define cvector__bits_clear_all(vec)                                                               \
+  do {                                                                                             \
+    if (cvector__size(cvector_bits__vec_(vec)) > 0) {                                              \
+      memset(cvector_bits__elem_(vec), 0,                                                          \
+             cvector__size(cvector_bits__vec_(vec)) * sizeof(uint64_t));                           \
+    }                                                                                              \
+  } while (0)
+
+/* PUBLIC: Bulk operations, 'dst' = 'dst' op 'src'. 'dst' keeps its size, bits of 'src' past its
+ * size count as 0. 'src' may be 'dst'. */
+#define cvector__bits_and(dst, src)                                                                \
+  cvector_bits__combine_(CVECTOR_BITS__AND_, cvector_bits__elem_(dst), cvector__size(dst),         \
+                         cvector_bits__elem_(src), cvector__size(src))
+#define cvector__bits_or(dst, src)                                                                 \
+  cvector_bits__combine_(CVECTOR_BITS__OR_, cvector_bits__elem_(dst), cvector__size(dst),          \
+                         cvector_bits__elem_(src), cvector__size(src))
+#define cvector__bits_xor(dst, src)                                                                \
+  cvector_bits__combine_(CVECTOR_BITS__XOR_, cvector_bits__elem_(dst), cvector__size(dst),         \
+                         cvector_bits__elem_(src), cvector__size(src))
+/* PUBLIC: 'dst' = 'dst' & ~'src'. */
+#define cvector__bits_andnot(dst, src)                                                             \
+  cvector_bits__combine_(CVECTOR_BITS__ANDNOT_, cvector_bits__elem_(dst), cvector__size(dst),      \
+                         cvector_bits__elem_(src), cvector__size(src))
+
+/* PUBLIC: Returns number of set bits. */
+#define cvector__bits_count(vec)                                                                   \
+  (CVECTOR_BITS__DISPATCH_(cvector_bits__count_, cvector_bits__elem_(vec),                         \
+                           cvector__size(cvector_bits__vec_(vec))))
+
+/* PUBLIC: Returns index of first set bit at or after 'from', or -1 if there is none. */
+#define cvector__bits_find_next(vec, from)                                                         \
+  (cvector_bits__find_next_(cvector_bits__elem_(vec), cvector__size(vec), (size_t)(from)))
+
+/* PUBLIC: Frees the words. */
+#define cvector__bits_free(vec)                                                                    \
+  do {                                                                                             \
+    cvector__free(cvector_bits__vec_(vec));                                                        \
+    cvector__setsize_(cvector_bits__vec_(vec), 0);                                                 \
+    cvector__setcap_(cvector_bits__vec_(vec), 0);                                                  \
+    cvector__setsize_((vec), 0);                                                                   \
+  } while (0)
+
+#endif /* cvector_bits_h */
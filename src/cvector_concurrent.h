@@ -0,0 +1,137 @@
+/*
+ * Concurrent append-only vector for cvector.
+ *
+ * 'CVector_concurrent(T)' lets any number of threads append to one vector without a lock:
+ *
+ *   - A push claims its slot with a single atomic fetch-add on the size.
+ *   - Storage is a fixed table of segments whose sizes double (32, 64, 128, ... elements), so
+ *     growing means allocating the next segment, never moving existing elements. The first thread
+ *     that needs a segment installs it with a compare-and-swap, a losing racer frees its copy.
+ *   - Therefore references returned by 'cvector__concurrent_index_ref' stay valid for the life of
+ *     the vector, and reading an element while other threads append is safe.
+ *
+ * For example:
+ *
+ * CVector_concurrent(int) cvector_concurrent_int_t;
+ *
+ * cvector_concurrent_int_t results;
+ * cvector__concurrent_init(&results);
+ *
+ * // From any thread
+ * size_t index = cvector__concurrent_add(&results, 42);
+ *
+ * // After the writers are joined
+ * for (size_t i = 0; i < cvector__size(&results); i++) {
+ *   int value = cvector__concurrent_index(&results, i);
+ * }
+ *
+ * cvector__concurrent_free(&results);
+ *
+ * NOTE: Like other concurrent vectors, 'cvector__size' counts claimed slots, which may include
+ * elements whose push hasn't returned yet. An element is safe to read once its push returned
+ * (e.g. by the index it returned, or after joining the writers).
+ */
+
+#ifndef cvector_concurrent_h
+#define cvector_concurrent_h
+
+#include "cvector.h"
+#include "cvector_segment.h"
+
+#include <stdatomic.h>
+
+/*
+ * Macro to create concurrent vector type of elements of type 'cvector__elem_type_'.
+ * The size counter lives on its own cache line so that appends don't bounce the segment table.
+ */
+#define CVector_concurrent(cvector__elem_type_)                                                    \
+  typedef struct {                                                                                 \
+    /* Segments, installed once and never moved */                                                 \
+    _Atomic(cvector__elem_type_ *) cvector_concurrent__segments_m[CVECTOR_SEGMENT__COUNT_];        \
+    /* Number of claimed slots */                                                                  \
+    _Alignas(64) _Atomic size_t cvector__size_m;                                                   \
+  }
+
+/* PRIVATE: Installs segment 'segment' of 'elem_size' bytes elements unless another thread did.
+ * Returns the installed segment. Aborts if it can't be allocated and no other thread installed it:
+ * the caller's slot is already claimed, so there's no way to report the failure and keep indices
+ * dense. */
+static inline void *cvector_concurrent__install_(void *_Atomic *slot, size_t segment,
+                                                 size_t elem_size) {
+  void *fresh = malloc(cvector_segment__size_(segment) * elem_size);
+  void *expected = NULL;
+  if (fresh == NULL) {
+    expected = atomic_load_explicit(slot, memory_order_acquire);
+    if (expected == NULL) {
+      abort();
+    }
+    return expected;
+  }
+  if (!atomic_compare_exchange_strong_explicit(slot, &expected, fresh, memory_order_acq_rel,
+                                               memory_order_acquire)) {
+    free(fresh);
+    return expected;
+  }
+  return fresh;
+}
+
+/* PRIVATE: Access segment table slot. */
+#define cvector_concurrent__segment_(vec, segment)                                                 \
+  (atomic_load_explicit(&((vec)->cvector_concurrent__segments_m[(segment)]),                       \
+                        memory_order_acquire))
+
+/* PUBLIC: Initializes concurrent vector. Not thread safe, call it before sharing the vector. */
+#define cvector__concurrent_init(vec)                                                              \
+  do {                                                                                             \
+    for (size_t cvector__segment_m = 0; cvector__segment_m < CVECTOR_SEGMENT__COUNT_;              \
+         cvector__segment_m++) {                                                                   \
+      atomic_init(&((vec)->cvector_concurrent__segments_m[cvector__segment_m]), NULL);             \
+    }                                                                                              \
+    atomic_init(&((vec)->cvector__size_m), 0);                                                     \
+  } while (0)
+
+/* PUBLIC: Appends element from any thread without locking. Returns index of the element.
+ * Aborts if the segment holding the new element can't be allocated. The slot is claimed before
+ * the segment exists, and other threads may already hold later slots, so an error return would
+ * leave a hole that readers walking up to 'cvector__size' can't detect.
+ */
+#define cvector__concurrent_add(vec, val)                                                          \
+  ({                                                                                               \
+    size_t cvector__at_m =                                                                         \
+        atomic_fetch_add_explicit(&((vec)->cvector__size_m), 1, memory_order_relaxed);             \
+    size_t cvector__segment_m = cvector_segment__of_(cvector__at_m);                               \
+    __typeof__(cvector_concurrent__segment_((vec), 0)) cvector__elems_m =                          \
+        cvector_concurrent__segment_((vec), cvector__segment_m);                                   \
+    if (cvector__elems_m == NULL) {                                                                \
+      cvector__elems_m = cvector_concurrent__install_(                                             \
+          (void *_Atomic *)&((vec)->cvector_concurrent__segments_m[cvector__segment_m]),           \
+          cvector__segment_m, sizeof(*cvector__elems_m));                                          \
+    }                                                                                              \
+    cvector__elems_m[cvector_segment__offset_(cvector__at_m, cvector__segment_m)] = (val);         \
+    cvector__at_m;                                                                                 \
+  })
+
+/* PUBLIC: Returns reference to element at given index. Stays valid until the vector is freed. */
+#define cvector__concurrent_index_ref(vec, index)                                                  \
+  ({                                                                                               \
+    size_t cvector__at_m = (index);                                                                \
+    size_t cvector__segment_m = cvector_segment__of_(cvector__at_m);                               \
+    (&(cvector_concurrent__segment_((vec), cvector__segment_m)                                     \
+           [cvector_segment__offset_(cvector__at_m, cvector__segment_m)]));                        \
+  })
+
+/* PUBLIC: Returns element at given index. */
+#define cvector__concurrent_index(vec, index) (*cvector__concurrent_index_ref((vec), (index)))
+
+/* PUBLIC: Frees every segment. Not thread safe, call it once writers and readers are done. */
+#define cvector__concurrent_free(vec)                                                              \
+  do {                                                                                             \
+    for (size_t cvector__segment_m = 0; cvector__segment_m < CVECTOR_SEGMENT__COUNT_;              \
+         cvector__segment_m++) {                                                                   \
+      free(cvector_concurrent__segment_((vec), cvector__segment_m));                               \
+      atomic_store(&((vec)->cvector_concurrent__segments_m[cvector__segment_m]), NULL);            \
+    }                                                                                              \
+    atomic_store(&((vec)->cvector__size_m), 0);                                                    \
+  } while (0)
+
+#endif /* cvector_concurrent_h */
@@ -0,0 +1,308 @@
+/*
+ * Double ended queues for cvector.
+ *
+ * 'CVector(T)' only adds and pops at the back, so using it as a FIFO means shifting every element
+ * on each removal from the front. 'CVector_deque(T)' is a circular buffer instead: push and pop
+ * are O(1) at both ends.
+ *
+ *   - The cap is always a power of two, so positions wrap with a mask instead of a modulo.
+ *   - Growth copies the (possibly wrapped) content into a buffer twice as big with at most two
+ *     memcpy calls, unrolling it so the new buffer starts at position 0.
+ *
+ * For example:
+ *
+ * CVector_deque(int) cvector_deque_int_t;
+ *
+ * cvector_deque_int_t queue;
+ * cvector__deque_init(&queue);
+ *
+ * cvector__deque_push_back(&queue, 1);
+ * cvector__deque_push_front(&queue, 0);
+ *
+ * while (cvector__size(&queue) > 0) {
+ *   int value = cvector__deque_pop_front(&queue);
+ * }
+ *
+ * cvector__deque_free(&queue);
+ *
+ * For handing work from one thread to another, 'CVector_deque_spsc(T)' is a bounded ring with one
+ * producer and one consumer. Head and tail live on separate cache lines, each side caches the
+ * other's counter and only rereads it when the ring looks full (or empty), so the two threads
+ * rarely touch the same cache line:
+ *
+ * CVector_deque_spsc(int) cvector_spsc_int_t;
+ *
+ * cvector_spsc_int_t channel;
+ * cvector__deque_spsc_init(&channel, 1024);
+ *
+ * // Producer thread
+ * while (!cvector__deque_spsc_push(&channel, 42)) {
+ *   // full
+ * }
+ *
+ * // Consumer thread
+ * int value;
+ * if (cvector__deque_spsc_pop(&channel, &value)) {
+ *   ...
+ * }
+ *
+ * cvector__deque_spsc_free(&channel);
+ *
+ * NOTE: Deques and rings are not built on 'CVECTOR__FIELDS_' and have no allocator slot: their
+ * buffers always come from malloc/free, 'cvector__init_with_allocator' doesn't apply to them.
+ */
+
+#ifndef cvector_deque_h
+#define cvector_deque_h
+
+#include "cvector.h"
+
+#include <stdatomic.h>
+
+/* Cap of a deque after its first push. Must be a power of two. */
+#ifndef CVECTOR_DEQUE__MIN_CAP
+#define CVECTOR_DEQUE__MIN_CAP 8
+#endif
+
+/* Size of cache line separating producer and consumer counters of 'CVector_deque_spsc'. */
+#ifndef CVECTOR_DEQUE__CACHE_LINE
+#define CVECTOR_DEQUE__CACHE_LINE 64
+#endif
+
+/*
+ * Macro to create deque type of elements of type 'cvector__elem_type_'.
+ * Element 'i' lives at position (head + i) & (cap - 1) of the buffer.
+ */
+#define CVector_deque(cvector__elem_type_)                                                         \
+  typedef struct {                                                                                 \
+    cvector__elem_type_ *cvector__elem_m;                                                          \
+    size_t cvector__size_m;                                                                        \
+    /* Power of two, or 0 before the first push */                                                 \
+    size_t cvector__cap_m;                                                                         \
+    /* Position of first element */                                                                \
+    size_t cvector_deque__head_m;                                                                  \
+  }
+
+/* PRIVATE: Smallest power of two that is more than equal to 'n' (and CVECTOR_DEQUE__MIN_CAP). */
+static inline size_t cvector_deque__pow2_(size_t n) {
+  if (n <= CVECTOR_DEQUE__MIN_CAP) {
+    return CVECTOR_DEQUE__MIN_CAP;
+  }
+  return (size_t)1 << (64 - __builtin_clzll((unsigned long long)(n - 1)));
+}
+
+/* PRIVATE: Moves 'size' elements starting at position 'head' of ring 'elems' of 'cap' elements
+ * into a fresh buffer of 'new_cap' elements, unwrapped so they start at position 0.
+ * Returns the new buffer, or NULL (ring untouched) if it can't be allocated. */
+static inline void *cvector_deque__unwrap_(void *elems, size_t elem_size, size_t head, size_t size,
+                                           size_t cap, size_t new_cap) {
+  char *mem = malloc(new_cap * elem_size);
+  if (mem == NULL) {
+    return NULL;
+  }
+
+  // Elements from head up to the end of the buffer, then the ones wrapped around to its start.
+  size_t first = (size < cap - head) ? size : cap - head;
+  if (first > 0) {
+    memcpy(mem, ((char *)elems) + head * elem_size, first * elem_size);
+  }
+  if (size > first) {
+    memcpy(mem + first * elem_size, elems, (size - first) * elem_size);
+  }
+  free(elems);
+  return mem;
+}
+
+/* PRIVATE: Mask turning a position into a buffer index. */
+#define cvector_deque__mask_(deque) (cvector__cap_(deque) - 1)
+
+/* PRIVATE: Buffer index of element 'index'. */
+#define cvector_deque__at_(deque, index)                                                           \
+  (((deque)->cvector_deque__head_m + (index)) & cvector_deque__mask_(deque))
+
+/* PUBLIC: Initializes empty deque, no allocation is made until the first push. */
+#define cvector__deque_init(deque)                                                                 \
+  do {                                                                                             \
+    cvector__set_elem_((deque), NULL);                                                             \
+    cvector__setsize_((deque), 0);                                                                 \
+    cvector__setcap_((deque), 0);                                                                  \
+    (deque)->cvector_deque__head_m = 0;                                                            \
+  } while (0)
+
+/* PUBLIC: Makes room for at least 'cap' elements. Cap is rounded up to a power of two. */
+#define cvector__deque_reserve(deque, cap)                                                         \
+  do {                                                                                             \
+    size_t cvector__min_cap_m = (cap);                                                             \
+    if (cvector__min_cap_m > cvector__cap_(deque)) {                                               \
+      size_t cvector__new_cap_m = cvector_deque__pow2_(cvector__min_cap_m);                        \
+      void *cvector__mem_m = cvector_deque__unwrap_(                                               \
+          cvector__elem_(deque), sizeof(*cvector__elem_(deque)), (deque)->cvector_deque__head_m,   \
+          cvector__size(deque), cvector__cap_(deque), cvector__new_cap_m);                         \
+      if (cvector__mem_m != NULL) {                                                                \
+        cvector__set_elem_((deque), cvector__mem_m);                                               \
+        cvector__setcap_((deque), cvector__new_cap_m);                                             \
+        (deque)->cvector_deque__head_m = 0;                                                        \
+      }                                                                                            \
+    }                                                                                              \
+  } while (0)
+
+/* PRIVATE: Doubles cap when deque is full. */
+#define cvector_deque__grow_(deque)                                                                \
+  do {                                                                                             \
+    if (cvector__size(deque) >= cvector__cap_(deque)) {                                            \
+      cvector__deque_reserve((deque), (cvector__size(deque) + 1));                                 \
+    }                                                                                              \
+  } while (0)
+
+/* PUBLIC: Returns reference to element at given index, 0 being the front. */
+#define cvector__deque_index_ref(deque, index)                                                     \
+  (&(cvector__elem_(deque)[cvector_deque__at_((deque), (index))]))
+
+/* PUBLIC: Returns element at given index, 0 being the front. */
+#define cvector__deque_index(deque, index) (*cvector__deque_index_ref((deque), (index)))
+
+/* PUBLIC: Returns first element. Deque must not be empty. */
+#define cvector__deque_front(deque) (cvector__elem_(deque)[(deque)->cvector_deque__head_m])
+
+/* PUBLIC: Returns last element. Deque must not be empty. */
+#define cvector__deque_back(deque) (cvector__deque_index((deque), (cvector__size(deque) - 1)))
+
+/* PUBLIC: Adds element at the back. The element is dropped if memory can't be allocated. */
+#define cvector__deque_push_back(deque, val)                                                       \
+  do {                                                                                             \
+    cvector_deque__grow_(deque);                                                                   \
+    if (cvector__size(deque) < cvector__cap_(deque)) {                                             \
+      cvector__elem_(deque)[cvector_deque__at_((deque), cvector__size(deque))] = (val);            \
+      cvector__setsize_((deque), (cvector__size(deque) + 1));                                      \
+    }                                                                                              \
+  } while (0)
+
+/* PUBLIC: Adds element at the front. The element is dropped if memory can't be allocated. */
+#define cvector__deque_push_front(deque, val)                                                      \
+  do {                                                                                             \
+    cvector_deque__grow_(deque);                                                                   \
+    if (cvector__size(deque) < cvector__cap_(deque)) {                                             \
+      (deque)->cvector_deque__head_m =                                                             \
+          ((deque)->cvector_deque__head_m - 1) & cvector_deque__mask_(deque);                      \
+      cvector__elem_(deque)[(deque)->cvector_deque__head_m] = (val);                               \
+      cvector__setsize_((deque), (cvector__size(deque) + 1));                                      \
+    }                                                                                              \
+  } while (0)
+
+/* PUBLIC: Removes and returns first element. Deque must not be empty. */
+#define cvector__deque_pop_front(deque)                                                            \
+  ({                                                                                               \
+    size_t cvector__head_m = (deque)->cvector_deque__head_m;                                       \
+    (deque)->cvector_deque__head_m = (cvector__head_m + 1) & cvector_deque__mask_(deque);          \
+    cvector__setsize_((deque), (cvector__size(deque) - 1));                                        \
+    (cvector__elem_(deque)[cvector__head_m]);                                                      \
+  })
+
+/* PUBLIC: Removes and returns last element. Deque must not be empty. */
+#define cvector__deque_pop_back(deque)                                                             \
+  ({                                                                                               \
+    cvector__setsize_((deque), (cvector__size(deque) - 1));                                        \
+    (cvector__deque_index((deque), cvector__size(deque)));                                         \
+  })
+
+/* PUBLIC: Removes every element, keeping the buffer. */
+#define cvector__deque_clear(deque)                                                                \
+  do {                                                                                             \
+    cvector__setsize_((deque), 0);                                                                 \
+    (deque)->cvector_deque__head_m = 0;                                                            \
+  } while (0)
+
+/* PUBLIC: Frees the buffer. */
+#define cvector__deque_free(deque)                                                                 \
+  do {                                                                                             \
+    free(cvector__elem_(deque));                                                                   \
+    cvector__deque_init(deque);                                                                    \
+  } while (0)
+
+/*
+ * Macro to create bounded single producer, single consumer ring of elements of type
+ * 'cvector__elem_type_'. Head and tail are free running counters, wrapped with the mask on access.
+ */
+#define CVector_deque_spsc(cvector__elem_type_)                                                    \
+  typedef struct {                                                                                 \
+    cvector__elem_type_ *cvector_spsc__elem_m;                                                     \
+    size_t cvector_spsc__mask_m;                                                                   \
+    /* Consumer side: next element to pop, and last tail it saw */                                 \
+    _Alignas(CVECTOR_DEQUE__CACHE_LINE) _Atomic size_t cvector_spsc__head_m;                       \
+    size_t cvector_spsc__tail_cache_m;                                                             \
+    /* Producer side: next slot to push, and last head it saw */                                   \
+    _Alignas(CVECTOR_DEQUE__CACHE_LINE) _Atomic size_t cvector_spsc__tail_m;                       \
+    size_t cvector_spsc__head_cache_m;                                                             \
+  }
+
+/* PUBLIC: Initializes ring holding up to 'cap' elements, rounded up to a power of two.
+ * Returns 0, or -1 if the buffer can't be allocated.
+ * Not thread safe, call it before sharing the ring. */
+#define cvector__deque_spsc_init(spsc, cap)                                                        \
+  ({                                                                                               \
+    size_t cvector__cap_m = cvector_deque__pow2_(cap);                                             \
+    (spsc)->cvector_spsc__elem_m = malloc(cvector__cap_m * sizeof(*(spsc)->cvector_spsc__elem_m)); \
+    (spsc)->cvector_spsc__mask_m = cvector__cap_m - 1;                                             \
+    atomic_init(&(spsc)->cvector_spsc__head_m, 0);                                                 \
+    atomic_init(&(spsc)->cvector_spsc__tail_m, 0);                                                 \
+    (spsc)->cvector_spsc__tail_cache_m = 0;                                                        \
+    (spsc)->cvector_spsc__head_cache_m = 0;                                                        \
+    ((spsc)->cvector_spsc__elem_m != NULL) ? 0 : -1;                                               \
+  })
+
+/* PUBLIC: Returns number of elements the ring holds. */
+#define cvector__deque_spsc_cap(spsc) ((spsc)->cvector_spsc__mask_m + 1)
+
+/* PUBLIC: Returns number of elements in the ring. Exact only when called by producer or consumer
+ * while the other side is idle, otherwise a snapshot. */
+#define cvector__deque_spsc_size(spsc)                                                             \
+  (atomic_load_explicit(&(spsc)->cvector_spsc__tail_m, memory_order_acquire) -                     \
+   atomic_load_explicit(&(spsc)->cvector_spsc__head_m, memory_order_acquire))
+
+/* PUBLIC: Producer only. Adds element at the back, returns false if the ring is full. */
+#define cvector__deque_spsc_push(spsc, val)                                                        \
+  ({                                                                                               \
+    size_t cvector__tail_m =                                                                       \
+        atomic_load_explicit(&(spsc)->cvector_spsc__tail_m, memory_order_relaxed);                 \
+    bool cvector__room_m = true;                                                                   \
+    if (cvector__tail_m - (spsc)->cvector_spsc__head_cache_m > (spsc)->cvector_spsc__mask_m) {     \
+      (spsc)->cvector_spsc__head_cache_m =                                                         \
+          atomic_load_explicit(&(spsc)->cvector_spsc__head_m, memory_order_acquire);               \
+      cvector__room_m =                                                                            \
+          (cvector__tail_m - (spsc)->cvector_spsc__head_cache_m <= (spsc)->cvector_spsc__mask_m);  \
+    }                                                                                              \
+    if (cvector__room_m) {                                                                         \
+      (spsc)->cvector_spsc__elem_m[cvector__tail_m & (spsc)->cvector_spsc__mask_m] = (val);        \
+      atomic_store_explicit(&(spsc)->cvector_spsc__tail_m, cvector__tail_m + 1,                    \
+                            memory_order_release);                                                 \
+    }                                                                                              \
+    cvector__room_m;                                                                               \
+  })
+
+/* PUBLIC: Consumer only. Removes first element into '*out', returns false if the ring is empty. */
+#define cvector__deque_spsc_pop(spsc, out)                                                         \
+  ({                                                                                               \
+    size_t cvector__head_m =                                                                       \
+        atomic_load_explicit(&(spsc)->cvector_spsc__head_m, memory_order_relaxed);                 \
+    bool cvector__some_m = true;                                                                   \
+    if (cvector__head_m == (spsc)->cvector_spsc__tail_cache_m) {                                   \
+      (spsc)->cvector_spsc__tail_cache_m =                                                         \
+          atomic_load_explicit(&(spsc)->cvector_spsc__tail_m, memory_order_acquire);               \
+      cvector__some_m = (cvector__head_m != (spsc)->cvector_spsc__tail_cache_m);                   \
+    }                                                                                              \
+    if (cvector__some_m) {                                                                         \
+      *(out) = (spsc)->cvector_spsc__elem_m[cvector__head_m & (spsc)->cvector_spsc__mask_m];       \
+      atomic_store_explicit(&(spsc)->cvector_spsc__head_m, cvector__head_m + 1,                    \
+                            memory_order_release);                                                 \
+    }                                                                                              \
+    cvector__some_m;                                                                               \
+  })
+
+/* PUBLIC: Frees the ring. Not thread safe, call it once producer and consumer are done. */
+#define cvector__deque_spsc_free(spsc)                                                             \
+  do {                                                                                             \
+    free((spsc)->cvector_spsc__elem_m);                                                            \
+    (spsc)->cvector_spsc__elem_m = NULL;                                                           \
+  } while (0)
+
+#endif /* cvector_deque_h */
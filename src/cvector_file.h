@@ -0,0 +1,278 @@
+/*
+ * Persistent, memory mapped vectors for cvector.
+ *
+ * A vector file is a small header followed by the raw element buffer ('cvector__elem_m'):
+ *
+ *   offset 0   magic "CVECTOR", format version, element size, size, cap
+ *   offset 64  element 0, element 1, ... element cap - 1
+ *
+ * 'cvector__file_open' maps such a file and points a regular 'CVector(T)' straight at the mapped
+ * elements, so 'cvector__index', 'cvector__size', the iterator macros, etc. work on it at once and
+ * pages are only read from disk when they are touched. Nothing is parsed or copied at startup.
+ *
+ * In CVECTOR_FILE__RDWR mode the vector can also grow: the file is extended in chunks of
+ * CVECTOR_FILE__CHUNK_SIZE bytes (ftruncate) and the mapping follows it (mremap). The element count
+ * is written back to the header by 'cvector__file_sync' and 'cvector__file_close'.
+ *
+ *   CVector(record_t) cvector_record_t;
+ *
+ *   cvector_file_t file;
+ *   cvector_record_t records;
+ *
+ *   if (cvector__file_open(&records, &file, "records.cvec", CVECTOR_FILE__RDONLY) == -1) {
+ *     // missing file, or it holds elements of another size
+ *   }
+ *
+ *   record_t first = cvector__first(&records);
+ *
+ *   cvector__file_close(&records, &file);
+ *
+ * NOTE: Elements are stored as raw bytes in host byte order, so only plain old data (no pointers)
+ * should be persisted, and files are not portable across architectures. A read only vector must
+ * not be modified (it is mapped PROT_READ).
+ */
+
+#ifndef cvector_file_h
+#define cvector_file_h
+
+#include "cvector.h"
+#include "cvector_mmap.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+/* Format version written to new files. Files of other versions are refused. */
+#define CVECTOR_FILE__VERSION 1
+
+/* Bytes reserved for header. Elements start right after it. */
+#define CVECTOR_FILE__HEADER_SIZE 64
+
+/* Step by which files opened for writing grow. */
+#ifndef CVECTOR_FILE__CHUNK_SIZE
+#define CVECTOR_FILE__CHUNK_SIZE (1024 * 1024)
+#endif
+
+/* Open modes. */
+/* Maps existing file read only. */
+#define CVECTOR_FILE__RDONLY 0
+/* Maps file read/write, creating it if it doesn't exist. */
+#define CVECTOR_FILE__RDWR 1
+
+/* PRIVATE: On disk header. */
+typedef struct {
+  /* "CVECTOR\0" */
+  char cvector_file_header__magic_m[8];
+  /* CVECTOR_FILE__VERSION */
+  uint32_t cvector_file_header__version_m;
+  /* sizeof element */
+  uint32_t cvector_file_header__elem_size_m;
+  /* Number of elements */
+  uint64_t cvector_file_header__size_m;
+  /* Number of elements the file has room for */
+  uint64_t cvector_file_header__cap_m;
+} cvector_file_header_t;
+
+typedef struct {
+  /* Descriptor of backing file. */
+  int cvector_file__fd_m;
+  /* Start of mapping (the header). */
+  char *cvector_file__base_m;
+  /* Length of mapping in bytes. */
+  size_t cvector_file__length_m;
+  /* Whether the file is mapped for writing. */
+  bool cvector_file__writable_m;
+  /* Interface handed to the vector. */
+  cvector_allocator_t cvector_file__allocator_m;
+} cvector_file_t;
+
+/* PRIVATE: Header of mapped file. */
+#define cvector_file__header_(file) ((cvector_file_header_t *)((file)->cvector_file__base_m))
+
+/* PRIVATE: Mapped elements. */
+#define cvector_file__data_(file) ((file)->cvector_file__base_m + CVECTOR_FILE__HEADER_SIZE)
+
+/* PRIVATE: Grows file and mapping so that elements fit in 'new_size' bytes. Never shrinks. */
+static inline void *cvector_file__realloc_(void *ctx, void *mem, size_t old_size,
+                                           size_t new_size) {
+  cvector_file_t *file = ctx;
+  (void)mem;
+  (void)old_size;
+
+  size_t needed = CVECTOR_FILE__HEADER_SIZE + new_size;
+  if (needed <= file->cvector_file__length_m) {
+    return cvector_file__data_(file);
+  }
+
+  if (!file->cvector_file__writable_m) {
+    return NULL;
+  }
+
+  size_t length = (needed + CVECTOR_FILE__CHUNK_SIZE - 1) & ~((size_t)CVECTOR_FILE__CHUNK_SIZE - 1);
+  if (ftruncate(file->cvector_file__fd_m, (off_t)length) == -1) {
+    return NULL;
+  }
+
+#ifdef __linux__
+  void *base = mremap(file->cvector_file__base_m, file->cvector_file__length_m, length,
+                      MREMAP_MAYMOVE);
+#else
+  munmap(file->cvector_file__base_m, file->cvector_file__length_m);
+  void *base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, file->cvector_file__fd_m, 0);
+#endif
+  if (base == MAP_FAILED) {
+    return NULL;
+  }
+
+  file->cvector_file__base_m = base;
+  file->cvector_file__length_m = length;
+
+  cvector_file_header_t *header = cvector_file__header_(file);
+  header->cvector_file_header__cap_m =
+      (length - CVECTOR_FILE__HEADER_SIZE) / header->cvector_file_header__elem_size_m;
+  return cvector_file__data_(file);
+}
+
+/* PRIVATE: Vectors are never handed a block from scratch, but keep the interface complete. */
+static inline void *cvector_file__alloc_(void *ctx, size_t size) {
+  return cvector_file__realloc_(ctx, NULL, 0, size);
+}
+
+/* PRIVATE: Keeps the mapping, which belongs to the file and is released by 'cvector__file_close'.
+ * Freeing the buffer (e.g. 'cvector__shrink_to_fit' of an empty vector) must not unmap it, the
+ * next growth maps the elements back in through 'cvector_file__realloc_'. */
+static inline void cvector_file__free_(void *ctx, void *mem, size_t size) {
+  (void)ctx;
+  (void)mem;
+  (void)size;
+}
+
+/* PRIVATE: Unmaps file and closes its descriptor. Does nothing if it is already closed. */
+static inline void cvector_file__close_(cvector_file_t *file) {
+  if (file->cvector_file__base_m != NULL) {
+    munmap(file->cvector_file__base_m, file->cvector_file__length_m);
+    close(file->cvector_file__fd_m);
+    file->cvector_file__base_m = NULL;
+    file->cvector_file__fd_m = -1;
+  }
+}
+
+/* PRIVATE: Opens and maps file, creating it in write mode. Returns false when the file is missing,
+ * truncated, of another version, holds elements of a size other than 'elem_size' or its header
+ * claims more elements than the file has room for. */
+static inline bool cvector_file__open_(cvector_file_t *file, const char *path, int mode,
+                                       size_t elem_size) {
+  bool writable = (mode == CVECTOR_FILE__RDWR);
+  int fd = writable ? open(path, O_RDWR | O_CREAT, 0644) : open(path, O_RDONLY);
+  if (fd == -1) {
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) == -1) {
+    close(fd);
+    return false;
+  }
+
+  size_t length = (size_t)st.st_size;
+  bool created = (length == 0) && writable;
+  if (created) {
+    length = CVECTOR_FILE__CHUNK_SIZE;
+    if (ftruncate(fd, (off_t)length) == -1) {
+      close(fd);
+      return false;
+    }
+  }
+
+  if (length < CVECTOR_FILE__HEADER_SIZE) {
+    close(fd);
+    return false;
+  }
+
+  int prot = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+  char *base = mmap(NULL, length, prot, MAP_SHARED, fd, 0);
+  if (base == MAP_FAILED) {
+    close(fd);
+    return false;
+  }
+
+  cvector_file_header_t *header = (cvector_file_header_t *)base;
+  if (created) {
+    memcpy(header->cvector_file_header__magic_m, "CVECTOR", 8);
+    header->cvector_file_header__version_m = CVECTOR_FILE__VERSION;
+    header->cvector_file_header__elem_size_m = (uint32_t)elem_size;
+    header->cvector_file_header__size_m = 0;
+    header->cvector_file_header__cap_m = (length - CVECTOR_FILE__HEADER_SIZE) / elem_size;
+  }
+
+  size_t room = (length - CVECTOR_FILE__HEADER_SIZE) / elem_size;
+  if ((memcmp(header->cvector_file_header__magic_m, "CVECTOR", 8) != 0) ||
+      (header->cvector_file_header__version_m != CVECTOR_FILE__VERSION) ||
+      (header->cvector_file_header__elem_size_m != elem_size) ||
+      (header->cvector_file_header__cap_m > room) ||
+      (header->cvector_file_header__size_m > header->cvector_file_header__cap_m)) {
+    munmap(base, length);
+    close(fd);
+    return false;
+  }
+
+  file->cvector_file__fd_m = fd;
+  file->cvector_file__base_m = base;
+  file->cvector_file__length_m = length;
+  file->cvector_file__writable_m = writable;
+  cvector_allocator__init(&(file->cvector_file__allocator_m), cvector_file__alloc_,
+                          cvector_file__realloc_, cvector_file__free_, file);
+  return true;
+}
+
+/* PUBLIC: Maps vector file at 'path' into 'vec' using 'file' as backing state.
+ *   - 'mode' is CVECTOR_FILE__RDONLY or CVECTOR_FILE__RDWR.
+ *   - Size of the vector is the element count stored in the file.
+ *   - Implicit shrinking is turned off, the file keeps its capacity.
+ * Returns -1 (error) if file can't be opened or doesn't hold elements of vector's type size.
+ */
+#define cvector__file_open(vec, file, path, mode)                                                  \
+  ({                                                                                               \
+    int cvector__result_m = -1;                                                                    \
+    if (cvector_file__open_((file), (path), (mode), cvector__elem_size_(vec))) {                   \
+      cvector_file_header_t *cvector__header_m = cvector_file__header_(file);                      \
+      cvector__init_with_allocator((vec), &((file)->cvector_file__allocator_m));                   \
+      cvector__set_elem_((vec), ((void *)cvector_file__data_(file)));                              \
+      cvector__setsize_((vec), (size_t)(cvector__header_m->cvector_file_header__size_m));          \
+      cvector__setcap_((vec), ((file)->cvector_file__writable_m                                    \
+                                   ? (size_t)(cvector__header_m->cvector_file_header__cap_m)       \
+                                   : cvector__size(vec)));                                         \
+      cvector__set_shrink((vec), false);                                                           \
+      cvector__result_m = 0;                                                                       \
+    }                                                                                              \
+    cvector__result_m;                                                                             \
+  })
+
+/* PUBLIC: Writes vector's size to the file header and flushes mapped pages to disk.
+ * Returns -1 (error) if the file is read only or flushing failed.
+ */
+#define cvector__file_sync(vec, file)                                                              \
+  ({                                                                                               \
+    int cvector__result_m = -1;                                                                    \
+    if ((file)->cvector_file__writable_m) {                                                        \
+      cvector_file__header_(file)->cvector_file_header__size_m = cvector__size(vec);               \
+      cvector__result_m = msync((file)->cvector_file__base_m, (file)->cvector_file__length_m,      \
+                                MS_SYNC);                                                          \
+    }                                                                                              \
+    cvector__result_m;                                                                             \
+  })
+
+/* PUBLIC: Syncs (in write mode), unmaps the file and closes it. 'vec' is freed.
+ * Closing a closed file does nothing. */
+#define cvector__file_close(vec, file)                                                             \
+  do {                                                                                             \
+    if ((file)->cvector_file__base_m != NULL) {                                                    \
+      if ((file)->cvector_file__writable_m) {                                                      \
+        cvector__file_sync((vec), (file));                                                         \
+      }                                                                                            \
+      cvector__free(vec);                                                                          \
+      cvector_file__close_(file);                                                                  \
+    }                                                                                              \
+  } while (0)
+
+#endif /* cvector_file_h */
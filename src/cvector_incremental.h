@@ -0,0 +1,228 @@
+/*
+ * Incrementally resized vectors for cvector.
+ *
+ * When a big 'CVector(T)' runs out of cap, the 'cvector__add' that hits the limit copies every
+ * element into the new buffer, which stalls the caller for as long as the copy takes.
+ * 'CVector_incremental(T)' spreads that copy over later adds instead:
+ *
+ *   - Running out of cap allocates the new buffer and keeps the old one around.
+ *   - Every add then migrates at most CVECTOR_INCREMENTAL__STEP elements from the old buffer,
+ *     front to back, so no single add costs more than O(CVECTOR_INCREMENTAL__STEP).
+ *   - Elements before the migration cursor (and every element added since the resize) are read
+ *     from the new buffer, the others from the old one.
+ *   - The cap at least doubles whatever the growth policy ('cvector__set_growth'), so migration is
+ *     over long before the new buffer fills up and no add ever has to finish it at once.
+ *
+ * For example:
+ *
+ * CVector_incremental(int) cvector_incremental_int_t;
+ *
+ * cvector_incremental_int_t vector;
+ * cvector__incremental_init(&vector);
+ *
+ * for (int i = 0; i < 100000000; i++) {
+ *   cvector__incremental_add(&vector, i);      // never copies more than a few elements
+ * }
+ * int value = cvector__incremental_index(&vector, 42);
+ *
+ * cvector__incremental_free(&vector);
+ *
+ * NOTE: References returned by 'cvector__incremental_index_ref' stay valid until the next add.
+ */
+
+#ifndef cvector_incremental_h
+#define cvector_incremental_h
+
+#include "cvector.h"
+
+#include <stdint.h>
+#include <sys/mman.h>
+
+/* Maximum number of elements migrated by one add. Must be at least 2 so that migration is over
+ * before a doubled buffer fills up. */
+#ifndef CVECTOR_INCREMENTAL__STEP
+#define CVECTOR_INCREMENTAL__STEP 64
+#endif
+
+/* Old buffers of at least this many bytes give their pages back while being migrated. */
+#ifndef CVECTOR_INCREMENTAL__RELEASE_BYTES
+#define CVECTOR_INCREMENTAL__RELEASE_BYTES (1024 * 1024)
+#endif
+
+/* Page size assumed when giving pages back. */
+#ifndef CVECTOR_INCREMENTAL__PAGE
+#define CVECTOR_INCREMENTAL__PAGE 4096
+#endif
+
+_Static_assert(CVECTOR_INCREMENTAL__STEP >= 2, "CVECTOR_INCREMENTAL__STEP must be at least 2");
+
+/*
+ * Macro to create incrementally resized vector type of elements of type 'cvector__elem_type_'.
+ * While migrating, elements [0, moved) and [old size, size) live in the new buffer, elements
+ * [moved, old size) in the old one.
+ */
+#define CVector_incremental(cvector__elem_type_)                                                   \
+  typedef struct {                                                                                 \
+    /* New buffer */                                                                               \
+    cvector__elem_type_ *cvector__elem_m;                                                          \
+    size_t cvector__size_m;                                                                        \
+    size_t cvector__cap_m;                                                                         \
+    unsigned int cvector__flags_m;                                                                 \
+    /* Old buffer, NULL when no migration is going on */                                           \
+    cvector__elem_type_ *cvector_incremental__old_m;                                               \
+    /* Size of old buffer, and number of its elements already migrated */                          \
+    size_t cvector_incremental__old_size_m;                                                        \
+    size_t cvector_incremental__moved_m;                                                           \
+  }
+
+/* PRIVATE: Migrates up to 'step' elements from old buffer to new one, freeing the old buffer once
+ * every element moved. Returns the old buffer, or NULL when migration is over.
+ * Pages of the old buffer are given back as soon as they're migrated: freeing a big, fully
+ * populated buffer in one go unmaps every page at once, which is a latency spike of its own. */
+static inline void *cvector_incremental__migrate_(void *elems, void *old, size_t elem_size,
+                                                  size_t old_size, size_t *moved, size_t step) {
+  size_t count = (old_size - *moved < step) ? old_size - *moved : step;
+  memcpy(((char *)elems) + *moved * elem_size, ((char *)old) + *moved * elem_size,
+         count * elem_size);
+
+#ifdef MADV_DONTNEED
+  // Only pages lying entirely inside the migrated part, each released once.
+  if (old_size * elem_size >= CVECTOR_INCREMENTAL__RELEASE_BYTES) {
+    uintptr_t page = CVECTOR_INCREMENTAL__PAGE;
+    uintptr_t first = ((uintptr_t)old + page - 1) & ~(page - 1);
+    uintptr_t begin = ((uintptr_t)old + *moved * elem_size) & ~(page - 1);
+    uintptr_t end = ((uintptr_t)old + (*moved + count) * elem_size) & ~(page - 1);
+    begin = (begin > first) ? begin : first;
+    if (end > begin) {
+      madvise((void *)begin, end - begin, MADV_DONTNEED);
+    }
+  }
+#endif
+
+  *moved += count;
+  if (*moved >= old_size) {
+    free(old);
+    return NULL;
+  }
+  return old;
+}
+
+/* PRIVATE: Migrates up to 'step' elements if a migration is going on. */
+#define cvector_incremental__step_(vec, step)                                                      \
+  do {                                                                                             \
+    if ((vec)->cvector_incremental__old_m != NULL) {                                               \
+      (vec)->cvector_incremental__old_m = cvector_incremental__migrate_(                           \
+          cvector__elem_(vec), (vec)->cvector_incremental__old_m, sizeof(*cvector__elem_(vec)),    \
+          (vec)->cvector_incremental__old_size_m, &((vec)->cvector_incremental__moved_m), (step)); \
+    }                                                                                              \
+  } while (0)
+
+/* PRIVATE: Starts a migration into a new buffer sized by the growth policy, but at least twice as
+ * big as the current one. Nothing changes if the new buffer can't be allocated. */
+#define cvector_incremental__grow_(vec)                                                            \
+  do {                                                                                             \
+    cvector__incremental_flush(vec);                                                               \
+    size_t cvector__new_cap_m =                                                                    \
+        cvector__grow_cap_((cvector__flags_(vec)), sizeof(*cvector__elem_(vec)),                   \
+                           (cvector__cap_(vec)), (cvector__size(vec) + 1));                        \
+    if (cvector__new_cap_m < 2 * cvector__cap_(vec)) {                                             \
+      cvector__new_cap_m = 2 * cvector__cap_(vec);                                                 \
+    }                                                                                              \
+    void *cvector__mem_m = malloc(cvector__new_cap_m * sizeof(*cvector__elem_(vec)));              \
+    if (cvector__mem_m != NULL) {                                                                  \
+      if (cvector__size(vec) > 0) {                                                                \
+        (vec)->cvector_incremental__old_m = cvector__elem_(vec);                                   \
+        (vec)->cvector_incremental__old_size_m = cvector__size(vec);                               \
+        (vec)->cvector_incremental__moved_m = 0;                                                   \
+      } else {                                                                                     \
+        free(cvector__elem_(vec));                                                                 \
+      }                                                                                            \
+      cvector__set_elem_((vec), cvector__mem_m);                                                   \
+      cvector__setcap_((vec), cvector__new_cap_m);                                                 \
+    }                                                                                              \
+  } while (0)
+
+/* PUBLIC: Initializes empty vector, no allocation is made until the first add. */
+#define cvector__incremental_init(vec)                                                             \
+  do {                                                                                             \
+    cvector__set_elem_((vec), NULL);                                                               \
+    cvector__setsize_((vec), 0);                                                                   \
+    cvector__setcap_((vec), 0);                                                                    \
+    cvector__set_flags_((vec), (CVECTOR__DEFAULT_GROWTH << CVECTOR__GROWTH_SHIFT_));               \
+    (vec)->cvector_incremental__old_m = NULL;                                                      \
+    (vec)->cvector_incremental__old_size_m = 0;                                                    \
+    (vec)->cvector_incremental__moved_m = 0;                                                       \
+  } while (0)
+
+/* PUBLIC: Returns whether a migration is going on. */
+#define cvector__incremental_migrating(vec) ((vec)->cvector_incremental__old_m != NULL)
+
+/* PUBLIC: Finishes the current migration at once, if any. */
+#define cvector__incremental_flush(vec) cvector_incremental__step_((vec), (~(size_t)0))
+
+/* PUBLIC: Returns reference to element at given index, from the buffer currently holding it.
+ * Stays valid until the next add. */
+#define cvector__incremental_index_ref(vec, index)                                                 \
+  ({                                                                                               \
+    size_t cvector__at_m = (index);                                                                \
+    (((vec)->cvector_incremental__old_m != NULL) &&                                                \
+     (cvector__at_m >= (vec)->cvector_incremental__moved_m) &&                                     \
+     (cvector__at_m < (vec)->cvector_incremental__old_size_m))                                     \
+        ? &((vec)->cvector_incremental__old_m[cvector__at_m])                                      \
+        : &(cvector__elem_(vec)[cvector__at_m]);                                                   \
+  })
+
+/* PUBLIC: Returns element at given index. */
+#define cvector__incremental_index(vec, index) (*cvector__incremental_index_ref((vec), (index)))
+
+/* PUBLIC: Returns last element. Vector must not be empty. */
+#define cvector__incremental_last(vec)                                                             \
+  (cvector__incremental_index((vec), (cvector__size(vec) - 1)))
+
+/* PUBLIC: Adds element at the back, migrating at most CVECTOR_INCREMENTAL__STEP elements.
+ * The element is dropped if memory can't be allocated. */
+#define cvector__incremental_add(vec, val)                                                         \
+  do {                                                                                             \
+    if (cvector__size(vec) >= cvector__cap_(vec)) {                                                \
+      cvector_incremental__grow_(vec);                                                             \
+    }                                                                                              \
+    cvector_incremental__step_((vec), CVECTOR_INCREMENTAL__STEP);                                  \
+    if (cvector__size(vec) < cvector__cap_(vec)) {                                                 \
+      (cvector__elem_(vec)[cvector__size(vec)]) = (val);                                           \
+      cvector__setsize_((vec), (cvector__size(vec) + 1));                                          \
+    }                                                                                              \
+  } while (0)
+
+/* PUBLIC: Removes and returns last element. Vector must not be empty. */
+#define cvector__incremental_pop(vec)                                                              \
+  ({                                                                                               \
+    __typeof__(*cvector__elem_(vec)) cvector__value_m =                                            \
+        cvector__incremental_index((vec), (cvector__size(vec) - 1));                               \
+    cvector__setsize_((vec), (cvector__size(vec) - 1));                                            \
+    if ((vec)->cvector_incremental__old_size_m > cvector__size(vec)) {                             \
+      (vec)->cvector_incremental__old_size_m = cvector__size(vec);                                 \
+    }                                                                                              \
+    cvector_incremental__step_((vec), 0);                                                          \
+    cvector__value_m;                                                                              \
+  })
+
+/* PUBLIC: Removes every element, keeping the new buffer. */
+#define cvector__incremental_clear(vec)                                                            \
+  do {                                                                                             \
+    free((vec)->cvector_incremental__old_m);                                                       \
+    (vec)->cvector_incremental__old_m = NULL;                                                      \
+    (vec)->cvector_incremental__old_size_m = 0;                                                    \
+    (vec)->cvector_incremental__moved_m = 0;                                                       \
+    cvector__setsize_((vec), 0);                                                                   \
+  } while (0)
+
+/* PUBLIC: Frees both buffers. */
+#define cvector__incremental_free(vec)                                                             \
+  do {                                                                                             \
+    cvector__incremental_clear(vec);                                                               \
+    free(cvector__elem_(vec));                                                                     \
+    cvector__set_elem_((vec), NULL);                                                               \
+    cvector__setcap_((vec), 0);                                                                    \
+  } while (0)
+
+#endif /* cvector_incremental_h */
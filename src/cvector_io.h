@@ -0,0 +1,249 @@
+/*
+ * Streaming serialization of cvector to file descriptors.
+ *
+ * A stream is a sequence of frames. Every frame is a 16 byte header followed by the raw elements:
+ *
+ *   magic (u32) | element size (u32) | element count (u64) | elements ...
+ *
+ * and a stream is terminated by an end frame (element size 0, count 0), or simply by EOF.
+ *
+ * 'cvector__write_fd' sends header and element buffer with a single writev, straight from the
+ * vector. 'cvector__read_fd' reads the header first, reserves exactly the announced count (one
+ * allocation at most) and reads the elements straight into the vector's buffer.
+ *
+ *   cvector__write_fd(fd, &vector_int);
+ *   cvector__write_fd_end(fd);
+ *
+ *   while (cvector__read_fd(fd, &vector_int) == 1) {
+ *     // vector_int holds next frame
+ *   }
+ *
+ * Vectors larger than memory are streamed in chunks. A producer writes many frames from a reused
+ * vector. A consumer reading with 'cvector__read_fd_chunk' receives at most 'max' elements per call
+ * regardless of how the frames were cut, so its memory is bounded by 'max':
+ *
+ *   cvector_io_reader_t reader;
+ *   cvector_io_reader__init(&reader);
+ *
+ *   while (cvector__read_fd_chunk(fd, &vector_int, &reader, 4096) == 1) {
+ *     // vector_int holds up to 4096 elements
+ *   }
+ *
+ * NOTE: Elements are sent as raw bytes in host byte order, only plain old data should be streamed.
+ */
+
+#ifndef cvector_io_h
+#define cvector_io_h
+
+#include "cvector.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/* Magic of every frame header ("CVF1" in little endian). */
+#define CVECTOR_IO__MAGIC 0x31465643u
+
+/* Largest frame, in bytes of elements, accepted by readers. Frames announcing more are refused
+ * before anything is allocated. Lower it when reading from untrusted peers. */
+#ifndef CVECTOR_IO__MAX_FRAME_BYTES
+#define CVECTOR_IO__MAX_FRAME_BYTES SIZE_MAX
+#endif
+
+/* PRIVATE: Frame header. */
+typedef struct {
+  uint32_t cvector_io_frame__magic_m;
+  /* sizeof element, 0 for end frame */
+  uint32_t cvector_io_frame__elem_size_m;
+  /* Number of elements that follow */
+  uint64_t cvector_io_frame__count_m;
+} cvector_io_frame_t;
+
+/* State of chunked reader. */
+typedef struct {
+  /* Elements of current frame not handed out yet. */
+  uint64_t cvector_io_reader__remaining_m;
+} cvector_io_reader_t;
+
+/* PUBLIC: Initializes chunked reader. */
+#define cvector_io_reader__init(reader) ((reader)->cvector_io_reader__remaining_m = 0)
+
+/* PRIVATE: Writes all 'iov' buffers, resuming after partial writes. Returns false on error. */
+static inline bool cvector_io__writev_all_(int fd, struct iovec *iov, int iovcnt) {
+  while (iovcnt > 0) {
+    ssize_t written = writev(fd, iov, iovcnt);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+
+    while ((iovcnt > 0) && ((size_t)written >= iov->iov_len)) {
+      written -= (ssize_t)iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+
+    if (iovcnt > 0) {
+      iov->iov_base = ((char *)iov->iov_base) + written;
+      iov->iov_len -= (size_t)written;
+    }
+  }
+  return true;
+}
+
+/* PRIVATE: Reads exactly 'size' bytes into 'mem'. Returns bytes read before EOF, or -1 on error. */
+static inline ssize_t cvector_io__read_all_(int fd, void *mem, size_t size) {
+  size_t done = 0;
+  while (done < size) {
+    ssize_t got = read(fd, ((char *)mem) + done, size - done);
+    if (got < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return -1;
+    }
+
+    if (got == 0) {
+      break;
+    }
+    done += (size_t)got;
+  }
+  return (ssize_t)done;
+}
+
+/* PRIVATE: Writes frame of 'count' elements of 'elem_size' bytes from 'mem' with one writev.
+ * Returns 0 on success and -1 (errno set) on error. */
+static inline int cvector_io__write_frame_(int fd, const void *mem, size_t elem_size,
+                                           size_t count) {
+  cvector_io_frame_t frame = {.cvector_io_frame__magic_m = CVECTOR_IO__MAGIC,
+                              .cvector_io_frame__elem_size_m = (uint32_t)elem_size,
+                              .cvector_io_frame__count_m = (uint64_t)count};
+
+  struct iovec iov[2] = {{.iov_base = &frame, .iov_len = sizeof(frame)},
+                         {.iov_base = (void *)mem, .iov_len = elem_size * count}};
+  return cvector_io__writev_all_(fd, iov, (count > 0) ? 2 : 1) ? 0 : -1;
+}
+
+/* PRIVATE: Reads next frame header and stores its count in 'count'.
+ * Returns 1 for data frame, 0 for end of stream (end frame or EOF) and -1 on error (short header,
+ * bad magic, elements of another size, more than CVECTOR_IO__MAX_FRAME_BYTES: errno is set to
+ * EPROTO). */
+static inline int cvector_io__read_frame_(int fd, size_t elem_size, uint64_t *count) {
+  cvector_io_frame_t frame;
+  ssize_t got = cvector_io__read_all_(fd, &frame, sizeof(frame));
+  if (got == 0) {
+    return 0;
+  }
+
+  if (got != (ssize_t)sizeof(frame)) {
+    if (got >= 0) {
+      errno = EPROTO;
+    }
+    return -1;
+  }
+
+  if (frame.cvector_io_frame__magic_m != CVECTOR_IO__MAGIC) {
+    errno = EPROTO;
+    return -1;
+  }
+
+  if (frame.cvector_io_frame__elem_size_m == 0) {
+    return 0;
+  }
+
+  if ((frame.cvector_io_frame__elem_size_m != elem_size) ||
+      (frame.cvector_io_frame__count_m > CVECTOR_IO__MAX_FRAME_BYTES / elem_size)) {
+    errno = EPROTO;
+    return -1;
+  }
+
+  *count = frame.cvector_io_frame__count_m;
+  return 1;
+}
+
+/* PRIVATE: Reads 'count' elements (checked by 'cvector_io__read_frame_' to fit in memory) into
+ * vector buffer, replacing its content. Returns 1 on success and -1 on error: ENOMEM if the buffer
+ * can't be allocated, the vector is then unchanged, EPROTO if the stream ends early. */
+#define cvector_io__read_elements_(fd, vec, count)                                                 \
+  ({                                                                                               \
+    size_t cvector__elements_m = (count);                                                          \
+    size_t cvector__bytes_m = cvector__elements_m * cvector__elem_size_(vec);                      \
+    int cvector__result_m = -1;                                                                    \
+    if (cvector__unshare(vec) == 0) {                                                              \
+      cvector__reserve((vec), cvector__elements_m);                                                \
+    }                                                                                              \
+    if (cvector__shared(vec) || (cvector__cap_(vec) < cvector__elements_m)) {                      \
+      errno = ENOMEM;                                                                              \
+    } else {                                                                                       \
+      ssize_t cvector__got_m =                                                                     \
+          cvector_io__read_all_((fd), (cvector__elem_(vec)), cvector__bytes_m);                    \
+      if ((size_t)cvector__got_m == cvector__bytes_m) {                                            \
+        cvector__setsize_((vec), cvector__elements_m);                                             \
+        cvector__result_m = 1;                                                                     \
+      } else {                                                                                     \
+        cvector__setsize_((vec), 0);                                                               \
+        if (cvector__got_m >= 0) {                                                                 \
+          errno = EPROTO;                                                                          \
+        }                                                                                          \
+      }                                                                                            \
+    }                                                                                              \
+    cvector__result_m;                                                                             \
+  })
+
+/* PUBLIC: Writes vector as one frame. Returns 0 on success and -1 (errno set) on error. */
+#define cvector__write_fd(fd, vec)                                                                 \
+  (cvector_io__write_frame_((fd), (cvector__elem_(vec)), cvector__elem_size_(vec),                 \
+                            cvector__size(vec)))
+
+/* PUBLIC: Writes end frame that terminates the stream. Returns 0 on success and -1 on error. */
+#define cvector__write_fd_end(fd) (cvector_io__write_frame_((fd), NULL, 0, 0))
+
+/* PUBLIC: Reads next frame into vector, replacing its content.
+ * Reserves exactly the count announced by the frame, so it makes one allocation at most.
+ * Returns 1 if a frame was read, 0 at end of stream and -1 (errno set) on error: EPROTO for a
+ * malformed or truncated stream, ENOMEM if the elements can't be allocated (vector unchanged).
+ */
+#define cvector__read_fd(fd, vec)                                                                  \
+  ({                                                                                               \
+    uint64_t cvector__frame_count_m = 0;                                                           \
+    int cvector__result_m =                                                                        \
+        cvector_io__read_frame_((fd), cvector__elem_size_(vec), &cvector__frame_count_m);          \
+    if (cvector__result_m == 1) {                                                                  \
+      cvector__result_m = cvector_io__read_elements_((fd), (vec), cvector__frame_count_m);         \
+    }                                                                                              \
+    cvector__result_m;                                                                             \
+  })
+
+/* PUBLIC: Reads at most 'max' next elements of the stream into vector, replacing its content.
+ * Frames are split or walked through as needed, so vector never holds more than 'max' elements.
+ * Returns 1 if elements were read, 0 at end of stream and -1 (errno set) on error: EINVAL if 'max'
+ * is 0, nothing is read then, and the errors of 'cvector__read_fd'. After ENOMEM the reader still
+ * points at the elements that couldn't be read, so the call can be retried.
+ */
+#define cvector__read_fd_chunk(fd, vec, reader, max)                                               \
+  ({                                                                                               \
+    uint64_t cvector__max_m = (max);                                                               \
+    int cvector__result_m = 1;                                                                     \
+    if (cvector__max_m == 0) {                                                                     \
+      errno = EINVAL;                                                                              \
+      cvector__result_m = -1;                                                                      \
+    }                                                                                              \
+    while ((cvector__result_m == 1) && ((reader)->cvector_io_reader__remaining_m == 0)) {          \
+      cvector__result_m = cvector_io__read_frame_((fd), cvector__elem_size_(vec),                  \
+                                                  &((reader)->cvector_io_reader__remaining_m));    \
+    }                                                                                              \
+    if (cvector__result_m == 1) {                                                                  \
+      uint64_t cvector__chunk_m = (reader)->cvector_io_reader__remaining_m;                        \
+      cvector__chunk_m = (cvector__chunk_m < cvector__max_m) ? cvector__chunk_m : cvector__max_m;  \
+      cvector__result_m = cvector_io__read_elements_((fd), (vec), cvector__chunk_m);               \
+      if (cvector__result_m == 1) {                                                                \
+        (reader)->cvector_io_reader__remaining_m -= cvector__chunk_m;                              \
+      }                                                                                            \
+    }                                                                                              \
+    cvector__result_m;                                                                             \
+  })
+
+#endif /* cvector_io_h */
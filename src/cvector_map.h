@@ -0,0 +1,454 @@
+/*
+ * Hash maps for cvector.
+ *
+ * A 'CVector' of key/value pairs searched linearly makes a fine map for a handful of keys, and an
+ * O(n) one past that. 'CMap(K, V)' keeps the pairs in the same dense 'CVector' and adds an open
+ * addressing index in front of it, after SwissTable:
+ *
+ *   - The index is a table of slots, each holding the position of an entry, and one control byte
+ *     per slot: EMPTY, DELETED, or the top 7 bits of the key's hash.
+ *   - Slots are probed CMAP__GROUP at a time: one SSE2 compare of the group's control bytes finds
+ *     every slot whose 7 bits match, so a lookup compares keys only for those, and usually just
+ *     once. The next group is only probed when the group has no EMPTY slot.
+ *   - Entries stay packed in a 'CVector', so iterating the map is iterating an array. Removing an
+ *     entry moves the last one into its place: entries are in insertion order until a removal.
+ *   - The index is rebuilt at twice the size once 7/8 of the slots are used (DELETED included).
+ *
+ * Keys are hashed and compared with 'cmap__hash_default' and 'cmap__eq_default' (their bytes),
+ * which suit integers, pointers and structs without padding. The '_with' variants take any hash
+ * ('uint64_t hash(K key)') and equality ('bool eq(K a, K b)'), functions or macros, for instance
+ * 'cmap__hash_str' and 'cmap__eq_str' for C strings. A map must always use the same pair.
+ *
+ * For example:
+ *
+ * CMap(int, double) cmap_int_double_t;
+ *
+ * cmap_int_double_t prices;
+ * cmap__init(&prices);
+ *
+ * cmap__put(&prices, 42, 9.99);
+ * double *price = cmap__get_ref(&prices, 42);           // NULL if missing
+ * double other = cmap__get(&prices, 7, 0.0);             // 0.0 if missing
+ * cmap__remove(&prices, 42);
+ *
+ * for (size_t i = 0; i < cmap__size(&prices); i++) {
+ *   printf("%d: %f\n", cmap__key_at(&prices, i), cmap__value_at(&prices, i));
+ * }
+ *
+ * cmap__free(&prices);
+ *
+ * NOTE: References to values stay valid until the next put or remove.
+ */
+
+#ifndef cvector_map_h
+#define cvector_map_h
+
+#include "cvector.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* Number of slots probed at once. */
+#define CMAP__GROUP 16
+
+/* PRIVATE: Control byte of a slot that never held an entry. */
+#define CMAP__EMPTY_ 0x80
+/* PRIVATE: Control byte of a slot whose entry was removed. Probes go on past it. */
+#define CMAP__DELETED_ 0xfe
+
+/*
+ * Macro to create map type from keys of type 'cmap__key_type_' to values of type
+ * 'cmap__value_type_'. Slot positions are 32 bits, a map holds fewer than 2^32 entries.
+ */
+#define CMap(cmap__key_type_, cmap__value_type_)                                                   \
+  typedef struct {                                                                                 \
+    /* Entries, packed in a vector */                                                              \
+    struct {                                                                                       \
+      CVECTOR__FIELDS_(struct {                                                                    \
+        cmap__key_type_ cmap__key_m;                                                               \
+        cmap__value_type_ cmap__value_m;                                                           \
+      })                                                                                           \
+    } cmap__entries_m;                                                                             \
+    /* Control bytes of the slots, followed by the slots (NULL before the first put) */            \
+    uint8_t *cmap__ctrl_m;                                                                         \
+    /* Number of slots, a power of 2 and a multiple of CMAP__GROUP (0 before the first put) */     \
+    size_t cmap__cap_m;                                                                            \
+    /* Number of EMPTY slots that can still be used before the index is rebuilt */                 \
+    size_t cmap__growth_left_m;                                                                    \
+  }
+
+/* PRIVATE: Vector of entries. */
+#define cmap__entries_(map) (&((map)->cmap__entries_m))
+
+/* PRIVATE: Entry positions of the slots. */
+#define cmap__slots_(map) ((uint32_t *)(void *)((map)->cmap__ctrl_m + (map)->cmap__cap_m))
+
+/* PRIVATE: Control byte stored for 'hash'. */
+#define cmap__h2_(hash) ((uint8_t)((hash) >> 57))
+
+/* PRIVATE: Mixes bits of 'x' so that each one depends on all of them (MurmurHash3 finalizer). */
+static inline uint64_t cmap__mix_(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+/* PRIVATE: Hash of 'size' bytes, 8 at a time. */
+static inline uint64_t cmap__hash_bytes_(const void *data, size_t size) {
+  const unsigned char *bytes = data;
+  uint64_t hash = 0x9e3779b97f4a7c15ULL ^ size;
+  for (; size >= 8; bytes += 8, size -= 8) {
+    uint64_t word;
+    memcpy(&word, bytes, 8);
+    hash = cmap__mix_(hash ^ word);
+  }
+  if (size > 0) {
+    uint64_t word = 0;
+    memcpy(&word, bytes, size);
+    hash = cmap__mix_(hash ^ word);
+  }
+  return hash;
+}
+
+/* PUBLIC: Hash of the bytes of 'key'. */
+#define cmap__hash_default(key)                                                                    \
+  ({                                                                                               \
+    __typeof__(key) cmap__hashed_m = (key);                                                        \
+    cmap__hash_bytes_(&cmap__hashed_m, sizeof(cmap__hashed_m));                                    \
+  })
+
+/* PUBLIC: Whether the bytes of 'a' and 'b' are the same. */
+#define cmap__eq_default(a, b)                                                                     \
+  ({                                                                                               \
+    __typeof__(a) cmap__a_m = (a);                                                                 \
+    __typeof__(a) cmap__b_m = (b);                                                                 \
+    (memcmp(&cmap__a_m, &cmap__b_m, sizeof(cmap__a_m)) == 0);                                      \
+  })
+
+/* PUBLIC: Hash of C string 'key'. */
+static inline uint64_t cmap__hash_str(const char *key) {
+  return cmap__hash_bytes_(key, strlen(key));
+}
+
+/* PUBLIC: Whether C strings 'a' and 'b' are the same. */
+static inline bool cmap__eq_str(const char *a, const char *b) { return strcmp(a, b) == 0; }
+
+/* PRIVATE: Bit i is set when control byte i of 'group' is 'byte'. */
+static inline unsigned int cmap__match_(const uint8_t *group, uint8_t byte) {
+#if defined(__SSE2__)
+  __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+  return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)byte)));
+#else
+  unsigned int mask = 0;
+  for (unsigned int i = 0; i < CMAP__GROUP; i++) {
+    mask |= (unsigned int)(group[i] == byte) << i;
+  }
+  return mask;
+#endif
+}
+
+/* PRIVATE: Bit i is set when slot i of 'group' is EMPTY or DELETED (the control bytes with the top
+ * bit set). */
+static inline unsigned int cmap__match_free_(const uint8_t *group) {
+#if defined(__SSE2__)
+  return (unsigned int)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)group));
+#else
+  unsigned int mask = 0;
+  for (unsigned int i = 0; i < CMAP__GROUP; i++) {
+    mask |= (unsigned int)(group[i] >> 7) << i;
+  }
+  return mask;
+#endif
+}
+
+/* PRIVATE: Smallest number of slots holding 'size' entries under the 7/8 load limit. */
+static inline size_t cmap__cap_for_(size_t size) {
+  size_t cap = CMAP__GROUP;
+  while (cap - cap / 8 < size) {
+    cap *= 2;
+  }
+  return cap;
+}
+
+/* PRIVATE: Allocates control bytes and slots of a table of 'cap' slots, all EMPTY. */
+static inline uint8_t *cmap__table_new_(size_t cap) {
+  uint8_t *ctrl = malloc(cap + cap * sizeof(uint32_t));
+  if (ctrl != NULL) {
+    memset(ctrl, CMAP__EMPTY_, cap);
+  }
+  return ctrl;
+}
+
+/* PRIVATE: First EMPTY or DELETED slot on the probe sequence of 'hash'. Groups are probed in
+ * triangular order, which visits each of them once when their number is a power of 2. */
+static inline size_t cmap__free_slot_(const uint8_t *ctrl, size_t cap, uint64_t hash) {
+  size_t group_mask = cap / CMAP__GROUP - 1;
+  size_t group = (size_t)hash & group_mask;
+  for (size_t step = 1;; step++) {
+    unsigned int free_mask = cmap__match_free_(ctrl + group * CMAP__GROUP);
+    if (free_mask != 0) {
+      return group * CMAP__GROUP + (size_t)__builtin_ctz(free_mask);
+    }
+    group = (group + step) & group_mask;
+  }
+}
+
+/* PRIVATE: Slot pointing at entry 'index', whose key hashes to 'hash'. */
+static inline size_t cmap__slot_of_(const uint8_t *ctrl, size_t cap, uint64_t hash,
+                                    uint32_t index) {
+  const uint32_t *slots = (const uint32_t *)(const void *)(ctrl + cap);
+  size_t group_mask = cap / CMAP__GROUP - 1;
+  size_t group = (size_t)hash & group_mask;
+  for (size_t step = 1;; step++) {
+    unsigned int match = cmap__match_(ctrl + group * CMAP__GROUP, cmap__h2_(hash));
+    for (; match != 0; match &= match - 1) {
+      size_t slot = group * CMAP__GROUP + (size_t)__builtin_ctz(match);
+      if (slots[slot] == index) {
+        return slot;
+      }
+    }
+    group = (group + step) & group_mask;
+  }
+}
+
+/* PRIVATE: Marks slot 'slot' free. It becomes EMPTY when its group has an EMPTY slot: no probe
+ * ever went past that group, so none needs to go past this slot. */
+static inline void cmap__release_slot_(uint8_t *ctrl, size_t slot, size_t *growth_left) {
+  uint8_t *group = ctrl + (slot & ~(size_t)(CMAP__GROUP - 1));
+  if (cmap__match_(group, CMAP__EMPTY_) != 0) {
+    ctrl[slot] = CMAP__EMPTY_;
+    (*growth_left)++;
+  } else {
+    ctrl[slot] = CMAP__DELETED_;
+  }
+}
+
+/* PRIVATE: Slot of the entry with key 'key' of hash 'hash', or -1 if there is none. */
+#define cmap__find_slot_(map, key, hash, eq)                                                       \
+  ({                                                                                               \
+    ptrdiff_t cmap__found_m = -1;                                                                  \
+    if ((map)->cmap__cap_m > 0) {                                                                  \
+      uint64_t cmap__probe_hash_m = (hash);                                                        \
+      const uint8_t *cmap__ctrl_m = (map)->cmap__ctrl_m;                                           \
+      const uint32_t *cmap__slots_m = cmap__slots_(map);                                           \
+      size_t cmap__group_mask_m = (map)->cmap__cap_m / CMAP__GROUP - 1;                            \
+      size_t cmap__group_m = (size_t)cmap__probe_hash_m & cmap__group_mask_m;                      \
+      for (size_t cmap__step_m = 1;; cmap__step_m++) {                                             \
+        const uint8_t *cmap__probed_m = cmap__ctrl_m + cmap__group_m * CMAP__GROUP;                \
+        unsigned int cmap__match_m = cmap__match_(cmap__probed_m, cmap__h2_(cmap__probe_hash_m));  \
+        for (; cmap__match_m != 0; cmap__match_m &= cmap__match_m - 1) {                           \
+          size_t cmap__slot_m =                                                                    \
+              cmap__group_m * CMAP__GROUP + (size_t)__builtin_ctz(cmap__match_m);                  \
+          if (eq(cvector__index(cmap__entries_(map), cmap__slots_m[cmap__slot_m]).cmap__key_m,     \
+                 (key))) {                                                                         \
+            cmap__found_m = (ptrdiff_t)cmap__slot_m;                                               \
+            break;                                                                                 \
+          }                                                                                        \
+        }                                                                                          \
+        if ((cmap__found_m >= 0) || (cmap__match_(cmap__probed_m, CMAP__EMPTY_) != 0)) {           \
+          break;                                                                                   \
+        }                                                                                          \
+        cmap__group_m = (cmap__group_m + cmap__step_m) & cmap__group_mask_m;                       \
+      }                                                                                            \
+    }                                                                                              \
+    cmap__found_m;                                                                                 \
+  })
+
+/* PRIVATE: Rebuilds the index with 'cap' slots, hashing every key again.
+ * Returns -1 (error) if the new table can't be allocated, the map is then unchanged. */
+#define cmap__rehash_(map, cap, hash)                                                              \
+  ({                                                                                               \
+    int cmap__result_m = -1;                                                                       \
+    size_t cmap__new_cap_m = (cap);                                                                \
+    uint8_t *cmap__new_ctrl_m = cmap__table_new_(cmap__new_cap_m);                                 \
+    if (cmap__new_ctrl_m != NULL) {                                                                \
+      free((map)->cmap__ctrl_m);                                                                   \
+      (map)->cmap__ctrl_m = cmap__new_ctrl_m;                                                      \
+      (map)->cmap__cap_m = cmap__new_cap_m;                                                        \
+      (map)->cmap__growth_left_m =                                                                 \
+          cmap__new_cap_m - cmap__new_cap_m / 8 - cvector__size(cmap__entries_(map));              \
+      for (size_t cmap__i_m = 0; cmap__i_m < cvector__size(cmap__entries_(map)); cmap__i_m++) {    \
+        uint64_t cmap__hash_m = hash(cvector__index(cmap__entries_(map), cmap__i_m).cmap__key_m);  \
+        size_t cmap__slot_m = cmap__free_slot_(cmap__new_ctrl_m, cmap__new_cap_m, cmap__hash_m);   \
+        cmap__new_ctrl_m[cmap__slot_m] = cmap__h2_(cmap__hash_m);                                  \
+        cmap__slots_(map)[cmap__slot_m] = (uint32_t)cmap__i_m;                                     \
+      }                                                                                            \
+      cmap__result_m = 0;                                                                          \
+    }                                                                                              \
+    cmap__result_m;                                                                                \
+  })
+
+/* PRIVATE: Type of keys. */
+#define cmap__key_type_(map) __typeof__(cvector__elem_(cmap__entries_(map))->cmap__key_m)
+
+/* PUBLIC: Initializes empty map, no allocation is made until the first put. */
+#define cmap__init(map)                                                                            \
+  do {                                                                                             \
+    cvector__init(cmap__entries_(map));                                                            \
+    (map)->cmap__ctrl_m = NULL;                                                                    \
+    (map)->cmap__cap_m = 0;                                                                        \
+    (map)->cmap__growth_left_m = 0;                                                                \
+  } while (0)
+
+/* PUBLIC: Returns number of entries. */
+#define cmap__size(map) (cvector__size(cmap__entries_(map)))
+
+/* PUBLIC: Returns key of entry at given position, 0 <= index < cmap__size(map). */
+#define cmap__key_at(map, index) (cvector__index(cmap__entries_(map), (index)).cmap__key_m)
+
+/* PUBLIC: Returns value of entry at given position. */
+#define cmap__value_at(map, index) (cvector__index(cmap__entries_(map), (index)).cmap__value_m)
+
+/* PUBLIC: Returns reference to value of entry at given position. */
+#define cmap__value_ref_at(map, index)                                                             \
+  (&(cvector__index(cmap__entries_(map), (index)).cmap__value_m))
+
+/* PUBLIC: Makes room for 'size' entries, so that no put rebuilds the index before that.
+ * Returns -1 (error) if memory can't be allocated. */
+#define cmap__reserve_with(map, size, hash)                                                        \
+  ({                                                                                               \
+    size_t cmap__wanted_m = (size);                                                                \
+    int cmap__result_m = 0;                                                                        \
+    if (cmap__cap_for_(cmap__wanted_m) > (map)->cmap__cap_m) {                                     \
+      cmap__result_m = cmap__rehash_((map), cmap__cap_for_(cmap__wanted_m), hash);                 \
+    }                                                                                              \
+    cvector__reserve(cmap__entries_(map), cmap__wanted_m);                                         \
+    (cvector__cap_(cmap__entries_(map)) < cmap__wanted_m) ? -1 : cmap__result_m;                   \
+  })
+
+/* PUBLIC: Sets value of 'key' to 'value', adding the entry if the key is missing.
+ * Returns -1 (error) if memory can't be allocated, the map is then unchanged. */
+#define cmap__put_with(map, key, value, hash, eq)                                                  \
+  ({                                                                                               \
+    cmap__key_type_(map) cmap__key_m = (key);                                                      \
+    uint64_t cmap__hash_m = hash(cmap__key_m);                                                     \
+    ptrdiff_t cmap__slot_m = cmap__find_slot_((map), cmap__key_m, cmap__hash_m, eq);               \
+    int cmap__result_m = 0;                                                                        \
+    if (cmap__slot_m >= 0) {                                                                       \
+      cmap__value_at((map), cmap__slots_(map)[cmap__slot_m]) = (value);                            \
+    } else {                                                                                       \
+      size_t cmap__size_m = cmap__size(map);                                                       \
+      if (__builtin_expect((map)->cmap__growth_left_m == 0, 0)) {                                  \
+        cmap__result_m = cmap__rehash_((map), cmap__cap_for_((cmap__size_m + 1) * 2), hash);       \
+      }                                                                                            \
+      if (cmap__size_m >= cvector__cap_(cmap__entries_(map))) {                                    \
+        cvector__grow_(cmap__entries_(map), cmap__size_m + 1);                                     \
+      }                                                                                            \
+      if ((cmap__result_m == 0) && (cmap__size_m < cvector__cap_(cmap__entries_(map))) &&          \
+          (cmap__size_m < UINT32_MAX)) {                                                           \
+        size_t cmap__free_m =                                                                      \
+            cmap__free_slot_((map)->cmap__ctrl_m, (map)->cmap__cap_m, cmap__hash_m);               \
+        (map)->cmap__growth_left_m -= ((map)->cmap__ctrl_m[cmap__free_m] == CMAP__EMPTY_);         \
+        (map)->cmap__ctrl_m[cmap__free_m] = cmap__h2_(cmap__hash_m);                               \
+        cmap__slots_(map)[cmap__free_m] = (uint32_t)cmap__size_m;                                  \
+        cmap__key_at((map), cmap__size_m) = cmap__key_m;                                           \
+        cmap__value_at((map), cmap__size_m) = (value);                                             \
+        cvector__setsize_(cmap__entries_(map), cmap__size_m + 1);                                  \
+        cvector__stats_add_(cmap__entries_(map), 1);                                               \
+      } else {                                                                                     \
+        cmap__result_m = -1;                                                                       \
+      }                                                                                            \
+    }                                                                                              \
+    cmap__result_m;                                                                                \
+  })
+
+/* PUBLIC: Returns reference to value of 'key', or NULL if the key is missing. */
+#define cmap__get_ref_with(map, key, hash, eq)                                                     \
+  ({                                                                                               \
+    cmap__key_type_(map) cmap__key_m = (key);                                                      \
+    ptrdiff_t cmap__slot_m = cmap__find_slot_((map), cmap__key_m, hash(cmap__key_m), eq);          \
+    (cmap__slot_m >= 0) ? cmap__value_ref_at((map), cmap__slots_(map)[cmap__slot_m]) : NULL;       \
+  })
+
+/* PUBLIC: Returns value of 'key', or 'fallback' if the key is missing. */
+#define cmap__get_with(map, key, fallback, hash, eq)                                               \
+  ({                                                                                               \
+    __typeof__(cmap__value_at((map), 0)) *cmap__ref_m =                                            \
+        cmap__get_ref_with((map), (key), hash, eq);                                                \
+    (cmap__ref_m != NULL) ? *cmap__ref_m : (fallback);                                             \
+  })
+
+/* PUBLIC: Returns whether the map has an entry for 'key'. */
+#define cmap__contains_with(map, key, hash, eq)                                                    \
+  (cmap__get_ref_with((map), (key), hash, eq) != NULL)
+
+/* PUBLIC: Removes entry of 'key', moving the last entry into its place.
+ * Returns whether there was one. The index never shrinks, see 'cmap__shrink_to_fit_with'. */
+#define cmap__remove_with(map, key, hash, eq)                                                      \
+  ({                                                                                               \
+    cmap__key_type_(map) cmap__key_m = (key);                                                      \
+    ptrdiff_t cmap__slot_m = cmap__find_slot_((map), cmap__key_m, hash(cmap__key_m), eq);          \
+    if (cmap__slot_m >= 0) {                                                                       \
+      uint32_t cmap__index_m = cmap__slots_(map)[cmap__slot_m];                                    \
+      uint32_t cmap__last_m = (uint32_t)(cmap__size(map) - 1);                                     \
+      cmap__release_slot_((map)->cmap__ctrl_m, (size_t)cmap__slot_m,                               \
+                          &((map)->cmap__growth_left_m));                                          \
+      if (cmap__index_m != cmap__last_m) {                                                         \
+        size_t cmap__moved_m =                                                                     \
+            cmap__slot_of_((map)->cmap__ctrl_m, (map)->cmap__cap_m,                                \
+                           hash(cmap__key_at((map), cmap__last_m)), cmap__last_m);                 \
+        cmap__slots_(map)[cmap__moved_m] = cmap__index_m;                                          \
+        cvector__index(cmap__entries_(map), cmap__index_m) =                                       \
+            cvector__index(cmap__entries_(map), cmap__last_m);                                     \
+      }                                                                                            \
+      cvector__setsize_(cmap__entries_(map), cmap__last_m);                                        \
+    }                                                                                              \
+    (cmap__slot_m >= 0);                                                                           \
+  })
+
+/* PUBLIC: Shrinks index and entries to the smallest size holding the current entries. */
+#define cmap__shrink_to_fit_with(map, hash)                                                        \
+  do {                                                                                             \
+    if (cmap__size(map) == 0) {                                                                    \
+      cmap__free(map);                                                                             \
+      cmap__init(map);                                                                             \
+    } else {                                                                                       \
+      cmap__rehash_((map), cmap__cap_for_(cmap__size(map)), hash);                                 \
+      cvector__shrink_to_fit(cmap__entries_(map));                                                 \
+    }                                                                                              \
+  } while (0)
+
+/* PUBLIC: Same as the '_with' variants, with 'cmap__hash_default' and 'cmap__eq_default'. */
+#define cmap__reserve(map, size) cmap__reserve_with((map), (size), cmap__hash_default)
+#define cmap__put(map, key, value)                                                                 \
+  cmap__put_with((map), (key), (value), cmap__hash_default, cmap__eq_default)
+#define cmap__get_ref(map, key)                                                                    \
+  cmap__get_ref_with((map), (key), cmap__hash_default, cmap__eq_default)
+#define cmap__get(map, key, fallback)                                                              \
+  cmap__get_with((map), (key), (fallback), cmap__hash_default, cmap__eq_default)
+#define cmap__contains(map, key)                                                                   \
+  cmap__contains_with((map), (key), cmap__hash_default, cmap__eq_default)
+#define cmap__remove(map, key) cmap__remove_with((map), (key), cmap__hash_default, cmap__eq_default)
+#define cmap__shrink_to_fit(map) cmap__shrink_to_fit_with((map), cmap__hash_default)
+
+/* PUBLIC: Removes every entry, keeping index and entries buffers. */
+#define cmap__clear(map)                                                                           \
+  do {                                                                                             \
+    cvector__setsize_(cmap__entries_(map), 0);                                                     \
+    if ((map)->cmap__cap_m > 0) {                                                                  \
+      memset((map)->cmap__ctrl_m, CMAP__EMPTY_, (map)->cmap__cap_m);                               \
+    }                                                                                              \
+    (map)->cmap__growth_left_m = (map)->cmap__cap_m - (map)->cmap__cap_m / 8;                      \
+  } while (0)
+
+/* PUBLIC: Frees index and entries. */
+#define cmap__free(map)                                                                            \
+  do {                                                                                             \
+    cvector__free(cmap__entries_(map));                                                            \
+    cvector__setsize_(cmap__entries_(map), 0);                                                     \
+    cvector__setcap_(cmap__entries_(map), 0);                                                      \
+    free((map)->cmap__ctrl_m);                                                                     \
+    (map)->cmap__ctrl_m = NULL;                                                                    \
+    (map)->cmap__cap_m = 0;                                                                        \
+    (map)->cmap__growth_left_m = 0;                                                                \
+  } while (0)
+
+#endif /* cvector_map_h */
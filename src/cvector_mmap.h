@@ -0,0 +1,186 @@
+/*
+ * Huge vector mode for cvector: buffers backed by anonymous mmap.
+ *
+ * 'cvector_mmap_t' is an allocator (see 'cvector_allocator_t') meant for vectors that grow to many
+ * MB or GB. Buffers smaller than the threshold stay on the libc heap. Once a buffer crosses the
+ * threshold it moves (once) into its own anonymous mapping, and from then on:
+ *
+ *   - growth is done with mremap, which moves page table entries instead of bytes, so there is
+ *     no copy and the old and new buffer are never resident at the same time.
+ *   - the mapping is optionally flagged with MADV_HUGEPAGE so transparent hugepages back it,
+ *     which cuts TLB misses when scanning it. Mapping sizes are then rounded to hugepage size.
+ *   - shrinking (shrink_to_fit or implicit shrink on pop) unmaps the tail with mremap, which
+ *     gives the pages back to the OS right away.
+ *
+ * Whether a block is mapped or heap allocated is decided from its size alone, so the allocator
+ * keeps no per-block state and a single 'cvector_mmap_t' can serve any number of vectors (from any
+ * number of threads).
+ *
+ *   cvector_mmap_t huge;
+ *   cvector_mmap__init(&huge, 4 * 1024 * 1024, true);
+ *
+ *   cvector_double_t column;
+ *   cvector__init_with_allocator(&column, cvector_mmap__allocator(&huge));
+ *
+ * On systems without mremap, growth falls back to mmap + memcpy + munmap.
+ */
+
+#ifndef cvector_mmap_h
+#define cvector_mmap_h
+
+#include "cvector.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+/* mremap is only declared with _GNU_SOURCE, which has to be set before the first system header.
+ * The syscall itself is always there on Linux, so declare it when the headers didn't. */
+#if defined(__linux__) && !defined(MREMAP_MAYMOVE)
+#define MREMAP_MAYMOVE 1
+extern void *mremap(void *old_address, size_t old_size, size_t new_size, int flags, ...);
+#endif
+
+/* Default size from which buffers are mapped instead of heap allocated. */
+#ifndef CVECTOR_MMAP__THRESHOLD
+#define CVECTOR_MMAP__THRESHOLD (4 * 1024 * 1024)
+#endif
+
+/* Size of transparent hugepage, mappings are rounded to it when hugepages are requested. */
+#ifndef CVECTOR_MMAP__HUGEPAGE_SIZE
+#define CVECTOR_MMAP__HUGEPAGE_SIZE (2 * 1024 * 1024)
+#endif
+
+typedef struct {
+  /* Blocks of at least this many bytes are mapped. */
+  size_t cvector_mmap__threshold_m;
+  /* Whether to request transparent hugepages for mapped blocks. */
+  bool cvector_mmap__hugepages_m;
+  /* Interface handed to vectors. */
+  cvector_allocator_t cvector_mmap__allocator_m;
+} cvector_mmap_t;
+
+/* PRIVATE: Whether block of 'size' bytes is mapped. */
+#define cvector_mmap__is_mapped_(mmap_ctx, size) ((size) >= (mmap_ctx)->cvector_mmap__threshold_m)
+
+/* PRIVATE: Length of mapping holding 'size' bytes. */
+static inline size_t cvector_mmap__length_(const cvector_mmap_t *mmap_ctx, size_t size) {
+  size_t unit = mmap_ctx->cvector_mmap__hugepages_m ? (size_t)CVECTOR_MMAP__HUGEPAGE_SIZE
+                                                    : (size_t)sysconf(_SC_PAGESIZE);
+  return (size + unit - 1) & ~(unit - 1);
+}
+
+/* PRIVATE: Applies hugepage hint to mapping. */
+static inline void cvector_mmap__advise_(const cvector_mmap_t *mmap_ctx, void *mem, size_t length) {
+#ifdef MADV_HUGEPAGE
+  if (mmap_ctx->cvector_mmap__hugepages_m) {
+    madvise(mem, length, MADV_HUGEPAGE);
+  }
+#else
+  (void)mmap_ctx;
+  (void)mem;
+  (void)length;
+#endif
+}
+
+/* PRIVATE: Maps fresh anonymous region holding 'size' bytes. */
+static inline void *cvector_mmap__map_(const cvector_mmap_t *mmap_ctx, size_t size) {
+  size_t length = cvector_mmap__length_(mmap_ctx, size);
+  void *mem = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mem == MAP_FAILED) {
+    return NULL;
+  }
+
+  cvector_mmap__advise_(mmap_ctx, mem, length);
+  return mem;
+}
+
+/* PRIVATE: Resizes mapping without copying (mremap), falls back to copy where unavailable. */
+static inline void *cvector_mmap__remap_(const cvector_mmap_t *mmap_ctx, void *mem,
+                                         size_t old_size, size_t new_size) {
+  size_t old_length = cvector_mmap__length_(mmap_ctx, old_size);
+  size_t new_length = cvector_mmap__length_(mmap_ctx, new_size);
+  if (old_length == new_length) {
+    return mem;
+  }
+
+#ifdef __linux__
+  void *new_mem = mremap(mem, old_length, new_length, MREMAP_MAYMOVE);
+  if (new_mem == MAP_FAILED) {
+    return NULL;
+  }
+
+  if (new_length > old_length) {
+    cvector_mmap__advise_(mmap_ctx, new_mem, new_length);
+  }
+  return new_mem;
+#else
+  if (new_length < old_length) {
+    munmap(((char *)mem) + new_length, old_length - new_length);
+    return mem;
+  }
+
+  void *new_mem = cvector_mmap__map_(mmap_ctx, new_size);
+  if (new_mem != NULL) {
+    memcpy(new_mem, mem, old_size);
+    munmap(mem, old_length);
+  }
+  return new_mem;
+#endif
+}
+
+/* PRIVATE: Allocates block, mapped if it is big enough. */
+static inline void *cvector_mmap__alloc_(void *ctx, size_t size) {
+  cvector_mmap_t *mmap_ctx = ctx;
+  return cvector_mmap__is_mapped_(mmap_ctx, size) ? cvector_mmap__map_(mmap_ctx, size)
+                                                  : malloc(size);
+}
+
+/* PRIVATE: Releases block, unmapping it if it is mapped. */
+static inline void cvector_mmap__free_(void *ctx, void *mem, size_t size) {
+  cvector_mmap_t *mmap_ctx = ctx;
+  if (cvector_mmap__is_mapped_(mmap_ctx, size)) {
+    munmap(mem, cvector_mmap__length_(mmap_ctx, size));
+  } else {
+    free(mem);
+  }
+}
+
+/* PRIVATE: Resizes block. Heap <-> mapping transitions copy once, mapping -> mapping never does. */
+static inline void *cvector_mmap__realloc_(void *ctx, void *mem, size_t old_size,
+                                           size_t new_size) {
+  cvector_mmap_t *mmap_ctx = ctx;
+  bool old_mapped = cvector_mmap__is_mapped_(mmap_ctx, old_size);
+  bool new_mapped = cvector_mmap__is_mapped_(mmap_ctx, new_size);
+
+  if (old_mapped && new_mapped) {
+    return cvector_mmap__remap_(mmap_ctx, mem, old_size, new_size);
+  }
+
+  if (!old_mapped && !new_mapped) {
+    return realloc(mem, new_size);
+  }
+
+  void *new_mem = cvector_mmap__alloc_(ctx, new_size);
+  if (new_mem != NULL) {
+    memcpy(new_mem, mem, (old_size < new_size) ? old_size : new_size);
+    cvector_mmap__free_(ctx, mem, old_size);
+  }
+  return new_mem;
+}
+
+/* PUBLIC: Initializes huge vector allocator.
+ *   - 'threshold' is the buffer size in bytes from which buffers are mapped.
+ *   - 'hugepages' requests transparent hugepages (MADV_HUGEPAGE) for mapped buffers.
+ */
+#define cvector_mmap__init(mmap_ctx, threshold, hugepages)                                         \
+  do {                                                                                             \
+    (mmap_ctx)->cvector_mmap__threshold_m = (threshold);                                           \
+    (mmap_ctx)->cvector_mmap__hugepages_m = (hugepages);                                           \
+    cvector_allocator__init(&((mmap_ctx)->cvector_mmap__allocator_m), cvector_mmap__alloc_,        \
+                            cvector_mmap__realloc_, cvector_mmap__free_, (mmap_ctx));              \
+  } while (0)
+
+/* PUBLIC: Returns allocator to pass to 'cvector__init_with_allocator'. */
+#define cvector_mmap__allocator(mmap_ctx) (&((mmap_ctx)->cvector_mmap__allocator_m))
+
+#endif /* cvector_mmap_h */
@@ -0,0 +1,483 @@
+/*
+ * Bit-packed integer vectors for cvector.
+ *
+ * Sorted IDs, timestamps and counters stored in a 'CVector(uint64_t)' take 8 bytes each, even
+ * though neighbouring values differ by a few bits. 'CVector_packed(T)' stores integers in blocks
+ * of CVECTOR_PACKED__BLOCK values, each encoded on its own with whichever is smaller of:
+ *
+ *   - frame of reference (FOR): the block minimum, then every value minus it in 'width' bits.
+ *   - delta FOR: the first value and the smallest gap, then every gap minus it in 'width' bits.
+ *     Sorted or regularly spaced values pack to a few bits, constant strides to none.
+ *
+ * Blocks needing more than 32 bits are stored as raw 64 bit values. Bits are laid out in 4
+ * interleaved 32 bit lanes (value i is in lane i % 4), so one SSE2 shift and mask decodes 4
+ * values at once. Values are added to an unpacked tail block, which is packed once full.
+ *
+ *   - Finding the block of an index is O(1). Reading a FOR block value is O(1), a delta block
+ *     value decodes its block.
+ *   - The iterator decodes a block at a time, so scans read packed bytes only.
+ *
+ * For example:
+ *
+ * CVector_packed(uint64_t) cvector_packed_u64_t;
+ *
+ * cvector_packed_u64_t ids;
+ * cvector__packed_init(&ids);
+ *
+ * for (uint64_t i = 0; i < 1000000; i++) {
+ *   cvector__packed_add(&ids, 1000000000 + i * 3);
+ * }
+ * uint64_t id = cvector__packed_index(&ids, 42);
+ * size_t bytes = cvector__packed_bytes(&ids);     // a few KB instead of 8 MB
+ *
+ * cvector__packed_free(&ids);
+ *
+ * NOTE: 'T' must be an integer type. Values are encoded as 'uint64_t', so signed values pack well
+ * as long as a block doesn't mix negative and positive ones.
+ */
+
+#ifndef cvector_packed_h
+#define cvector_packed_h
+
+#include "cvector.h"
+
+#include <stdint.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* Values per block. Fixed by the 4 lanes x 32 values layout. */
+#define CVECTOR_PACKED__BLOCK 128
+
+/* PRIVATE: Width of blocks stored as raw 64 bit values. */
+#define CVECTOR_PACKED__RAW_ 64
+
+/* PRIVATE: Header of a packed block. 'meta' holds the first word of the block in its store
+ * (bits 8-63), whether it is delta encoded (bit 7) and its width (bits 0-6). */
+typedef struct {
+  /* FOR: minimum, delta: first value */
+  uint64_t cvector_packed_block__base_m;
+  /* Delta: smallest gap */
+  uint64_t cvector_packed_block__ref_m;
+  uint64_t cvector_packed_block__meta_m;
+} cvector_packed_block_t;
+
+/* PRIVATE: Fields of a block header's 'meta'. */
+#define cvector_packed__word_(block) ((block)->cvector_packed_block__meta_m >> 8)
+#define cvector_packed__delta_(block) (((block)->cvector_packed_block__meta_m >> 7) & 1)
+#define cvector_packed__width_(block) ((unsigned int)((block)->cvector_packed_block__meta_m & 0x7f))
+
+/* PRIVATE: Packed blocks of a vector. */
+typedef struct {
+  cvector_packed_block_t *cvector_packed__blocks_m;
+  size_t cvector_packed__blocks_cap_m;
+  /* 32 bit words of every block, back to back */
+  uint32_t *cvector_packed__words_m;
+  size_t cvector_packed__words_size_m;
+  size_t cvector_packed__words_cap_m;
+} cvector_packed_store_t;
+
+/*
+ * Macro to create bit-packed vector type of integers of type 'cvector__elem_type_'.
+ * Elements [0, size - size % CVECTOR_PACKED__BLOCK) are packed, the others are in the tail.
+ */
+#define CVector_packed(cvector__elem_type_)                                                        \
+  typedef struct {                                                                                 \
+    cvector_packed_store_t cvector_packed__store_m;                                                \
+    size_t cvector__size_m;                                                                        \
+    /* Block being filled */                                                                       \
+    cvector__elem_type_ cvector_packed__tail_m[CVECTOR_PACKED__BLOCK];                             \
+  }
+
+/* PRIVATE: Number of bits needed by 'value'. */
+static inline unsigned int cvector_packed__bits_(uint64_t value) {
+  return (value == 0) ? 0 : 64 - (unsigned int)__builtin_clzll(value);
+}
+
+/* PRIVATE: Unpacks a block of 'width' bits (1 to 32) values into 'out'. */
+static inline void cvector_packed__unpack_(const uint32_t *words, unsigned int width,
+                                           uint32_t *out) {
+  uint32_t mask = (width == 32) ? ~(uint32_t)0 : (((uint32_t)1 << width) - 1);
+#if defined(__SSE2__)
+  __m128i mask_v = _mm_set1_epi32((int)mask);
+  for (unsigned int j = 0; j < CVECTOR_PACKED__BLOCK / 4; j++) {
+    unsigned int bit = j * width;
+    unsigned int shift = bit & 31;
+    const __m128i *at = (const __m128i *)(words + (bit >> 5) * 4);
+    __m128i value = _mm_srl_epi32(_mm_loadu_si128(at), _mm_cvtsi32_si128((int)shift));
+    if (shift + width > 32) {
+      value = _mm_or_si128(
+          value, _mm_sll_epi32(_mm_loadu_si128(at + 1), _mm_cvtsi32_si128((int)(32 - shift))));
+    }
+    _mm_storeu_si128((__m128i *)(out + j * 4), _mm_and_si128(value, mask_v));
+  }
+#else
+  for (unsigned int j = 0; j < CVECTOR_PACKED__BLOCK / 4; j++) {
+    unsigned int bit = j * width;
+    unsigned int shift = bit & 31;
+    const uint32_t *at = words + (bit >> 5) * 4;
+    for (unsigned int lane = 0; lane < 4; lane++) {
+      uint64_t value = at[lane] >> shift;
+      if (shift + width > 32) {
+        value |= (uint64_t)at[lane + 4] << (32 - shift);
+      }
+      out[j * 4 + lane] = (uint32_t)value & mask;
+    }
+  }
+#endif
+}
+
+/* PRIVATE: Returns value at 'index' of a block of 'width' bits (1 to 32) values. */
+static inline uint32_t cvector_packed__unpack_one_(const uint32_t *words, unsigned int width,
+                                                   size_t index) {
+  unsigned int bit = (unsigned int)(index / 4) * width;
+  unsigned int shift = bit & 31;
+  const uint32_t *at = words + (bit >> 5) * 4 + (index % 4);
+  uint64_t value = at[0] >> shift;
+  if (shift + width > 32) {
+    value |= (uint64_t)at[4] << (32 - shift);
+  }
+  return (uint32_t)value & ((width == 32) ? ~(uint32_t)0 : (((uint32_t)1 << width) - 1));
+}
+
+/* PRIVATE: Decodes every value of block 'block' into 'out'. */
+static inline void cvector_packed__decode_(const cvector_packed_store_t *store, size_t block,
+                                           uint64_t *out) {
+  const cvector_packed_block_t *header = &(store->cvector_packed__blocks_m[block]);
+  const uint32_t *words = store->cvector_packed__words_m + cvector_packed__word_(header);
+  unsigned int width = cvector_packed__width_(header);
+  uint64_t base = header->cvector_packed_block__base_m;
+
+  if (width == CVECTOR_PACKED__RAW_) {
+    for (size_t i = 0; i < CVECTOR_PACKED__BLOCK; i++) {
+      out[i] = words[i * 2] | ((uint64_t)words[i * 2 + 1] << 32);
+    }
+    return;
+  }
+
+  uint32_t packed[CVECTOR_PACKED__BLOCK];
+  if (width == 0) {
+    memset(packed, 0, sizeof(packed));
+  } else {
+    cvector_packed__unpack_(words, width, packed);
+  }
+
+  // Value i of a delta block is base + i * ref + packed[0] + ... + packed[i] (packed[0] is 0).
+  if (cvector_packed__delta_(header)) {
+    uint64_t ref = header->cvector_packed_block__ref_m;
+#if defined(__SSE2__)
+    // Sums of up to 128 values of 24 bits fit the 32 bit lanes.
+    if (width <= 24) {
+      __m128i zero = _mm_setzero_si128();
+      __m128i sum = zero;
+      __m128i step = _mm_set1_epi64x((long long)(ref * 4));
+      __m128i line_lo = _mm_set_epi64x((long long)(base + ref), (long long)base);
+      __m128i line_hi = _mm_set_epi64x((long long)(base + ref * 3), (long long)(base + ref * 2));
+      for (size_t i = 0; i < CVECTOR_PACKED__BLOCK; i += 4) {
+        __m128i value = _mm_loadu_si128((const __m128i *)(packed + i));
+        value = _mm_add_epi32(value, _mm_slli_si128(value, 4));
+        value = _mm_add_epi32(value, _mm_slli_si128(value, 8));
+        value = _mm_add_epi32(value, sum);
+        sum = _mm_shuffle_epi32(value, 0xff);
+        _mm_storeu_si128((__m128i *)(out + i),
+                         _mm_add_epi64(_mm_unpacklo_epi32(value, zero), line_lo));
+        _mm_storeu_si128((__m128i *)(out + i + 2),
+                         _mm_add_epi64(_mm_unpackhi_epi32(value, zero), line_hi));
+        line_lo = _mm_add_epi64(line_lo, step);
+        line_hi = _mm_add_epi64(line_hi, step);
+      }
+      return;
+    }
+#endif
+    uint64_t value = base - ref;
+    for (size_t i = 0; i < CVECTOR_PACKED__BLOCK; i++) {
+      value += ref + packed[i];
+      out[i] = value;
+    }
+  } else {
+    for (size_t i = 0; i < CVECTOR_PACKED__BLOCK; i++) {
+      out[i] = base + packed[i];
+    }
+  }
+}
+
+/* PRIVATE: Returns value at 'index' of block 'block'. */
+static inline uint64_t cvector_packed__get_(const cvector_packed_store_t *store, size_t block,
+                                            size_t index) {
+  const cvector_packed_block_t *header = &(store->cvector_packed__blocks_m[block]);
+  const uint32_t *words = store->cvector_packed__words_m + cvector_packed__word_(header);
+  unsigned int width = cvector_packed__width_(header);
+
+  if (width == CVECTOR_PACKED__RAW_) {
+    return words[index * 2] | ((uint64_t)words[index * 2 + 1] << 32);
+  }
+  if (cvector_packed__delta_(header)) {
+    uint64_t values[CVECTOR_PACKED__BLOCK];
+    cvector_packed__decode_(store, block, values);
+    return values[index];
+  }
+  return header->cvector_packed_block__base_m +
+         ((width == 0) ? 0 : cvector_packed__unpack_one_(words, width, index));
+}
+
+/* PRIVATE: Grows buffer '*mem' of '*cap' items of 'item_size' bytes to hold at least 'min_cap'.
+ * Returns false if it can't be allocated. */
+static inline bool cvector_packed__reserve_(void **mem, size_t *cap, size_t item_size,
+                                            size_t min_cap) {
+  if (min_cap <= *cap) {
+    return true;
+  }
+  size_t new_cap = (*cap == 0) ? min_cap : *cap * 2;
+  new_cap = (new_cap < min_cap) ? min_cap : new_cap;
+  void *grown = realloc(*mem, new_cap * item_size);
+  if (grown == NULL) {
+    return false;
+  }
+  *mem = grown;
+  *cap = new_cap;
+  return true;
+}
+
+/* PRIVATE: Packs the CVECTOR_PACKED__BLOCK values of 'values' as block 'block', choosing the
+ * smaller encoding. Returns false if memory can't be allocated. */
+static inline bool cvector_packed__pack_(cvector_packed_store_t *store, size_t block,
+                                         const uint64_t *values) {
+  uint64_t min = values[0];
+  uint64_t max = values[0];
+  uint64_t gap_min = UINT64_MAX;
+  uint64_t gap_max = 0;
+  for (size_t i = 1; i < CVECTOR_PACKED__BLOCK; i++) {
+    uint64_t gap = values[i] - values[i - 1];
+    min = (values[i] < min) ? values[i] : min;
+    max = (values[i] > max) ? values[i] : max;
+    gap_min = (gap < gap_min) ? gap : gap_min;
+    gap_max = (gap > gap_max) ? gap : gap_max;
+  }
+
+  unsigned int width = cvector_packed__bits_(max - min);
+  unsigned int gap_width = cvector_packed__bits_(gap_max - gap_min);
+  bool delta = gap_width < width;
+  width = delta ? gap_width : width;
+  if (width > 32) {
+    width = CVECTOR_PACKED__RAW_;
+    delta = false;
+  }
+
+  size_t words = (width == CVECTOR_PACKED__RAW_) ? CVECTOR_PACKED__BLOCK * 2 : width * 4;
+  if (!cvector_packed__reserve_((void **)&(store->cvector_packed__blocks_m),
+                                &(store->cvector_packed__blocks_cap_m),
+                                sizeof(cvector_packed_block_t), block + 1) ||
+      !cvector_packed__reserve_((void **)&(store->cvector_packed__words_m),
+                                &(store->cvector_packed__words_cap_m), sizeof(uint32_t),
+                                store->cvector_packed__words_size_m + words)) {
+    return false;
+  }
+
+  cvector_packed_block_t *header = &(store->cvector_packed__blocks_m[block]);
+  header->cvector_packed_block__base_m = delta ? values[0] : min;
+  header->cvector_packed_block__ref_m = delta ? gap_min : 0;
+  header->cvector_packed_block__meta_m =
+      ((uint64_t)store->cvector_packed__words_size_m << 8) | ((uint64_t)delta << 7) | width;
+
+  if (width == 0) {
+    return true;
+  }
+
+  uint32_t *out = store->cvector_packed__words_m + store->cvector_packed__words_size_m;
+  store->cvector_packed__words_size_m += words;
+  if (width == CVECTOR_PACKED__RAW_) {
+    for (size_t i = 0; i < CVECTOR_PACKED__BLOCK; i++) {
+      out[i * 2] = (uint32_t)values[i];
+      out[i * 2 + 1] = (uint32_t)(values[i] >> 32);
+    }
+    return true;
+  }
+
+  memset(out, 0, words * sizeof(uint32_t));
+  for (size_t i = 0; i < CVECTOR_PACKED__BLOCK; i++) {
+    uint64_t value = !delta ? values[i] - min : (i == 0) ? 0 : values[i] - values[i - 1] - gap_min;
+    unsigned int bit = (unsigned int)(i / 4) * width;
+    unsigned int shift = bit & 31;
+    uint32_t *at = out + (bit >> 5) * 4 + (i % 4);
+    at[0] |= (uint32_t)(value << shift);
+    if (shift + width > 32) {
+      at[4] |= (uint32_t)(value >> (32 - shift));
+    }
+  }
+  return true;
+}
+
+/* PRIVATE: Number of packed elements. */
+#define cvector_packed__packed_size_(vec)                                                          \
+  (cvector__size(vec) - (cvector__size(vec) % CVECTOR_PACKED__BLOCK))
+
+/* PUBLIC: Initializes empty vector, no allocation is made until the first block is full. */
+#define cvector__packed_init(vec)                                                                  \
+  do {                                                                                             \
+    _Static_assert((__typeof__((vec)->cvector_packed__tail_m[0]))0.5 == 0,                         \
+                   "CVector_packed needs integer elements");                                       \
+    memset(&((vec)->cvector_packed__store_m), 0, sizeof(cvector_packed_store_t));                  \
+    cvector__setsize_((vec), 0);                                                                   \
+  } while (0)
+
+/* PUBLIC: Adds element at the back. Packs the tail once it holds a whole block.
+ * The element is dropped if the block can't be packed for lack of memory. */
+#define cvector__packed_add(vec, val)                                                              \
+  do {                                                                                             \
+    size_t cvector__at_m = cvector__size(vec) % CVECTOR_PACKED__BLOCK;                             \
+    (vec)->cvector_packed__tail_m[cvector__at_m] = (val);                                          \
+    bool cvector__added_m = true;                                                                  \
+    if (cvector__at_m == CVECTOR_PACKED__BLOCK - 1) {                                              \
+      uint64_t cvector__values_m[CVECTOR_PACKED__BLOCK];                                           \
+      for (size_t cvector__i_m = 0; cvector__i_m < CVECTOR_PACKED__BLOCK; cvector__i_m++) {        \
+        cvector__values_m[cvector__i_m] = (uint64_t)(vec)->cvector_packed__tail_m[cvector__i_m];   \
+      }                                                                                            \
+      cvector__added_m = cvector_packed__pack_(&((vec)->cvector_packed__store_m),                  \
+                                               cvector__size(vec) / CVECTOR_PACKED__BLOCK,         \
+                                               cvector__values_m);                                 \
+    }                                                                                              \
+    if (cvector__added_m) {                                                                        \
+      cvector__setsize_((vec), (cvector__size(vec) + 1));                                          \
+    }                                                                                              \
+  } while (0)
+
+/* PUBLIC: Returns element at given index. O(1) except in delta encoded blocks, which are decoded
+ * up to the element. */
+#define cvector__packed_index(vec, index)                                                          \
+  ({                                                                                               \
+    size_t cvector__at_m = (index);                                                                \
+    (cvector__at_m >= cvector_packed__packed_size_(vec))                                           \
+        ? (vec)->cvector_packed__tail_m[cvector__at_m % CVECTOR_PACKED__BLOCK]                     \
+        : (__typeof__((vec)->cvector_packed__tail_m[0]))cvector_packed__get_(                      \
+              &((vec)->cvector_packed__store_m), cvector__at_m / CVECTOR_PACKED__BLOCK,            \
+              cvector__at_m % CVECTOR_PACKED__BLOCK);                                              \
+  })
+
+/* PUBLIC: Returns last element. Vector must not be empty. */
+#define cvector__packed_last(vec) (cvector__packed_index((vec), (cvector__size(vec) - 1)))
+
+/* PUBLIC: Returns number of bytes used by the vector, its struct and tail included. */
+#define cvector__packed_bytes(vec)                                                                 \
+  (sizeof(*(vec)) +                                                                                \
+   (vec)->cvector_packed__store_m.cvector_packed__blocks_cap_m * sizeof(cvector_packed_block_t) +  \
+   (vec)->cvector_packed__store_m.cvector_packed__words_cap_m * sizeof(uint32_t))
+
+/* PUBLIC: Gives memory reserved for blocks to come back. */
+#define cvector__packed_shrink_to_fit(vec)                                                         \
+  do {                                                                                             \
+    cvector_packed_store_t *cvector__store_m = &((vec)->cvector_packed__store_m);                  \
+    size_t cvector__blocks_m = cvector__size(vec) / CVECTOR_PACKED__BLOCK;                         \
+    size_t cvector__words_m = cvector__store_m->cvector_packed__words_size_m;                      \
+    void *cvector__blocks_mem_m =                                                                  \
+        (cvector__blocks_m > 0) ? realloc(cvector__store_m->cvector_packed__blocks_m,              \
+                                          cvector__blocks_m * sizeof(cvector_packed_block_t))      \
+                                : NULL;                                                            \
+    if (cvector__blocks_mem_m != NULL) {                                                           \
+      cvector__store_m->cvector_packed__blocks_m = cvector__blocks_mem_m;                          \
+      cvector__store_m->cvector_packed__blocks_cap_m = cvector__blocks_m;                          \
+    }                                                                                              \
+    void *cvector__words_mem_m =                                                                   \
+        (cvector__words_m > 0) ? realloc(cvector__store_m->cvector_packed__words_m,                \
+                                         cvector__words_m * sizeof(uint32_t))                      \
+                               : NULL;                                                             \
+    if (cvector__words_mem_m != NULL) {                                                            \
+      cvector__store_m->cvector_packed__words_m = cvector__words_mem_m;                            \
+      cvector__store_m->cvector_packed__words_cap_m = cvector__words_m;                            \
+    }                                                                                              \
+  } while (0)
+
+/* PUBLIC: Removes every element, keeping memory for reuse. */
+#define cvector__packed_clear(vec)                                                                 \
+  do {                                                                                             \
+    (vec)->cvector_packed__store_m.cvector_packed__words_size_m = 0;                               \
+    cvector__setsize_((vec), 0);                                                                   \
+  } while (0)
+
+/* PUBLIC: Frees every block. */
+#define cvector__packed_free(vec)                                                                  \
+  do {                                                                                             \
+    free((vec)->cvector_packed__store_m.cvector_packed__blocks_m);                                 \
+    free((vec)->cvector_packed__store_m.cvector_packed__words_m);                                  \
+    cvector__packed_init(vec);                                                                     \
+  } while (0)
+
+/*
+ * Macro to create iterator type over packed vector type 'cvector__type_'. Decodes a whole block
+ * when entering it, so 'next' is an array read otherwise. Elements may be added while iterating,
+ * an iterator that was done carries on with them, clearing or freeing the vector invalidates it.
+ *
+ *   CVector_packed_iterator(cvector_packed_u64_t) cvector_packed_u64_iterator_t;
+ *
+ *   cvector_packed_u64_iterator_t iterator;
+ *   cvector_packed_iterator__init(&iterator, &ids);
+ *
+ *   while (!cvector_packed_iterator__done(&iterator)) {
+ *     uint64_t id = cvector_packed_iterator__next(&iterator);
+ *   }
+ */
+#define CVector_packed_iterator(cvector__type_)                                                    \
+  typedef struct {                                                                                 \
+    cvector__type_ *cvector_packed_iterator__vec_m;                                                \
+    /* Index of next element */                                                                    \
+    size_t cvector_packed_iterator__next_index_m;                                                  \
+    /* Next element, and end of the decoded elements */                                            \
+    const uint64_t *cvector_packed_iterator__cur_m;                                                \
+    const uint64_t *cvector_packed_iterator__end_m;                                                \
+    /* Decoded block of next element, or copy of the tail */                                       \
+    uint64_t cvector_packed_iterator__block_m[CVECTOR_PACKED__BLOCK];                              \
+  }
+
+/* PUBLIC: Initializes iterator before first element of vector. */
+#define cvector_packed_iterator__init(iterator, vec)                                               \
+  do {                                                                                             \
+    (iterator)->cvector_packed_iterator__vec_m = (vec);                                            \
+    (iterator)->cvector_packed_iterator__next_index_m = 0;                                         \
+    (iterator)->cvector_packed_iterator__cur_m = NULL;                                             \
+    (iterator)->cvector_packed_iterator__end_m = NULL;                                             \
+  } while (0)
+
+/* PUBLIC: Returns whether every element was visited. */
+#define cvector_packed_iterator__done(iterator)                                                    \
+  ((iterator)->cvector_packed_iterator__next_index_m >=                                            \
+   cvector__size((iterator)->cvector_packed_iterator__vec_m))
+
+/* PRIVATE: Decodes block of next element, or copies the tail once past the packed elements.
+ * Starts at the next element within the block, which isn't its first one if the iterator ran
+ * to the end of the tail and elements were added since. */
+#define cvector_packed_iterator__fill_(iterator)                                                   \
+  do {                                                                                             \
+    __typeof__((iterator)->cvector_packed_iterator__vec_m) cvector__vec_m =                        \
+        (iterator)->cvector_packed_iterator__vec_m;                                                \
+    size_t cvector__at_m = (iterator)->cvector_packed_iterator__next_index_m;                      \
+    size_t cvector__count_m = CVECTOR_PACKED__BLOCK;                                               \
+    if (cvector__at_m < cvector_packed__packed_size_(cvector__vec_m)) {                            \
+      cvector_packed__decode_(&(cvector__vec_m->cvector_packed__store_m),                          \
+                              cvector__at_m / CVECTOR_PACKED__BLOCK,                               \
+                              (iterator)->cvector_packed_iterator__block_m);                       \
+    } else {                                                                                       \
+      cvector__count_m = cvector__size(cvector__vec_m) % CVECTOR_PACKED__BLOCK;                    \
+      for (size_t cvector__i_m = 0; cvector__i_m < cvector__count_m; cvector__i_m++) {             \
+        (iterator)->cvector_packed_iterator__block_m[cvector__i_m] =                               \
+            (uint64_t)cvector__vec_m->cvector_packed__tail_m[cvector__i_m];                        \
+      }                                                                                            \
+    }                                                                                              \
+    (iterator)->cvector_packed_iterator__cur_m =                                                   \
+        (iterator)->cvector_packed_iterator__block_m + cvector__at_m % CVECTOR_PACKED__BLOCK;      \
+    (iterator)->cvector_packed_iterator__end_m =                                                   \
+        (iterator)->cvector_packed_iterator__block_m + cvector__count_m;                           \
+  } while (0)
+
+/* PUBLIC: Moves to next element and returns it. */
+#define cvector_packed_iterator__next(iterator)                                                    \
+  ({                                                                                               \
+    if ((iterator)->cvector_packed_iterator__cur_m ==                                              \
+        (iterator)->cvector_packed_iterator__end_m) {                                              \
+      cvector_packed_iterator__fill_(iterator);                                                    \
+    }                                                                                              \
+    (iterator)->cvector_packed_iterator__next_index_m++;                                           \
+    ((__typeof__((iterator)->cvector_packed_iterator__vec_m->cvector_packed__tail_m[0]))*(         \
+        (iterator)->cvector_packed_iterator__cur_m++));                                            \
+  })
+
+#endif /* cvector_packed_h */
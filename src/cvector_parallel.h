@@ -0,0 +1,598 @@
+/*
+ * Parallel algorithms for cvector.
+ *
+ * 'cvector_parallel_t' is a pool of worker threads with work stealing. A parallel job splits the
+ * index range of a vector evenly between workers (the calling thread is worker 0). Each worker
+ * eats its own range front to back, CVECTOR_PARALLEL__GRAIN elements at a time. A worker that runs
+ * out steals the back half of the range of another worker, so uneven work still keeps every core
+ * busy until the end.
+ *
+ * On top of the pool:
+ *   - 'cvector__parallel_for_each' calls a function on every element in place.
+ *   - 'cvector__parallel_map' fills another vector (of any element type) from every element.
+ *   - 'cvector__parallel_reduce' folds the elements with a combiner into one value.
+ *   - 'cvector__parallel_sort' is a merge sort: blocks are sorted in parallel, then merged pass by
+ *     pass, each merge being split between workers by output position (merge path).
+ *
+ * Callbacks work on elements through pointers, so one compiled pool serves every element type.
+ * They must take 'void *' parameters as shown below and cast inside: they are called through that
+ * exact signature, and calling a function through a pointer of another type is undefined.
+ *
+ * For example:
+ *
+ * static void square(void *elem, void *ctx) { *(double *)elem *= *(double *)elem; }
+ * static void sum(void *acc, const void *value, void *ctx) { *(double *)acc += *(double *)value; }
+ *
+ * cvector_parallel_t parallel;
+ * cvector_parallel__init(&parallel, 0);  // one worker per online CPU
+ *
+ * cvector__parallel_for_each(&parallel, &vector_double, square, NULL);
+ * double total = cvector__parallel_reduce(&parallel, &vector_double, 0.0, sum, NULL);
+ * cvector__parallel_sort(&parallel, &vector_double, compare_double);
+ *
+ * cvector_parallel__destroy(&parallel);
+ *
+ * NOTE: A pool runs one job at a time. Callbacks must not start jobs on the pool they run on.
+ */
+
+#ifndef cvector_parallel_h
+#define cvector_parallel_h
+
+#include "cvector.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+/* Number of elements a worker takes from its range at once. */
+#ifndef CVECTOR_PARALLEL__GRAIN
+#define CVECTOR_PARALLEL__GRAIN 4096
+#endif
+
+/* Vectors smaller than this are sorted by the calling thread alone. */
+#ifndef CVECTOR_PARALLEL__SORT_THRESHOLD
+#define CVECTOR_PARALLEL__SORT_THRESHOLD (64 * 1024)
+#endif
+
+/* PRIVATE: Job run by pool, called with worker index and sub-range [begin, end) of the job. */
+typedef void (*cvector_parallel_job_t)(void *ctx, size_t worker, size_t begin, size_t end);
+
+/* PRIVATE: Part of job range owned by one worker. Padded so workers don't share cache lines. */
+typedef struct {
+  _Alignas(64) pthread_mutex_t cvector_parallel_range__lock_m;
+  size_t cvector_parallel_range__begin_m;
+  size_t cvector_parallel_range__end_m;
+} cvector_parallel_range_t;
+
+typedef struct {
+  /* Spawned threads, workers 1 .. count - 1. */
+  pthread_t *cvector_parallel__threads_m;
+  /* Number of workers including the calling thread. */
+  size_t cvector_parallel__count_m;
+  /* Work ranges, one per worker. */
+  cvector_parallel_range_t *cvector_parallel__ranges_m;
+  /* Protects job hand-off below. */
+  pthread_mutex_t cvector_parallel__mutex_m;
+  pthread_cond_t cvector_parallel__wake_m;
+  pthread_cond_t cvector_parallel__done_m;
+  /* Bumped for every job, workers run a job once per generation. */
+  unsigned long cvector_parallel__generation_m;
+  /* Spawned workers still busy with current job. */
+  size_t cvector_parallel__busy_m;
+  bool cvector_parallel__stop_m;
+  /* Current job. */
+  cvector_parallel_job_t cvector_parallel__job_m;
+  void *cvector_parallel__ctx_m;
+  size_t cvector_parallel__grain_m;
+} cvector_parallel_t;
+
+/* PRIVATE: Argument of spawned worker. */
+typedef struct {
+  cvector_parallel_t *cvector_parallel_worker__pool_m;
+  size_t cvector_parallel_worker__index_m;
+} cvector_parallel_worker_t;
+
+/* PRIVATE: Takes back half of another worker's range into 'worker's own range.
+ * Returns false when every range is empty. */
+static inline bool cvector_parallel__steal_(cvector_parallel_t *pool, size_t worker) {
+  cvector_parallel_range_t *ranges = pool->cvector_parallel__ranges_m;
+  size_t count = pool->cvector_parallel__count_m;
+
+  for (size_t step = 1; step < count; step++) {
+    cvector_parallel_range_t *victim = &ranges[(worker + step) % count];
+    pthread_mutex_lock(&(victim->cvector_parallel_range__lock_m));
+    size_t begin = victim->cvector_parallel_range__begin_m;
+    size_t end = victim->cvector_parallel_range__end_m;
+    size_t middle = begin + (end - begin) / 2;
+    if (begin < end) {
+      // A lone grain is taken whole, otherwise the victim keeps the front half.
+      middle = ((end - begin) <= pool->cvector_parallel__grain_m) ? begin : middle;
+      victim->cvector_parallel_range__end_m = middle;
+    }
+    pthread_mutex_unlock(&(victim->cvector_parallel_range__lock_m));
+
+    if (begin < end) {
+      cvector_parallel_range_t *own = &ranges[worker];
+      pthread_mutex_lock(&(own->cvector_parallel_range__lock_m));
+      own->cvector_parallel_range__begin_m = middle;
+      own->cvector_parallel_range__end_m = end;
+      pthread_mutex_unlock(&(own->cvector_parallel_range__lock_m));
+      return true;
+    }
+  }
+  return false;
+}
+
+/* PRIVATE: Runs current job as 'worker' until no range has work left. */
+static inline void cvector_parallel__work_(cvector_parallel_t *pool, size_t worker) {
+  cvector_parallel_range_t *own = &(pool->cvector_parallel__ranges_m[worker]);
+  size_t grain = pool->cvector_parallel__grain_m;
+
+  for (;;) {
+    pthread_mutex_lock(&(own->cvector_parallel_range__lock_m));
+    size_t begin = own->cvector_parallel_range__begin_m;
+    size_t end = own->cvector_parallel_range__end_m;
+    if ((end - begin) > grain) {
+      end = begin + grain;
+    }
+    own->cvector_parallel_range__begin_m = end;
+    pthread_mutex_unlock(&(own->cvector_parallel_range__lock_m));
+
+    if (begin < end) {
+      pool->cvector_parallel__job_m(pool->cvector_parallel__ctx_m, worker, begin, end);
+    } else if (!cvector_parallel__steal_(pool, worker)) {
+      return;
+    }
+  }
+}
+
+/* PRIVATE: Body of spawned worker: waits for jobs until the pool is destroyed. */
+static inline void *cvector_parallel__thread_(void *arg) {
+  cvector_parallel_worker_t *self = arg;
+  cvector_parallel_t *pool = self->cvector_parallel_worker__pool_m;
+  size_t worker = self->cvector_parallel_worker__index_m;
+  free(self);
+
+  unsigned long generation = 0;
+  pthread_mutex_lock(&(pool->cvector_parallel__mutex_m));
+  for (;;) {
+    while (!pool->cvector_parallel__stop_m &&
+           (pool->cvector_parallel__generation_m == generation)) {
+      pthread_cond_wait(&(pool->cvector_parallel__wake_m), &(pool->cvector_parallel__mutex_m));
+    }
+    if (pool->cvector_parallel__stop_m) {
+      break;
+    }
+    generation = pool->cvector_parallel__generation_m;
+    pthread_mutex_unlock(&(pool->cvector_parallel__mutex_m));
+
+    cvector_parallel__work_(pool, worker);
+
+    pthread_mutex_lock(&(pool->cvector_parallel__mutex_m));
+    if (--(pool->cvector_parallel__busy_m) == 0) {
+      pthread_cond_signal(&(pool->cvector_parallel__done_m));
+    }
+  }
+  pthread_mutex_unlock(&(pool->cvector_parallel__mutex_m));
+  return NULL;
+}
+
+/* PRIVATE: Runs 'job' over [0, size) on every worker and returns once it is done. */
+static inline void cvector_parallel__run_(cvector_parallel_t *pool, size_t size, size_t grain,
+                                          cvector_parallel_job_t job, void *ctx) {
+  size_t count = pool->cvector_parallel__count_m;
+  for (size_t i = 0; i < count; i++) {
+    cvector_parallel_range_t *range = &(pool->cvector_parallel__ranges_m[i]);
+    range->cvector_parallel_range__begin_m = size / count * i;
+    range->cvector_parallel_range__end_m = (i + 1 == count) ? size : size / count * (i + 1);
+  }
+
+  pthread_mutex_lock(&(pool->cvector_parallel__mutex_m));
+  pool->cvector_parallel__job_m = job;
+  pool->cvector_parallel__ctx_m = ctx;
+  pool->cvector_parallel__grain_m = (grain > 0) ? grain : 1;
+  pool->cvector_parallel__busy_m = count - 1;
+  pool->cvector_parallel__generation_m++;
+  pthread_cond_broadcast(&(pool->cvector_parallel__wake_m));
+  pthread_mutex_unlock(&(pool->cvector_parallel__mutex_m));
+
+  cvector_parallel__work_(pool, 0);
+
+  pthread_mutex_lock(&(pool->cvector_parallel__mutex_m));
+  while (pool->cvector_parallel__busy_m > 0) {
+    pthread_cond_wait(&(pool->cvector_parallel__done_m), &(pool->cvector_parallel__mutex_m));
+  }
+  pthread_mutex_unlock(&(pool->cvector_parallel__mutex_m));
+}
+
+/* PRIVATE: Stops and joins workers, releases pool. */
+static inline void cvector_parallel__destroy_(cvector_parallel_t *pool) {
+  pthread_mutex_lock(&(pool->cvector_parallel__mutex_m));
+  pool->cvector_parallel__stop_m = true;
+  pthread_cond_broadcast(&(pool->cvector_parallel__wake_m));
+  pthread_mutex_unlock(&(pool->cvector_parallel__mutex_m));
+
+  for (size_t i = 1; i < pool->cvector_parallel__count_m; i++) {
+    pthread_join(pool->cvector_parallel__threads_m[i], NULL);
+  }
+  for (size_t i = 0; i < pool->cvector_parallel__count_m; i++) {
+    pthread_mutex_destroy(&(pool->cvector_parallel__ranges_m[i].cvector_parallel_range__lock_m));
+  }
+
+  pthread_mutex_destroy(&(pool->cvector_parallel__mutex_m));
+  pthread_cond_destroy(&(pool->cvector_parallel__wake_m));
+  pthread_cond_destroy(&(pool->cvector_parallel__done_m));
+  free(pool->cvector_parallel__threads_m);
+  free(pool->cvector_parallel__ranges_m);
+  pool->cvector_parallel__threads_m = NULL;
+  pool->cvector_parallel__ranges_m = NULL;
+  pool->cvector_parallel__count_m = 0;
+}
+
+/* PRIVATE: Starts pool of 'threads' workers, one per online CPU when 0.
+ * Returns -1 if memory or a thread can't be had, the workers started so far are then joined. */
+static inline int cvector_parallel__init_(cvector_parallel_t *pool, size_t threads) {
+  if (threads == 0) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = (online > 0) ? (size_t)online : 1;
+  }
+
+  pool->cvector_parallel__threads_m = malloc(sizeof(pthread_t) * threads);
+  pool->cvector_parallel__ranges_m =
+      aligned_alloc(_Alignof(cvector_parallel_range_t), sizeof(cvector_parallel_range_t) * threads);
+  if ((pool->cvector_parallel__threads_m == NULL) || (pool->cvector_parallel__ranges_m == NULL)) {
+    free(pool->cvector_parallel__threads_m);
+    free(pool->cvector_parallel__ranges_m);
+    pool->cvector_parallel__threads_m = NULL;
+    pool->cvector_parallel__ranges_m = NULL;
+    pool->cvector_parallel__count_m = 0;
+    return -1;
+  }
+
+  pool->cvector_parallel__count_m = threads;
+  pthread_mutex_init(&(pool->cvector_parallel__mutex_m), NULL);
+  pthread_cond_init(&(pool->cvector_parallel__wake_m), NULL);
+  pthread_cond_init(&(pool->cvector_parallel__done_m), NULL);
+  pool->cvector_parallel__generation_m = 0;
+  pool->cvector_parallel__busy_m = 0;
+  pool->cvector_parallel__stop_m = false;
+
+  for (size_t i = 0; i < threads; i++) {
+    pthread_mutex_init(&(pool->cvector_parallel__ranges_m[i].cvector_parallel_range__lock_m), NULL);
+    pool->cvector_parallel__ranges_m[i].cvector_parallel_range__begin_m = 0;
+    pool->cvector_parallel__ranges_m[i].cvector_parallel_range__end_m = 0;
+  }
+
+  for (size_t i = 1; i < threads; i++) {
+    cvector_parallel_worker_t *worker = malloc(sizeof(cvector_parallel_worker_t));
+    if (worker != NULL) {
+      worker->cvector_parallel_worker__pool_m = pool;
+      worker->cvector_parallel_worker__index_m = i;
+      if (pthread_create(&(pool->cvector_parallel__threads_m[i]), NULL,
+                         cvector_parallel__thread_, worker) == 0) {
+        continue;
+      }
+      free(worker);
+    }
+
+    // Slots from i on have no worker, destroy joins and releases the first i.
+    pool->cvector_parallel__count_m = i;
+    for (size_t k = i; k < threads; k++) {
+      pthread_mutex_destroy(&(pool->cvector_parallel__ranges_m[k].cvector_parallel_range__lock_m));
+    }
+    cvector_parallel__destroy_(pool);
+    return -1;
+  }
+  return 0;
+}
+
+/* PRIVATE: State shared by workers of element-wise jobs. */
+typedef struct {
+  char *cvector_parallel_op__elems_m;
+  size_t cvector_parallel_op__elem_size_m;
+  /* Output of map, partial results (one per worker) of reduce */
+  char *cvector_parallel_op__out_m;
+  size_t cvector_parallel_op__out_size_m;
+  void (*cvector_parallel_op__each_m)(void *elem, void *ctx);
+  void (*cvector_parallel_op__map_m)(const void *elem, void *out, void *ctx);
+  void (*cvector_parallel_op__combine_m)(void *acc, const void *elem, void *ctx);
+  void *cvector_parallel_op__ctx_m;
+} cvector_parallel_op_t;
+
+/* PRIVATE: for_each job. */
+static inline void cvector_parallel__each_job_(void *ctx, size_t worker, size_t begin,
+                                               size_t end) {
+  cvector_parallel_op_t *op = ctx;
+  size_t elem_size = op->cvector_parallel_op__elem_size_m;
+  (void)worker;
+
+  for (size_t i = begin; i < end; i++) {
+    op->cvector_parallel_op__each_m(op->cvector_parallel_op__elems_m + i * elem_size,
+                                    op->cvector_parallel_op__ctx_m);
+  }
+}
+
+/* PRIVATE: map job. */
+static inline void cvector_parallel__map_job_(void *ctx, size_t worker, size_t begin, size_t end) {
+  cvector_parallel_op_t *op = ctx;
+  size_t elem_size = op->cvector_parallel_op__elem_size_m;
+  size_t out_size = op->cvector_parallel_op__out_size_m;
+  (void)worker;
+
+  for (size_t i = begin; i < end; i++) {
+    op->cvector_parallel_op__map_m(op->cvector_parallel_op__elems_m + i * elem_size,
+                                   op->cvector_parallel_op__out_m + i * out_size,
+                                   op->cvector_parallel_op__ctx_m);
+  }
+}
+
+/* PRIVATE: reduce job, folds into partial result of the worker. */
+static inline void cvector_parallel__reduce_job_(void *ctx, size_t worker, size_t begin,
+                                                 size_t end) {
+  cvector_parallel_op_t *op = ctx;
+  size_t elem_size = op->cvector_parallel_op__elem_size_m;
+  char *acc = op->cvector_parallel_op__out_m + worker * elem_size;
+
+  for (size_t i = begin; i < end; i++) {
+    op->cvector_parallel_op__combine_m(acc, op->cvector_parallel_op__elems_m + i * elem_size,
+                                       op->cvector_parallel_op__ctx_m);
+  }
+}
+
+/* PRIVATE: Calls 'each' on 'size' elements in parallel. */
+static inline void cvector_parallel__for_each_(cvector_parallel_t *pool, void *elems, size_t size,
+                                               size_t elem_size,
+                                               void (*each)(void *elem, void *ctx), void *ctx) {
+  cvector_parallel_op_t op = {.cvector_parallel_op__elems_m = elems,
+                              .cvector_parallel_op__elem_size_m = elem_size,
+                              .cvector_parallel_op__each_m = each,
+                              .cvector_parallel_op__ctx_m = ctx};
+  cvector_parallel__run_(pool, size, CVECTOR_PARALLEL__GRAIN, cvector_parallel__each_job_, &op);
+}
+
+/* PRIVATE: Stores 'map' of every element into 'out' in parallel. */
+static inline void cvector_parallel__map_(cvector_parallel_t *pool, void *elems, size_t size,
+                                          size_t elem_size, void *out, size_t out_size,
+                                          void (*map)(const void *elem, void *out, void *ctx),
+                                          void *ctx) {
+  cvector_parallel_op_t op = {.cvector_parallel_op__elems_m = elems,
+                              .cvector_parallel_op__elem_size_m = elem_size,
+                              .cvector_parallel_op__out_m = out,
+                              .cvector_parallel_op__out_size_m = out_size,
+                              .cvector_parallel_op__map_m = map,
+                              .cvector_parallel_op__ctx_m = ctx};
+  cvector_parallel__run_(pool, size, CVECTOR_PARALLEL__GRAIN, cvector_parallel__map_job_, &op);
+}
+
+/* PRIVATE: Folds elements into 'acc' (which holds identity on entry). Each worker folds into its
+ * own copy of identity, partials are then folded into 'acc' in worker order. Falls back to a
+ * serial fold by the calling thread if the partials can't be allocated. */
+static inline void cvector_parallel__reduce_(cvector_parallel_t *pool, void *elems, size_t size,
+                                             size_t elem_size, void *acc,
+                                             void (*combine)(void *acc, const void *elem,
+                                                             void *ctx),
+                                             void *ctx) {
+  size_t count = pool->cvector_parallel__count_m;
+  char *partials = malloc(count * elem_size);
+  if (partials == NULL) {
+    for (size_t i = 0; i < size; i++) {
+      combine(acc, (char *)elems + i * elem_size, ctx);
+    }
+    return;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    memcpy(partials + i * elem_size, acc, elem_size);
+  }
+
+  cvector_parallel_op_t op = {.cvector_parallel_op__elems_m = elems,
+                              .cvector_parallel_op__elem_size_m = elem_size,
+                              .cvector_parallel_op__out_m = partials,
+                              .cvector_parallel_op__combine_m = combine,
+                              .cvector_parallel_op__ctx_m = ctx};
+  cvector_parallel__run_(pool, size, CVECTOR_PARALLEL__GRAIN, cvector_parallel__reduce_job_, &op);
+
+  for (size_t i = 0; i < count; i++) {
+    combine(acc, partials + i * elem_size, ctx);
+  }
+  free(partials);
+}
+
+/* PRIVATE: State shared by workers of sort passes. */
+typedef struct {
+  char *cvector_parallel_sort__src_m;
+  char *cvector_parallel_sort__dst_m;
+  size_t cvector_parallel_sort__size_m;
+  size_t cvector_parallel_sort__elem_size_m;
+  /* Length of sorted runs in 'src' */
+  size_t cvector_parallel_sort__width_m;
+  int (*cvector_parallel_sort__compare_m)(const void *, const void *);
+} cvector_parallel_sort_t;
+
+/* PRIVATE: Sorts blocks [begin, end) of 'width' elements in place. */
+static inline void cvector_parallel__sort_job_(void *ctx, size_t worker, size_t begin,
+                                               size_t end) {
+  cvector_parallel_sort_t *sort = ctx;
+  size_t size = sort->cvector_parallel_sort__size_m;
+  size_t width = sort->cvector_parallel_sort__width_m;
+  size_t elem_size = sort->cvector_parallel_sort__elem_size_m;
+  (void)worker;
+
+  for (size_t block = begin; block < end; block++) {
+    size_t first = block * width;
+    size_t last = (first + width < size) ? first + width : size;
+    first = (first < size) ? first : size;
+    qsort(sort->cvector_parallel_sort__src_m + first * elem_size, last - first, elem_size,
+          sort->cvector_parallel_sort__compare_m);
+  }
+}
+
+/* PRIVATE: Number of elements of 'a' among the first 'k' elements of the merge of sorted 'a' (of
+ * 'a_size' elements) and 'b' (of 'b_size' elements), ties going to 'a'. */
+static inline size_t cvector_parallel__corank_(const cvector_parallel_sort_t *sort, size_t k,
+                                               const char *a, size_t a_size, const char *b,
+                                               size_t b_size) {
+  size_t elem_size = sort->cvector_parallel_sort__elem_size_m;
+  size_t low = (k > b_size) ? k - b_size : 0;
+  size_t high = (k < a_size) ? k : a_size;
+
+  while (low < high) {
+    size_t i = low + (high - low) / 2;
+    size_t j = k - i;
+    if (sort->cvector_parallel_sort__compare_m(a + i * elem_size, b + (j - 1) * elem_size) <= 0) {
+      low = i + 1;
+    } else {
+      high = i;
+    }
+  }
+  return low;
+}
+
+/* PRIVATE: Writes output positions [begin, end) of one merge pass: pairs of 'width' runs of 'src'
+ * are merged into runs of 2 * 'width' in 'dst'. Each piece finds its inputs by binary search, so
+ * any split of the output between workers is valid. */
+static inline void cvector_parallel__merge_job_(void *ctx, size_t worker, size_t begin,
+                                                size_t end) {
+  cvector_parallel_sort_t *sort = ctx;
+  size_t size = sort->cvector_parallel_sort__size_m;
+  size_t width = sort->cvector_parallel_sort__width_m;
+  size_t elem_size = sort->cvector_parallel_sort__elem_size_m;
+  (void)worker;
+
+  while (begin < end) {
+    size_t pair = begin - begin % (2 * width);
+    size_t middle = (pair + width < size) ? pair + width : size;
+    size_t pair_end = (middle + width < size) ? middle + width : size;
+    size_t stop = (end < pair_end) ? end : pair_end;
+
+    const char *a = sort->cvector_parallel_sort__src_m + pair * elem_size;
+    const char *b = sort->cvector_parallel_sort__src_m + middle * elem_size;
+    size_t a_size = middle - pair;
+    size_t b_size = pair_end - middle;
+
+    size_t i = cvector_parallel__corank_(sort, begin - pair, a, a_size, b, b_size);
+    size_t j = (begin - pair) - i;
+    char *out = sort->cvector_parallel_sort__dst_m + begin * elem_size;
+
+    for (size_t at = begin; at < stop; at++, out += elem_size) {
+      if ((j >= b_size) || ((i < a_size) && (sort->cvector_parallel_sort__compare_m(
+                                                 a + i * elem_size, b + j * elem_size) <= 0))) {
+        memcpy(out, a + (i++) * elem_size, elem_size);
+      } else {
+        memcpy(out, b + (j++) * elem_size, elem_size);
+      }
+    }
+    begin = stop;
+  }
+}
+
+/* PRIVATE: Copy job, moves [begin, end) elements from 'src' to 'dst'. */
+static inline void cvector_parallel__copy_job_(void *ctx, size_t worker, size_t begin,
+                                               size_t end) {
+  cvector_parallel_sort_t *sort = ctx;
+  size_t elem_size = sort->cvector_parallel_sort__elem_size_m;
+  (void)worker;
+
+  memcpy(sort->cvector_parallel_sort__dst_m + begin * elem_size,
+         sort->cvector_parallel_sort__src_m + begin * elem_size, (end - begin) * elem_size);
+}
+
+/* PRIVATE: Sorts 'size' elements with merge sort in parallel. Not stable. */
+static inline void cvector_parallel__sort_(cvector_parallel_t *pool, void *elems, size_t size,
+                                           size_t elem_size,
+                                           int (*compare)(const void *, const void *)) {
+  size_t count = pool->cvector_parallel__count_m;
+  bool parallel = (count > 1) && (size >= CVECTOR_PARALLEL__SORT_THRESHOLD);
+  char *scratch = parallel ? malloc(size * elem_size) : NULL;
+  if (scratch == NULL) {
+    qsort(elems, size, elem_size, compare);
+    return;
+  }
+
+  // Blocks of equal size, a few per worker so that stealing evens out the block sorts.
+  size_t blocks = count * 4;
+  cvector_parallel_sort_t sort = {.cvector_parallel_sort__src_m = elems,
+                                  .cvector_parallel_sort__dst_m = scratch,
+                                  .cvector_parallel_sort__size_m = size,
+                                  .cvector_parallel_sort__elem_size_m = elem_size,
+                                  .cvector_parallel_sort__width_m = (size + blocks - 1) / blocks,
+                                  .cvector_parallel_sort__compare_m = compare};
+  cvector_parallel__run_(pool, blocks, 1, cvector_parallel__sort_job_, &sort);
+
+  while (sort.cvector_parallel_sort__width_m < size) {
+    cvector_parallel__run_(pool, size, CVECTOR_PARALLEL__GRAIN, cvector_parallel__merge_job_,
+                           &sort);
+    char *merged = sort.cvector_parallel_sort__dst_m;
+    sort.cvector_parallel_sort__dst_m = sort.cvector_parallel_sort__src_m;
+    sort.cvector_parallel_sort__src_m = merged;
+    sort.cvector_parallel_sort__width_m *= 2;
+  }
+
+  if (sort.cvector_parallel_sort__src_m != elems) {
+    sort.cvector_parallel_sort__dst_m = elems;
+    cvector_parallel__run_(pool, size, CVECTOR_PARALLEL__GRAIN, cvector_parallel__copy_job_,
+                           &sort);
+  }
+  free(scratch);
+}
+
+/* PUBLIC: Starts pool of 'threads' workers (the calling thread counts as one).
+ * 0 starts one worker per online CPU.
+ * Returns -1 (error) if memory or threads can't be had, nothing is left running then.
+ */
+#define cvector_parallel__init(pool, threads) (cvector_parallel__init_((pool), (threads)))
+
+/* PUBLIC: Returns number of workers of pool. */
+#define cvector_parallel__count(pool) ((pool)->cvector_parallel__count_m)
+
+/* PUBLIC: Stops and joins workers. */
+#define cvector_parallel__destroy(pool) (cvector_parallel__destroy_(pool))
+
+/* PUBLIC: Calls 'fn(void *elem, void *ctx)' on every element, in parallel and in no given order.
+ * 'elem' points to a T. */
+#define cvector__parallel_for_each(pool, vec, fn, ctx)                                             \
+  ((cvector__unshare(vec) == 0)                                                                    \
+       ? cvector_parallel__for_each_((pool), (cvector__elem_(vec)), cvector__size(vec),            \
+                                     cvector__elem_size_(vec), (fn), (ctx))                        \
+       : (void)0)
+
+/* PUBLIC: Replaces content of vector 'out' (of any element type) with 'fn(const void *elem,
+ * void *out_elem, void *ctx)' of every element of 'vec', 'elem' pointing to a T and 'out_elem' to
+ * a U. 'out' is resized once, up front.
+ */
+#define cvector__parallel_map(pool, vec, out, fn, ctx)                                             \
+  do {                                                                                             \
+    cvector__setsize_((out), 0);                                                                   \
+    if (cvector__unshare(out) == 0) {                                                              \
+      cvector__reserve((out), cvector__size(vec));                                                 \
+    }                                                                                              \
+    if (cvector__cap_(out) >= cvector__size(vec)) {                                                \
+      cvector_parallel__map_((pool), (cvector__elem_(vec)), cvector__size(vec),                    \
+                             cvector__elem_size_(vec), (cvector__elem_(out)),                      \
+                             cvector__elem_size_(out), (fn), (ctx));                               \
+      cvector__setsize_((out), cvector__size(vec));                                                \
+    }                                                                                              \
+  } while (0)
+
+/* PUBLIC: Returns all elements folded with 'combine(void *acc, const void *elem, void *ctx)',
+ * both pointing to a T, starting from 'identity'. Elements are folded in no given order, so
+ * 'combine' must be associative and commutative, and 'identity' must not change the result
+ * (e.g. 0 for sums).
+ */
+#define cvector__parallel_reduce(pool, vec, identity, combine, ctx)                                \
+  ({                                                                                               \
+    __typeof__(*(cvector__elem_(vec))) cvector__acc_m = (identity);                                \
+    cvector_parallel__reduce_((pool), (cvector__elem_(vec)), cvector__size(vec),                   \
+                              cvector__elem_size_(vec), &cvector__acc_m, (combine), (ctx));        \
+    cvector__acc_m;                                                                                \
+  })
+
+/* PUBLIC: Sorts vector with qsort-like 'compare' using every worker. Not stable.
+ * Uses a scratch buffer as big as the vector.
+ */
+#define cvector__parallel_sort(pool, vec, compare)                                                 \
+  ((cvector__unshare(vec) == 0)                                                                    \
+       ? cvector_parallel__sort_((pool), (cvector__elem_(vec)), cvector__size(vec),                \
+                                 cvector__elem_size_(vec), (compare))                              \
+       : (void)0)
+
+#endif /* cvector_parallel_h */
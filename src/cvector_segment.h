@@ -0,0 +1,44 @@
+/*
+ * Segment arithmetic shared by the segmented vectors of cvector ('CVector_concurrent',
+ * 'CVector_stable').
+ *
+ * Storage is a fixed table of segments whose sizes double (32, 64, 128, ... elements), so a vector
+ * grows by allocating the next segment and never moves existing elements. Element 'index' lives
+ * in segment 'cvector_segment__of_(index)', found with a single count-leading-zeros, at position
+ * 'cvector_segment__offset_(index, segment)'.
+ */
+
+#ifndef cvector_segment_h
+#define cvector_segment_h
+
+#include <stddef.h>
+
+/* log2 of the number of elements in the first segment. */
+#ifndef CVECTOR_SEGMENT__FIRST_BITS
+#define CVECTOR_SEGMENT__FIRST_BITS 5
+#endif
+
+/* PRIVATE: Number of elements in first segment. */
+#define CVECTOR_SEGMENT__FIRST_ ((size_t)1 << CVECTOR_SEGMENT__FIRST_BITS)
+
+/* PRIVATE: Number of segments needed to address every size_t index. */
+#define CVECTOR_SEGMENT__COUNT_ (64 - CVECTOR_SEGMENT__FIRST_BITS)
+
+/* PRIVATE: Segment holding element 'index'. Segment k holds FIRST << k elements. */
+static inline size_t cvector_segment__of_(size_t index) {
+  return (size_t)(63 - __builtin_clzll((unsigned long long)(index + CVECTOR_SEGMENT__FIRST_))) -
+         CVECTOR_SEGMENT__FIRST_BITS;
+}
+
+/* PRIVATE: Position of element 'index' inside its segment 'segment'. */
+#define cvector_segment__offset_(index, segment)                                                   \
+  (((index) + CVECTOR_SEGMENT__FIRST_) - (CVECTOR_SEGMENT__FIRST_ << (segment)))
+
+/* PRIVATE: Number of elements in segment 'segment'. */
+#define cvector_segment__size_(segment) (CVECTOR_SEGMENT__FIRST_ << (segment))
+
+/* PRIVATE: Number of elements in segments 0 to 'segments' - 1 together. */
+#define cvector_segment__total_(segments)                                                          \
+  (CVECTOR_SEGMENT__FIRST_ * (((size_t)1 << (segments)) - 1))
+
+#endif /* cvector_segment_h */
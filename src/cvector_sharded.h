@@ -0,0 +1,233 @@
+/*
+ * Per-thread sharded vectors for cvector.
+ *
+ * 'CVector_sharded(T)' holds one 'CVector(T)' compatible shard per worker. Each worker appends to
+ * its own shard with the regular vector API, so the append path shares nothing. Shards are aligned
+ * and padded to CVECTOR_SHARDED__CACHE_LINE so that two of them never share a cache line.
+ *
+ * Once the workers are done, 'cvector__sharded_collect' concatenates every shard into one vector
+ * with a single allocation, copying big results in parallel.
+ *
+ * For example:
+ *
+ * CVector(int) cvector_int_t;
+ * CVector_sharded(int) cvector_sharded_int_t;
+ *
+ * cvector_sharded_int_t results;
+ * cvector__sharded_init(&results, workers);
+ *
+ * // In worker 'id'
+ * cvector__add(cvector__sharded_shard(&results, id), 42);
+ *
+ * // After joining the workers
+ * cvector_int_t all;
+ * cvector__init(&all);
+ * cvector__sharded_collect(&results, &all);
+ *
+ * cvector__sharded_free(&results);
+ */
+
+#ifndef cvector_sharded_h
+#define cvector_sharded_h
+
+#include "cvector.h"
+
+#include <pthread.h>
+
+/* Size of cache line shards are padded to. */
+#ifndef CVECTOR_SHARDED__CACHE_LINE
+#define CVECTOR_SHARDED__CACHE_LINE 64
+#endif
+
+/* Collected results of at least this many bytes are copied in parallel. */
+#ifndef CVECTOR_SHARDED__PARALLEL_BYTES
+#define CVECTOR_SHARDED__PARALLEL_BYTES (4 * 1024 * 1024)
+#endif
+
+/* Maximum number of threads copying shards during collect. */
+#ifndef CVECTOR_SHARDED__COPY_THREADS
+#define CVECTOR_SHARDED__COPY_THREADS 8
+#endif
+
+/*
+ * Macro to create sharded vector type of elements of type 'cvector__elem_type_'.
+ * Every shard has the fields of 'CVector(T)' so all vector macros work on it.
+ */
+#define CVector_sharded(cvector__elem_type_)                                                       \
+  typedef struct {                                                                                 \
+    /* Shards, one cache line aligned vector each */                                               \
+    struct {                                                                                       \
+      _Alignas(CVECTOR_SHARDED__CACHE_LINE) CVECTOR__FIELDS_(cvector__elem_type_)                  \
+    } * cvector_sharded__shards_m;                                                                 \
+    /* Number of shards */                                                                         \
+    size_t cvector_sharded__count_m;                                                               \
+  }
+
+/* PRIVATE: Part of concatenated output copied by one thread. */
+typedef struct {
+  /* Output buffer */
+  char *cvector_sharded_copy__dst_m;
+  /* Shard buffers and their byte sizes */
+  char **cvector_sharded_copy__srcs_m;
+  size_t *cvector_sharded_copy__bytes_m;
+  size_t cvector_sharded_copy__count_m;
+  /* Byte range of output copied by this thread */
+  size_t cvector_sharded_copy__begin_m;
+  size_t cvector_sharded_copy__end_m;
+} cvector_sharded_copy_t;
+
+/* PRIVATE: Copies byte range [begin, end) of the concatenation of shards into output. */
+static inline void *cvector_sharded__copy_range_(void *arg) {
+  cvector_sharded_copy_t *copy = arg;
+  size_t offset = 0;
+
+  for (size_t i = 0; i < copy->cvector_sharded_copy__count_m; i++) {
+    size_t bytes = copy->cvector_sharded_copy__bytes_m[i];
+    size_t begin = (copy->cvector_sharded_copy__begin_m > offset)
+                       ? copy->cvector_sharded_copy__begin_m
+                       : offset;
+    size_t end = (copy->cvector_sharded_copy__end_m < offset + bytes)
+                     ? copy->cvector_sharded_copy__end_m
+                     : offset + bytes;
+    if (begin < end) {
+      memcpy(copy->cvector_sharded_copy__dst_m + begin,
+             copy->cvector_sharded_copy__srcs_m[i] + (begin - offset), end - begin);
+    }
+    offset += bytes;
+  }
+  return NULL;
+}
+
+/* PRIVATE: Concatenates 'count' buffers into 'dst'. The output is split into equal byte ranges,
+ * one per thread, so uneven shards still spread the work evenly. */
+static inline void cvector_sharded__concat_(char *dst, char **srcs, size_t *bytes, size_t count,
+                                            size_t total) {
+  size_t threads = total / CVECTOR_SHARDED__PARALLEL_BYTES + 1;
+  threads = (threads > CVECTOR_SHARDED__COPY_THREADS) ? CVECTOR_SHARDED__COPY_THREADS : threads;
+
+  cvector_sharded_copy_t copies[CVECTOR_SHARDED__COPY_THREADS];
+  pthread_t workers[CVECTOR_SHARDED__COPY_THREADS];
+  bool spawned[CVECTOR_SHARDED__COPY_THREADS];
+
+  size_t range = total / threads;
+  for (size_t i = 0; i < threads; i++) {
+    copies[i] = (cvector_sharded_copy_t){.cvector_sharded_copy__dst_m = dst,
+                                         .cvector_sharded_copy__srcs_m = srcs,
+                                         .cvector_sharded_copy__bytes_m = bytes,
+                                         .cvector_sharded_copy__count_m = count,
+                                         .cvector_sharded_copy__begin_m = range * i,
+                                         .cvector_sharded_copy__end_m =
+                                             (i + 1 == threads) ? total : range * (i + 1)};
+  }
+
+  // The calling thread copies the first range, helpers the others (or the caller if spawn fails).
+  for (size_t i = 1; i < threads; i++) {
+    spawned[i] = (pthread_create(&workers[i], NULL, cvector_sharded__copy_range_, &copies[i]) == 0);
+    if (!spawned[i]) {
+      cvector_sharded__copy_range_(&copies[i]);
+    }
+  }
+
+  cvector_sharded__copy_range_(&copies[0]);
+
+  for (size_t i = 1; i < threads; i++) {
+    if (spawned[i]) {
+      pthread_join(workers[i], NULL);
+    }
+  }
+}
+
+/* PUBLIC: Returns shard at given index, a vector usable with every 'cvector__*' macro. */
+#define cvector__sharded_shard(sharded, index) (&((sharded)->cvector_sharded__shards_m[(index)]))
+
+/* PUBLIC: Returns number of shards. */
+#define cvector__sharded_count(sharded) ((sharded)->cvector_sharded__count_m)
+
+/* PUBLIC: Initializes sharded vector with 'count' empty shards.
+ * Returns -1 (error) if the shards can't be allocated, the sharded vector then has no shard.
+ */
+#define cvector__sharded_init(sharded, count)                                                      \
+  ({                                                                                               \
+    size_t cvector__count_m = (count);                                                             \
+    size_t cvector__bytes_m = cvector__count_m * sizeof(*((sharded)->cvector_sharded__shards_m));  \
+    int cvector__result_m = 0;                                                                     \
+    (sharded)->cvector_sharded__shards_m =                                                         \
+        aligned_alloc(CVECTOR_SHARDED__CACHE_LINE, cvector__bytes_m);                              \
+    if (((sharded)->cvector_sharded__shards_m == NULL) && (cvector__count_m > 0)) {                \
+      cvector__count_m = 0;                                                                        \
+      cvector__result_m = -1;                                                                      \
+    }                                                                                              \
+    (sharded)->cvector_sharded__count_m = cvector__count_m;                                        \
+    for (size_t cvector__shard_m = 0; cvector__shard_m < cvector__count_m; cvector__shard_m++) {   \
+      cvector__init(cvector__sharded_shard((sharded), cvector__shard_m));                          \
+    }                                                                                              \
+    cvector__result_m;                                                                             \
+  })
+
+/* PUBLIC: Returns total number of elements in all shards. */
+#define cvector__sharded_size(sharded)                                                             \
+  ({                                                                                               \
+    size_t cvector__total_m = 0;                                                                   \
+    for (size_t cvector__shard_m = 0; cvector__shard_m < cvector__sharded_count(sharded);          \
+         cvector__shard_m++) {                                                                     \
+      cvector__total_m += cvector__size(cvector__sharded_shard((sharded), cvector__shard_m));      \
+    }                                                                                              \
+    cvector__total_m;                                                                              \
+  })
+
+/* PUBLIC: Appends content of every shard, in shard order, to vector 'vec' of the same element
+ * type. 'vec' is resized exactly once; results of CVECTOR_SHARDED__PARALLEL_BYTES or more are
+ * copied by up to CVECTOR_SHARDED__COPY_THREADS threads. Shards are left untouched.
+ * Returns -1 (error) if memory can't be allocated, 'vec' is then unchanged.
+ * NOTE: Call it once every worker is done appending.
+ */
+#define cvector__sharded_collect(sharded, vec)                                                     \
+  ({                                                                                               \
+    int cvector__result_m = 0;                                                                     \
+    size_t cvector__count_m = cvector__sharded_count(sharded);                                     \
+    size_t cvector__total_m = cvector__sharded_size(sharded);                                      \
+    char *cvector__srcs_m[cvector__count_m + 1];                                                   \
+    size_t cvector__bytes_m[cvector__count_m + 1];                                                 \
+    for (size_t cvector__shard_m = 0; cvector__shard_m < cvector__count_m; cvector__shard_m++) {   \
+      cvector__srcs_m[cvector__shard_m] =                                                          \
+          (char *)cvector__elem_(cvector__sharded_shard((sharded), cvector__shard_m));             \
+      cvector__bytes_m[cvector__shard_m] =                                                         \
+          cvector__size(cvector__sharded_shard((sharded), cvector__shard_m)) *                     \
+          cvector__elem_size_(vec);                                                                \
+    }                                                                                              \
+    if (cvector__total_m > 0) {                                                                    \
+      cvector__reserve((vec), (cvector__size(vec) + cvector__total_m));                            \
+      if (cvector__total_m <= cvector__cap_(vec) - cvector__size(vec)) {                           \
+        cvector_sharded__concat_((char *)((cvector__elem_(vec)) + cvector__size(vec)),             \
+                                 cvector__srcs_m, cvector__bytes_m, cvector__count_m,              \
+                                 cvector__total_m * cvector__elem_size_(vec));                     \
+        cvector__setsize_((vec), (cvector__size(vec) + cvector__total_m));                         \
+      } else {                                                                                     \
+        cvector__result_m = -1;                                                                    \
+      }                                                                                            \
+    }                                                                                              \
+    cvector__result_m;                                                                             \
+  })
+
+/* PUBLIC: Empties every shard, keeping their capacity for the next round. */
+#define cvector__sharded_clear(sharded)                                                            \
+  do {                                                                                             \
+    for (size_t cvector__shard_m = 0; cvector__shard_m < cvector__sharded_count(sharded);          \
+         cvector__shard_m++) {                                                                     \
+      cvector__setsize_(cvector__sharded_shard((sharded), cvector__shard_m), 0);                   \
+    }                                                                                              \
+  } while (0)
+
+/* PUBLIC: Frees every shard and the shard table. */
+#define cvector__sharded_free(sharded)                                                             \
+  do {                                                                                             \
+    for (size_t cvector__shard_m = 0; cvector__shard_m < cvector__sharded_count(sharded);          \
+         cvector__shard_m++) {                                                                     \
+      cvector__free(cvector__sharded_shard((sharded), cvector__shard_m));                          \
+    }                                                                                              \
+    free((sharded)->cvector_sharded__shards_m);                                                    \
+    (sharded)->cvector_sharded__shards_m = NULL;                                                   \
+    (sharded)->cvector_sharded__count_m = 0;                                                       \
+  } while (0)
+
+#endif /* cvector_sharded_h */
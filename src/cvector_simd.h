@@ -0,0 +1,648 @@
+/*
+ * SIMD scan kernels for numeric cvector.
+ *
+ * Find-first, count-equal, min/max and sum over 'CVector(int)', 'CVector(float)' and
+ * 'CVector(double)'. Every kernel exists in a scalar, an SSE2, an AVX2 and an AVX-512 flavour.
+ * The best flavour the CPU supports is picked at runtime (CPUID through '__builtin_cpu_supports'),
+ * so one binary runs everywhere while using the widest vectors available. The vector flavours are
+ * compiled with target attributes, no '-mavx2' or '-mavx512f' is needed.
+ *
+ * For example:
+ *
+ * CVector(float) cvector_float_t;
+ *
+ * ptrdiff_t at = cvector__find(&column, 3.5f);   // -1 if missing
+ * size_t hits = cvector__count(&column, 0.0f);
+ *
+ * float min, max;
+ * if (cvector__minmax(&column, &min, &max) == 0) {
+ *   // column isn't empty
+ * }
+ *
+ * float total = cvector__sum(&column);
+ *
+ * NOTE: Vector flavours add floating point values in another order than a plain loop, so float
+ * and double sums may differ from it in the last bits. 'int' sums are exact (64 bit). Min/max of
+ * columns holding NaN is unspecified.
+ */
+
+#ifndef cvector_simd_h
+#define cvector_simd_h
+
+#include "cvector.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CVECTOR_SIMD__X86_ 1
+#include <immintrin.h>
+#endif
+
+/* Instruction set levels, each implies the previous ones. */
+#define CVECTOR_SIMD__SCALAR 0
+#define CVECTOR_SIMD__SSE2 1
+#define CVECTOR_SIMD__AVX2 2
+#define CVECTOR_SIMD__AVX512 3
+
+/* PRIVATE: Level used by kernels, -1 until detected. Weak, so every translation unit including
+ * this header shares one copy, and only accessed atomically since kernels may detect the level
+ * from several threads at once. */
+__attribute__((weak)) int cvector_simd__level_m = -1;
+
+/* PRIVATE: Highest level supported by the CPU. */
+static inline int cvector_simd__detect_(void) {
+#ifdef CVECTOR_SIMD__X86_
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return CVECTOR_SIMD__AVX512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return CVECTOR_SIMD__AVX2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return CVECTOR_SIMD__SSE2;
+  }
+#endif
+  return CVECTOR_SIMD__SCALAR;
+}
+
+/* PUBLIC: Returns level of kernels in use, the highest one supported unless lowered. */
+static inline int cvector_simd__level(void) {
+  int level = __atomic_load_n(&cvector_simd__level_m, __ATOMIC_RELAXED);
+  if (level < 0) {
+    // Detection is idempotent, threads racing here all store the same value.
+    level = cvector_simd__detect_();
+    __atomic_store_n(&cvector_simd__level_m, level, __ATOMIC_RELAXED);
+  }
+  return level;
+}
+
+/* PUBLIC: Selects level of kernels, capped to what the CPU supports. Returns level in use.
+ * Meant for benchmarks and tests comparing flavours.
+ */
+static inline int cvector_simd__set_level(int level) {
+  int supported = cvector_simd__detect_();
+  level = (level < supported) ? level : supported;
+  __atomic_store_n(&cvector_simd__level_m, level, __ATOMIC_RELAXED);
+  return level;
+}
+
+/*
+ * PRIVATE: Scalar kernels of element type 'T' (named 'name') summed as 'S'.
+ * Also the tail loops of the vector kernels.
+ */
+#define CVECTOR_SIMD__SCALAR_KERNELS_(name, T, S)                                                  \
+  static inline ptrdiff_t cvector_simd__find_##name##_scalar_(const T *elems, size_t size,         \
+                                                               T value) {                          \
+    for (size_t i = 0; i < size; i++) {                                                            \
+      if (elems[i] == value) {                                                                     \
+        return (ptrdiff_t)i;                                                                       \
+      }                                                                                            \
+    }                                                                                              \
+    return -1;                                                                                     \
+  }                                                                                                \
+                                                                                                   \
+  static inline size_t cvector_simd__count_##name##_scalar_(const T *elems, size_t size,           \
+                                                             T value) {                            \
+    size_t count = 0;                                                                              \
+    for (size_t i = 0; i < size; i++) {                                                            \
+      count += (elems[i] == value);                                                                \
+    }                                                                                              \
+    return count;                                                                                  \
+  }                                                                                                \
+                                                                                                   \
+  static inline void cvector_simd__minmax_##name##_scalar_(const T *elems, size_t size, T *min,    \
+                                                            T *max) {                              \
+    for (size_t i = 0; i < size; i++) {                                                            \
+      *min = (elems[i] < *min) ? elems[i] : *min;                                                  \
+      *max = (elems[i] > *max) ? elems[i] : *max;                                                  \
+    }                                                                                              \
+  }                                                                                                \
+                                                                                                   \
+  static inline S cvector_simd__sum_##name##_scalar_(const T *elems, size_t size) {                \
+    S sum = 0;                                                                                     \
+    for (size_t i = 0; i < size; i++) {                                                            \
+      sum += elems[i];                                                                             \
+    }                                                                                              \
+    return sum;                                                                                    \
+  }
+
+CVECTOR_SIMD__SCALAR_KERNELS_(int, int, int64_t)
+CVECTOR_SIMD__SCALAR_KERNELS_(float, float, float)
+CVECTOR_SIMD__SCALAR_KERNELS_(double, double, double)
+
+#ifdef CVECTOR_SIMD__X86_
+
+/* PRIVATE: Target attributes of vector flavours. */
+#define CVECTOR_SIMD__TARGET_sse2 __attribute__((target("sse2")))
+#define CVECTOR_SIMD__TARGET_avx2 __attribute__((target("avx2")))
+#define CVECTOR_SIMD__TARGET_avx512 __attribute__((target("avx512f")))
+
+/* PRIVATE: Integer vector type of each instruction set, counts equal lanes. */
+#define CVECTOR_SIMD__HITS_sse2 __m128i
+#define CVECTOR_SIMD__HITS_avx2 __m256i
+#define CVECTOR_SIMD__HITS_avx512 __m512i
+#define CVECTOR_SIMD__HITS_ZERO_sse2 _mm_setzero_si128
+#define CVECTOR_SIMD__HITS_ZERO_avx2 _mm256_setzero_si256
+#define CVECTOR_SIMD__HITS_ZERO_avx512 _mm512_setzero_si512
+
+/* PRIVATE: Vectors counted per lane before lane counts are flushed, so they never overflow. */
+#define CVECTOR_SIMD__HITS_FLUSH_ ((size_t)1 << 16)
+
+/* PRIVATE: Declares lane operation of instruction set 'isa'. */
+#define CVECTOR_SIMD__OP_(isa) static inline CVECTOR_SIMD__TARGET_##isa
+
+/*
+ * PRIVATE: Lane operations. For every instruction set and element type:
+ *   load/store (unaligned), set1 (broadcast), eq (bit mask of equal lanes), min, max,
+ *   zero/acc (add lanes to sum accumulator, widened to 64 bit for int), store_acc,
+ *   hits (add 1 to count of lanes that are equal) and hits_total (sum of lane counts).
+ */
+
+/* SSE2 */
+CVECTOR_SIMD__OP_(sse2) __m128i cvector_simd__load_int_sse2_(const int *p) {
+  return _mm_loadu_si128((const __m128i *)p);
+}
+CVECTOR_SIMD__OP_(sse2) void cvector_simd__store_int_sse2_(int *p, __m128i v) {
+  _mm_storeu_si128((__m128i *)p, v);
+}
+CVECTOR_SIMD__OP_(sse2) __m128i cvector_simd__set1_int_sse2_(int x) { return _mm_set1_epi32(x); }
+CVECTOR_SIMD__OP_(sse2) unsigned cvector_simd__eq_int_sse2_(__m128i a, __m128i b) {
+  return (unsigned)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, b)));
+}
+// SSE2 has no 32 bit integer min/max (SSE4.1 does), blend through a compare.
+CVECTOR_SIMD__OP_(sse2) __m128i cvector_simd__min_int_sse2_(__m128i a, __m128i b) {
+  __m128i greater = _mm_cmpgt_epi32(a, b);
+  return _mm_or_si128(_mm_and_si128(greater, b), _mm_andnot_si128(greater, a));
+}
+CVECTOR_SIMD__OP_(sse2) __m128i cvector_simd__max_int_sse2_(__m128i a, __m128i b) {
+  __m128i greater = _mm_cmpgt_epi32(a, b);
+  return _mm_or_si128(_mm_and_si128(greater, a), _mm_andnot_si128(greater, b));
+}
+CVECTOR_SIMD__OP_(sse2) __m128i cvector_simd__zero_int_sse2_(void) { return _mm_setzero_si128(); }
+CVECTOR_SIMD__OP_(sse2) __m128i cvector_simd__acc_int_sse2_(__m128i acc, __m128i v) {
+  __m128i sign = _mm_cmpgt_epi32(_mm_setzero_si128(), v);
+  acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(v, sign));
+  return _mm_add_epi64(acc, _mm_unpackhi_epi32(v, sign));
+}
+CVECTOR_SIMD__OP_(sse2) void cvector_simd__store_acc_int_sse2_(int64_t *p, __m128i acc) {
+  _mm_storeu_si128((__m128i *)p, acc);
+}
+CVECTOR_SIMD__OP_(sse2) __m128i cvector_simd__hits_int_sse2_(__m128i hits, __m128i a, __m128i b) {
+  return _mm_sub_epi32(hits, _mm_cmpeq_epi32(a, b));
+}
+CVECTOR_SIMD__OP_(sse2) size_t cvector_simd__hits_total_int_sse2_(__m128i hits) {
+  uint32_t lanes[4];
+  _mm_storeu_si128((__m128i *)lanes, hits);
+  return (size_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+CVECTOR_SIMD__OP_(sse2) __m128 cvector_simd__load_float_sse2_(const float *p) {
+  return _mm_loadu_ps(p);
+}
+CVECTOR_SIMD__OP_(sse2) void cvector_simd__store_float_sse2_(float *p, __m128 v) {
+  _mm_storeu_ps(p, v);
+}
+CVECTOR_SIMD__OP_(sse2) __m128 cvector_simd__set1_float_sse2_(float x) { return _mm_set1_ps(x); }
+CVECTOR_SIMD__OP_(sse2) unsigned cvector_simd__eq_float_sse2_(__m128 a, __m128 b) {
+  return (unsigned)_mm_movemask_ps(_mm_cmpeq_ps(a, b));
+}
+CVECTOR_SIMD__OP_(sse2) __m128 cvector_simd__min_float_sse2_(__m128 a, __m128 b) {
+  return _mm_min_ps(a, b);
+}
+CVECTOR_SIMD__OP_(sse2) __m128 cvector_simd__max_float_sse2_(__m128 a, __m128 b) {
+  return _mm_max_ps(a, b);
+}
+CVECTOR_SIMD__OP_(sse2) __m128 cvector_simd__zero_float_sse2_(void) { return _mm_setzero_ps(); }
+CVECTOR_SIMD__OP_(sse2) __m128 cvector_simd__acc_float_sse2_(__m128 acc, __m128 v) {
+  return _mm_add_ps(acc, v);
+}
+CVECTOR_SIMD__OP_(sse2) void cvector_simd__store_acc_float_sse2_(float *p, __m128 acc) {
+  _mm_storeu_ps(p, acc);
+}
+CVECTOR_SIMD__OP_(sse2) __m128i cvector_simd__hits_float_sse2_(__m128i hits, __m128 a, __m128 b) {
+  return _mm_sub_epi32(hits, _mm_castps_si128(_mm_cmpeq_ps(a, b)));
+}
+CVECTOR_SIMD__OP_(sse2) size_t cvector_simd__hits_total_float_sse2_(__m128i hits) {
+  return cvector_simd__hits_total_int_sse2_(hits);
+}
+
+CVECTOR_SIMD__OP_(sse2) __m128d cvector_simd__load_double_sse2_(const double *p) {
+  return _mm_loadu_pd(p);
+}
+CVECTOR_SIMD__OP_(sse2) void cvector_simd__store_double_sse2_(double *p, __m128d v) {
+  _mm_storeu_pd(p, v);
+}
+CVECTOR_SIMD__OP_(sse2) __m128d cvector_simd__set1_double_sse2_(double x) { return _mm_set1_pd(x); }
+CVECTOR_SIMD__OP_(sse2) unsigned cvector_simd__eq_double_sse2_(__m128d a, __m128d b) {
+  return (unsigned)_mm_movemask_pd(_mm_cmpeq_pd(a, b));
+}
+CVECTOR_SIMD__OP_(sse2) __m128d cvector_simd__min_double_sse2_(__m128d a, __m128d b) {
+  return _mm_min_pd(a, b);
+}
+CVECTOR_SIMD__OP_(sse2) __m128d cvector_simd__max_double_sse2_(__m128d a, __m128d b) {
+  return _mm_max_pd(a, b);
+}
+CVECTOR_SIMD__OP_(sse2) __m128d cvector_simd__zero_double_sse2_(void) { return _mm_setzero_pd(); }
+CVECTOR_SIMD__OP_(sse2) __m128d cvector_simd__acc_double_sse2_(__m128d acc, __m128d v) {
+  return _mm_add_pd(acc, v);
+}
+CVECTOR_SIMD__OP_(sse2) void cvector_simd__store_acc_double_sse2_(double *p, __m128d acc) {
+  _mm_storeu_pd(p, acc);
+}
+CVECTOR_SIMD__OP_(sse2) __m128i cvector_simd__hits_double_sse2_(__m128i hits, __m128d a,
+                                                                 __m128d b) {
+  return _mm_sub_epi64(hits, _mm_castpd_si128(_mm_cmpeq_pd(a, b)));
+}
+CVECTOR_SIMD__OP_(sse2) size_t cvector_simd__hits_total_double_sse2_(__m128i hits) {
+  uint64_t lanes[2];
+  _mm_storeu_si128((__m128i *)lanes, hits);
+  return (size_t)(lanes[0] + lanes[1]);
+}
+
+/* AVX2 */
+CVECTOR_SIMD__OP_(avx2) __m256i cvector_simd__load_int_avx2_(const int *p) {
+  return _mm256_loadu_si256((const __m256i *)p);
+}
+CVECTOR_SIMD__OP_(avx2) void cvector_simd__store_int_avx2_(int *p, __m256i v) {
+  _mm256_storeu_si256((__m256i *)p, v);
+}
+CVECTOR_SIMD__OP_(avx2) __m256i cvector_simd__set1_int_avx2_(int x) { return _mm256_set1_epi32(x); }
+CVECTOR_SIMD__OP_(avx2) unsigned cvector_simd__eq_int_avx2_(__m256i a, __m256i b) {
+  return (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)));
+}
+CVECTOR_SIMD__OP_(avx2) __m256i cvector_simd__min_int_avx2_(__m256i a, __m256i b) {
+  return _mm256_min_epi32(a, b);
+}
+CVECTOR_SIMD__OP_(avx2) __m256i cvector_simd__max_int_avx2_(__m256i a, __m256i b) {
+  return _mm256_max_epi32(a, b);
+}
+CVECTOR_SIMD__OP_(avx2) __m256i cvector_simd__zero_int_avx2_(void) {
+  return _mm256_setzero_si256();
+}
+CVECTOR_SIMD__OP_(avx2) __m256i cvector_simd__acc_int_avx2_(__m256i acc, __m256i v) {
+  acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+  return _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+}
+CVECTOR_SIMD__OP_(avx2) void cvector_simd__store_acc_int_avx2_(int64_t *p, __m256i acc) {
+  _mm256_storeu_si256((__m256i *)p, acc);
+}
+CVECTOR_SIMD__OP_(avx2) __m256i cvector_simd__hits_int_avx2_(__m256i hits, __m256i a, __m256i b) {
+  return _mm256_sub_epi32(hits, _mm256_cmpeq_epi32(a, b));
+}
+CVECTOR_SIMD__OP_(avx2) size_t cvector_simd__hits_total_int_avx2_(__m256i hits) {
+  uint32_t lanes[8];
+  _mm256_storeu_si256((__m256i *)lanes, hits);
+  size_t total = 0;
+  for (size_t lane = 0; lane < 8; lane++) {
+    total += lanes[lane];
+  }
+  return total;
+}
+
+CVECTOR_SIMD__OP_(avx2) __m256 cvector_simd__load_float_avx2_(const float *p) {
+  return _mm256_loadu_ps(p);
+}
+CVECTOR_SIMD__OP_(avx2) void cvector_simd__store_float_avx2_(float *p, __m256 v) {
+  _mm256_storeu_ps(p, v);
+}
+CVECTOR_SIMD__OP_(avx2) __m256 cvector_simd__set1_float_avx2_(float x) { return _mm256_set1_ps(x); }
+CVECTOR_SIMD__OP_(avx2) unsigned cvector_simd__eq_float_avx2_(__m256 a, __m256 b) {
+  return (unsigned)_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ));
+}
+CVECTOR_SIMD__OP_(avx2) __m256 cvector_simd__min_float_avx2_(__m256 a, __m256 b) {
+  return _mm256_min_ps(a, b);
+}
+CVECTOR_SIMD__OP_(avx2) __m256 cvector_simd__max_float_avx2_(__m256 a, __m256 b) {
+  return _mm256_max_ps(a, b);
+}
+CVECTOR_SIMD__OP_(avx2) __m256 cvector_simd__zero_float_avx2_(void) { return _mm256_setzero_ps(); }
+CVECTOR_SIMD__OP_(avx2) __m256 cvector_simd__acc_float_avx2_(__m256 acc, __m256 v) {
+  return _mm256_add_ps(acc, v);
+}
+CVECTOR_SIMD__OP_(avx2) void cvector_simd__store_acc_float_avx2_(float *p, __m256 acc) {
+  _mm256_storeu_ps(p, acc);
+}
+CVECTOR_SIMD__OP_(avx2) __m256i cvector_simd__hits_float_avx2_(__m256i hits, __m256 a, __m256 b) {
+  return _mm256_sub_epi32(hits, _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_EQ_OQ)));
+}
+CVECTOR_SIMD__OP_(avx2) size_t cvector_simd__hits_total_float_avx2_(__m256i hits) {
+  return cvector_simd__hits_total_int_avx2_(hits);
+}
+
+CVECTOR_SIMD__OP_(avx2) __m256d cvector_simd__load_double_avx2_(const double *p) {
+  return _mm256_loadu_pd(p);
+}
+CVECTOR_SIMD__OP_(avx2) void cvector_simd__store_double_avx2_(double *p, __m256d v) {
+  _mm256_storeu_pd(p, v);
+}
+CVECTOR_SIMD__OP_(avx2) __m256d cvector_simd__set1_double_avx2_(double x) {
+  return _mm256_set1_pd(x);
+}
+CVECTOR_SIMD__OP_(avx2) unsigned cvector_simd__eq_double_avx2_(__m256d a, __m256d b) {
+  return (unsigned)_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_EQ_OQ));
+}
+CVECTOR_SIMD__OP_(avx2) __m256d cvector_simd__min_double_avx2_(__m256d a, __m256d b) {
+  return _mm256_min_pd(a, b);
+}
+CVECTOR_SIMD__OP_(avx2) __m256d cvector_simd__max_double_avx2_(__m256d a, __m256d b) {
+  return _mm256_max_pd(a, b);
+}
+CVECTOR_SIMD__OP_(avx2) __m256d cvector_simd__zero_double_avx2_(void) {
+  return _mm256_setzero_pd();
+}
+CVECTOR_SIMD__OP_(avx2) __m256d cvector_simd__acc_double_avx2_(__m256d acc, __m256d v) {
+  return _mm256_add_pd(acc, v);
+}
+CVECTOR_SIMD__OP_(avx2) void cvector_simd__store_acc_double_avx2_(double *p, __m256d acc) {
+  _mm256_storeu_pd(p, acc);
+}
+CVECTOR_SIMD__OP_(avx2) __m256i cvector_simd__hits_double_avx2_(__m256i hits, __m256d a,
+                                                                 __m256d b) {
+  return _mm256_sub_epi64(hits, _mm256_castpd_si256(_mm256_cmp_pd(a, b, _CMP_EQ_OQ)));
+}
+CVECTOR_SIMD__OP_(avx2) size_t cvector_simd__hits_total_double_avx2_(__m256i hits) {
+  uint64_t lanes[4];
+  _mm256_storeu_si256((__m256i *)lanes, hits);
+  return (size_t)(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+}
+
+/* AVX-512 */
+CVECTOR_SIMD__OP_(avx512) __m512i cvector_simd__load_int_avx512_(const int *p) {
+  return _mm512_loadu_si512((const void *)p);
+}
+CVECTOR_SIMD__OP_(avx512) void cvector_simd__store_int_avx512_(int *p, __m512i v) {
+  _mm512_storeu_si512((void *)p, v);
+}
+CVECTOR_SIMD__OP_(avx512) __m512i cvector_simd__set1_int_avx512_(int x) {
+  return _mm512_set1_epi32(x);
+}
+CVECTOR_SIMD__OP_(avx512) unsigned cvector_simd__eq_int_avx512_(__m512i a, __m512i b) {
+  return (unsigned)_mm512_cmpeq_epi32_mask(a, b);
+}
+CVECTOR_SIMD__OP_(avx512) __m512i cvector_simd__min_int_avx512_(__m512i a, __m512i b) {
+  return _mm512_min_epi32(a, b);
+}
+CVECTOR_SIMD__OP_(avx512) __m512i cvector_simd__max_int_avx512_(__m512i a, __m512i b) {
+  return _mm512_max_epi32(a, b);
+}
+CVECTOR_SIMD__OP_(avx512) __m512i cvector_simd__zero_int_avx512_(void) {
+  return _mm512_setzero_si512();
+}
+CVECTOR_SIMD__OP_(avx512) __m512i cvector_simd__acc_int_avx512_(__m512i acc, __m512i v) {
+  acc = _mm512_add_epi64(acc, _mm512_cvtepi32_epi64(_mm512_castsi512_si256(v)));
+  return _mm512_add_epi64(acc, _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(v, 1)));
+}
+CVECTOR_SIMD__OP_(avx512) void cvector_simd__store_acc_int_avx512_(int64_t *p, __m512i acc) {
+  _mm512_storeu_si512((void *)p, acc);
+}
+CVECTOR_SIMD__OP_(avx512) __m512i cvector_simd__hits_int_avx512_(__m512i hits, __m512i a,
+                                                                   __m512i b) {
+  return _mm512_mask_add_epi32(hits, _mm512_cmpeq_epi32_mask(a, b), hits, _mm512_set1_epi32(1));
+}
+CVECTOR_SIMD__OP_(avx512) size_t cvector_simd__hits_total_int_avx512_(__m512i hits) {
+  return (size_t)(uint32_t)_mm512_reduce_add_epi32(hits);
+}
+
+CVECTOR_SIMD__OP_(avx512) __m512 cvector_simd__load_float_avx512_(const float *p) {
+  return _mm512_loadu_ps(p);
+}
+CVECTOR_SIMD__OP_(avx512) void cvector_simd__store_float_avx512_(float *p, __m512 v) {
+  _mm512_storeu_ps(p, v);
+}
+CVECTOR_SIMD__OP_(avx512) __m512 cvector_simd__set1_float_avx512_(float x) {
+  return _mm512_set1_ps(x);
+}
+CVECTOR_SIMD__OP_(avx512) unsigned cvector_simd__eq_float_avx512_(__m512 a, __m512 b) {
+  return (unsigned)_mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ);
+}
+CVECTOR_SIMD__OP_(avx512) __m512 cvector_simd__min_float_avx512_(__m512 a, __m512 b) {
+  return _mm512_min_ps(a, b);
+}
+CVECTOR_SIMD__OP_(avx512) __m512 cvector_simd__max_float_avx512_(__m512 a, __m512 b) {
+  return _mm512_max_ps(a, b);
+}
+CVECTOR_SIMD__OP_(avx512) __m512 cvector_simd__zero_float_avx512_(void) {
+  return _mm512_setzero_ps();
+}
+CVECTOR_SIMD__OP_(avx512) __m512 cvector_simd__acc_float_avx512_(__m512 acc, __m512 v) {
+  return _mm512_add_ps(acc, v);
+}
+CVECTOR_SIMD__OP_(avx512) void cvector_simd__store_acc_float_avx512_(float *p, __m512 acc) {
+  _mm512_storeu_ps(p, acc);
+}
+CVECTOR_SIMD__OP_(avx512) __m512i cvector_simd__hits_float_avx512_(__m512i hits, __m512 a,
+                                                                     __m512 b) {
+  return _mm512_mask_add_epi32(hits, _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ), hits,
+                               _mm512_set1_epi32(1));
+}
+CVECTOR_SIMD__OP_(avx512) size_t cvector_simd__hits_total_float_avx512_(__m512i hits) {
+  return cvector_simd__hits_total_int_avx512_(hits);
+}
+
+CVECTOR_SIMD__OP_(avx512) __m512d cvector_simd__load_double_avx512_(const double *p) {
+  return _mm512_loadu_pd(p);
+}
+CVECTOR_SIMD__OP_(avx512) void cvector_simd__store_double_avx512_(double *p, __m512d v) {
+  _mm512_storeu_pd(p, v);
+}
+CVECTOR_SIMD__OP_(avx512) __m512d cvector_simd__set1_double_avx512_(double x) {
+  return _mm512_set1_pd(x);
+}
+CVECTOR_SIMD__OP_(avx512) unsigned cvector_simd__eq_double_avx512_(__m512d a, __m512d b) {
+  return (unsigned)_mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ);
+}
+CVECTOR_SIMD__OP_(avx512) __m512d cvector_simd__min_double_avx512_(__m512d a, __m512d b) {
+  return _mm512_min_pd(a, b);
+}
+CVECTOR_SIMD__OP_(avx512) __m512d cvector_simd__max_double_avx512_(__m512d a, __m512d b) {
+  return _mm512_max_pd(a, b);
+}
+CVECTOR_SIMD__OP_(avx512) __m512d cvector_simd__zero_double_avx512_(void) {
+  return _mm512_setzero_pd();
+}
+CVECTOR_SIMD__OP_(avx512) __m512d cvector_simd__acc_double_avx512_(__m512d acc, __m512d v) {
+  return _mm512_add_pd(acc, v);
+}
+CVECTOR_SIMD__OP_(avx512) void cvector_simd__store_acc_double_avx512_(double *p, __m512d acc) {
+  _mm512_storeu_pd(p, acc);
+}
+CVECTOR_SIMD__OP_(avx512) __m512i cvector_simd__hits_double_avx512_(__m512i hits, __m512d a,
+                                                                      __m512d b) {
+  return _mm512_mask_add_epi64(hits, _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ), hits,
+                               _mm512_set1_epi64(1));
+}
+CVECTOR_SIMD__OP_(avx512) size_t cvector_simd__hits_total_double_avx512_(__m512i hits) {
+  return (size_t)_mm512_reduce_add_epi64(hits);
+}
+
+/*
+ * PRIVATE: Vector kernels of instruction set 'isa' for element type 'T' (named 'name') summed as
+ * 'S'. 'V' is the vector type holding 'W' elements, 'A' the accumulator type of sums holding
+ * 'AW' sums. Sums run on four independent accumulators to hide the latency of adds.
+ */
+#define CVECTOR_SIMD__KERNELS_(isa, name, T, S, V, W, A, AW)                                       \
+  CVECTOR_SIMD__OP_(isa)                                                                           \
+  ptrdiff_t cvector_simd__find_##name##_##isa##_(const T *elems, size_t size, T value) {           \
+    V needle = cvector_simd__set1_##name##_##isa##_(value);                                        \
+    size_t i = 0;                                                                                  \
+    for (; i + (W) <= size; i += (W)) {                                                            \
+      unsigned mask =                                                                              \
+          cvector_simd__eq_##name##_##isa##_(cvector_simd__load_##name##_##isa##_(elems + i),      \
+                                             needle);                                              \
+      if (mask != 0) {                                                                             \
+        return (ptrdiff_t)(i + (size_t)__builtin_ctz(mask));                                       \
+      }                                                                                            \
+    }                                                                                              \
+    ptrdiff_t tail = cvector_simd__find_##name##_scalar_(elems + i, size - i, value);              \
+    return (tail < 0) ? -1 : (ptrdiff_t)i + tail;                                                  \
+  }                                                                                                \
+                                                                                                   \
+  CVECTOR_SIMD__OP_(isa)                                                                           \
+  size_t cvector_simd__count_##name##_##isa##_(const T *elems, size_t size, T value) {             \
+    V needle = cvector_simd__set1_##name##_##isa##_(value);                                        \
+    size_t count = 0;                                                                              \
+    size_t i = 0;                                                                                  \
+    while (i + (W) <= size) {                                                                      \
+      size_t vectors = (size - i) / (W);                                                           \
+      vectors = (vectors < CVECTOR_SIMD__HITS_FLUSH_) ? vectors : CVECTOR_SIMD__HITS_FLUSH_;       \
+      CVECTOR_SIMD__HITS_##isa hits = CVECTOR_SIMD__HITS_ZERO_##isa();                             \
+      for (size_t end = i + vectors * (W); i < end; i += (W)) {                                    \
+        hits = cvector_simd__hits_##name##_##isa##_(                                               \
+            hits, cvector_simd__load_##name##_##isa##_(elems + i), needle);                        \
+      }                                                                                            \
+      count += cvector_simd__hits_total_##name##_##isa##_(hits);                                   \
+    }                                                                                              \
+    return count + cvector_simd__count_##name##_scalar_(elems + i, size - i, value);               \
+  }                                                                                                \
+                                                                                                   \
+  CVECTOR_SIMD__OP_(isa)                                                                           \
+  void cvector_simd__minmax_##name##_##isa##_(const T *elems, size_t size, T *min, T *max) {       \
+    size_t i = 0;                                                                                  \
+    if (size >= (W)) {                                                                             \
+      V low = cvector_simd__load_##name##_##isa##_(elems);                                         \
+      V high = low;                                                                                \
+      for (i = (W); i + (W) <= size; i += (W)) {                                                   \
+        V v = cvector_simd__load_##name##_##isa##_(elems + i);                                     \
+        low = cvector_simd__min_##name##_##isa##_(low, v);                                         \
+        high = cvector_simd__max_##name##_##isa##_(high, v);                                       \
+      }                                                                                            \
+      T lanes[(W)];                                                                                \
+      cvector_simd__store_##name##_##isa##_(lanes, low);                                           \
+      cvector_simd__minmax_##name##_scalar_(lanes, (W), min, max);                                 \
+      cvector_simd__store_##name##_##isa##_(lanes, high);                                          \
+      cvector_simd__minmax_##name##_scalar_(lanes, (W), min, max);                                 \
+    }                                                                                              \
+    cvector_simd__minmax_##name##_scalar_(elems + i, size - i, min, max);                          \
+  }                                                                                                \
+                                                                                                   \
+  CVECTOR_SIMD__OP_(isa)                                                                           \
+  S cvector_simd__sum_##name##_##isa##_(const T *elems, size_t size) {                             \
+    A acc0 = cvector_simd__zero_##name##_##isa##_();                                               \
+    A acc1 = acc0;                                                                                 \
+    A acc2 = acc0;                                                                                 \
+    A acc3 = acc0;                                                                                 \
+    size_t i = 0;                                                                                  \
+    for (; i + 4 * (W) <= size; i += 4 * (W)) {                                                    \
+      acc0 = cvector_simd__acc_##name##_##isa##_(                                                  \
+          acc0, cvector_simd__load_##name##_##isa##_(elems + i));                                  \
+      acc1 = cvector_simd__acc_##name##_##isa##_(                                                  \
+          acc1, cvector_simd__load_##name##_##isa##_(elems + i + (W)));                            \
+      acc2 = cvector_simd__acc_##name##_##isa##_(                                                  \
+          acc2, cvector_simd__load_##name##_##isa##_(elems + i + 2 * (W)));                        \
+      acc3 = cvector_simd__acc_##name##_##isa##_(                                                  \
+          acc3, cvector_simd__load_##name##_##isa##_(elems + i + 3 * (W)));                        \
+    }                                                                                              \
+    S lanes[4 * (AW)];                                                                             \
+    cvector_simd__store_acc_##name##_##isa##_(lanes, acc0);                                        \
+    cvector_simd__store_acc_##name##_##isa##_(lanes + (AW), acc1);                                 \
+    cvector_simd__store_acc_##name##_##isa##_(lanes + 2 * (AW), acc2);                             \
+    cvector_simd__store_acc_##name##_##isa##_(lanes + 3 * (AW), acc3);                             \
+    S sum = 0;                                                                                     \
+    for (size_t lane = 0; lane < 4 * (AW); lane++) {                                               \
+      sum += lanes[lane];                                                                          \
+    }                                                                                              \
+    return sum + cvector_simd__sum_##name##_scalar_(elems + i, size - i);                          \
+  }
+
+CVECTOR_SIMD__KERNELS_(sse2, int, int, int64_t, __m128i, 4, __m128i, 2)
+CVECTOR_SIMD__KERNELS_(sse2, float, float, float, __m128, 4, __m128, 4)
+CVECTOR_SIMD__KERNELS_(sse2, double, double, double, __m128d, 2, __m128d, 2)
+
+CVECTOR_SIMD__KERNELS_(avx2, int, int, int64_t, __m256i, 8, __m256i, 4)
+CVECTOR_SIMD__KERNELS_(avx2, float, float, float, __m256, 8, __m256, 8)
+CVECTOR_SIMD__KERNELS_(avx2, double, double, double, __m256d, 4, __m256d, 4)
+
+CVECTOR_SIMD__KERNELS_(avx512, int, int, int64_t, __m512i, 16, __m512i, 8)
+CVECTOR_SIMD__KERNELS_(avx512, float, float, float, __m512, 16, __m512, 16)
+CVECTOR_SIMD__KERNELS_(avx512, double, double, double, __m512d, 8, __m512d, 8)
+
+/* PRIVATE: Calls flavour of 'kernel' matching the level in use. */
+#define CVECTOR_SIMD__DISPATCH_(kernel, ...)                                                       \
+  ((cvector_simd__level() == CVECTOR_SIMD__AVX512) ? kernel##avx512_(__VA_ARGS__)                  \
+   : (cvector_simd__level() == CVECTOR_SIMD__AVX2) ? kernel##avx2_(__VA_ARGS__)                    \
+   : (cvector_simd__level() == CVECTOR_SIMD__SSE2) ? kernel##sse2_(__VA_ARGS__)                    \
+                                                   : kernel##scalar_(__VA_ARGS__))
+
+#else
+
+/* PRIVATE: Only scalar kernels outside x86. */
+#define CVECTOR_SIMD__DISPATCH_(kernel, ...) (kernel##scalar_(__VA_ARGS__))
+
+#endif /* CVECTOR_SIMD__X86_ */
+
+/* PRIVATE: Kernels dispatched to the level in use, for element type 'T' (named 'name'). */
+#define CVECTOR_SIMD__DISPATCHERS_(name, T, S)                                                     \
+  static inline ptrdiff_t cvector_simd__find_##name##_(const T *elems, size_t size, T value) {     \
+    return CVECTOR_SIMD__DISPATCH_(cvector_simd__find_##name##_, elems, size, value);              \
+  }                                                                                                \
+                                                                                                   \
+  static inline size_t cvector_simd__count_##name##_(const T *elems, size_t size, T value) {       \
+    return CVECTOR_SIMD__DISPATCH_(cvector_simd__count_##name##_, elems, size, value);             \
+  }                                                                                                \
+                                                                                                   \
+  static inline int cvector_simd__minmax_##name##_(const T *elems, size_t size, T *min, T *max) {  \
+    if (size == 0) {                                                                               \
+      return -1;                                                                                   \
+    }                                                                                              \
+    *min = elems[0];                                                                               \
+    *max = elems[0];                                                                               \
+    CVECTOR_SIMD__DISPATCH_(cvector_simd__minmax_##name##_, elems, size, min, max);                \
+    return 0;                                                                                      \
+  }                                                                                                \
+                                                                                                   \
+  static inline S cvector_simd__sum_##name##_(const T *elems, size_t size) {                       \
+    return CVECTOR_SIMD__DISPATCH_(cvector_simd__sum_##name##_, elems, size);                      \
+  }
+
+CVECTOR_SIMD__DISPATCHERS_(int, int, int64_t)
+CVECTOR_SIMD__DISPATCHERS_(float, float, float)
+CVECTOR_SIMD__DISPATCHERS_(double, double, double)
+
+/* PRIVATE: Selects kernel 'op' for element type of vector. */
+#define cvector_simd__select_(op, vec)                                                             \
+  _Generic((cvector__elem_(vec)),                                                                  \
+      int *: cvector_simd__##op##_int_,                                                            \
+      float *: cvector_simd__##op##_float_,                                                        \
+      double *: cvector_simd__##op##_double_)
+
+/* PUBLIC: Returns index of first element equal to 'value', or -1 if there is none. */
+#define cvector__find(vec, value)                                                                  \
+  (cvector_simd__select_(find, vec)((cvector__elem_(vec)), cvector__size(vec), (value)))
+
+/* PUBLIC: Returns number of elements equal to 'value'. */
+#define cvector__count(vec, value)                                                                 \
+  (cvector_simd__select_(count, vec)((cvector__elem_(vec)), cvector__size(vec), (value)))
+
+/* PUBLIC: Stores smallest and largest element in '*min' and '*max'.
+ * Returns -1 (error) if vector is empty.
+ */
+#define cvector__minmax(vec, min, max)                                                             \
+  (cvector_simd__select_(minmax, vec)((cvector__elem_(vec)), cvector__size(vec), (min), (max)))
+
+/* PUBLIC: Returns sum of elements ('int64_t' for int vectors). */
+#define cvector__sum(vec)                                                                          \
+  (cvector_simd__select_(sum, vec)((cvector__elem_(vec)), cvector__size(vec)))
+
+#endif /* cvector_simd_h */
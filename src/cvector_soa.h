@@ -0,0 +1,311 @@
+/*
+ * Structure of arrays vectors for cvector.
+ *
+ * 'CVector(record_t)' stores whole records next to each other, so a loop reading one field drags
+ * every other field through the cache too. 'CVector_soa(record_t, FIELDS)' stores one contiguous
+ * column per field instead, and a loop reading one field only touches that column.
+ *
+ * Fields are listed once in an X-macro, which generates both the record struct and the columns:
+ *
+ * #define POINT_FIELDS(X) X(double, x) X(double, y) X(int, id)
+ *
+ * typedef struct {
+ *   POINT_FIELDS(CVECTOR_SOA__FIELD)
+ * } point_t;
+ *
+ * CVector_soa(point_t, POINT_FIELDS) cvector_soa_point_t;
+ *
+ * cvector_soa_point_t points;
+ * cvector__soa_init(&points, POINT_FIELDS);
+ *
+ * cvector__soa_add(&points, ((point_t){.x = 1.0, .y = 2.0, .id = 7}));
+ * cvector__soa_add_n(&points, records, count);   // bulk append of point_t array
+ *
+ * double *xs = cvector__soa_column(&points, x);
+ * for (size_t i = 0; i < cvector__size(&points); i++) {
+ *   sum += xs[i];                                 // or cvector__soa_index(&points, x, i)
+ * }
+ *
+ * cvector__soa_free(&points);
+ *
+ * All columns share one size and one cap and live in a single block, each column starting on its
+ * own cache line. A resize moves every column in one go.
+ */
+
+#ifndef cvector_soa_h
+#define cvector_soa_h
+
+#include "cvector.h"
+
+#include <stddef.h>
+
+/* Alignment of every column. */
+#ifndef CVECTOR_SOA__ALIGN
+#define CVECTOR_SOA__ALIGN 64
+#endif
+
+/* PUBLIC: Field list callback declaring record member 'name' of type 'T'. */
+#define CVECTOR_SOA__FIELD(T, name) T name;
+
+/* PRIVATE: Field list callbacks. */
+#define CVECTOR_SOA__COLUMN_(T, name) T *name;
+#define CVECTOR_SOA__ONE_(T, name) +1
+
+/* PRIVATE: Number of fields in field list. */
+#define CVECTOR_SOA__COUNT_(fields) (0 fields(CVECTOR_SOA__ONE_))
+
+/*
+ * Macro to create structure of arrays vector type holding records of type 'cvector__record_type_'
+ * whose fields are listed by X-macro 'cvector__fields_'. Column of field 'name' is member 'name'.
+ */
+#define CVector_soa(cvector__record_type_, cvector__fields_)                                       \
+  typedef struct {                                                                                 \
+    /* Columns, by field name or by position */                                                    \
+    union {                                                                                        \
+      struct {                                                                                     \
+        cvector__fields_(CVECTOR_SOA__COLUMN_)                                                     \
+      };                                                                                           \
+      void *cvector_soa__columns_m[CVECTOR_SOA__COUNT_(cvector__fields_)];                         \
+    };                                                                                             \
+    /* sizeof of column elements */                                                                \
+    size_t cvector_soa__elem_size_m[CVECTOR_SOA__COUNT_(cvector__fields_)];                        \
+    /* offsetof of fields in record */                                                             \
+    size_t cvector_soa__offset_m[CVECTOR_SOA__COUNT_(cvector__fields_)];                           \
+    size_t cvector__size_m;                                                                        \
+    size_t cvector__cap_m;                                                                         \
+    unsigned int cvector__flags_m;                                                                 \
+    /* Record type, only used for its type */                                                      \
+    cvector__record_type_ cvector_soa__record_m[0];                                                \
+  }
+
+/* PRIVATE: Number of columns. */
+#define cvector_soa__count_(vec)                                                                   \
+  (sizeof((vec)->cvector_soa__columns_m) / sizeof((vec)->cvector_soa__columns_m[0]))
+
+/* PRIVATE: Record type of vector. */
+#define cvector_soa__record_type_(vec) __typeof__((vec)->cvector_soa__record_m[0])
+
+/* PRIVATE: Field list callback recording size and offset of a field, see 'cvector__soa_init'. */
+#define CVECTOR_SOA__INIT_(T, name)                                                                \
+  _Static_assert(sizeof(T) == sizeof(((cvector_soa__record_type_(cvector__soa_m) *)0)->name),      \
+                 "field list doesn't match record");                                               \
+  cvector__soa_m->cvector_soa__elem_size_m[cvector__column_m] = sizeof(T);                         \
+  cvector__soa_m->cvector_soa__offset_m[cvector__column_m++] =                                     \
+      offsetof(cvector_soa__record_type_(cvector__soa_m), name);
+
+/* PRIVATE: Copies 'size' bytes, with fixed size copies for common field sizes. */
+static inline void cvector_soa__copy_(char *dst, const char *src, size_t size) {
+  switch (size) {
+  case 1:
+    *dst = *src;
+    break;
+  case 4:
+    memcpy(dst, src, 4);
+    break;
+  case 8:
+    memcpy(dst, src, 8);
+    break;
+  default:
+    memcpy(dst, src, size);
+    break;
+  }
+}
+
+/* PRIVATE: Offset of column 'column' in block of 'cap' rows. */
+static inline size_t cvector_soa__column_offset_(const size_t *elem_sizes, size_t column,
+                                                 size_t cap) {
+  size_t offset = 0;
+  for (size_t k = 0; k < column; k++) {
+    offset += elem_sizes[k] * cap;
+    offset = (offset + CVECTOR_SOA__ALIGN - 1) & ~((size_t)CVECTOR_SOA__ALIGN - 1);
+  }
+  return offset;
+}
+
+/* PRIVATE: Moves 'size' rows of 'count' columns into a fresh block of 'new_cap' rows.
+ * Returns false (columns untouched) if the block can't be allocated. */
+static inline bool cvector_soa__resize_(void **columns, const size_t *elem_sizes, size_t count,
+                                        size_t size, size_t new_cap) {
+  char *block = NULL;
+  if (new_cap > 0) {
+    // Every column is rounded up to the alignment, so the total is a multiple of it.
+    block = aligned_alloc(CVECTOR_SOA__ALIGN,
+                          cvector_soa__column_offset_(elem_sizes, count, new_cap));
+    if (block == NULL) {
+      return false;
+    }
+  }
+
+  void *old_block = columns[0];
+  for (size_t k = 0; k < count; k++) {
+    char *column = (block != NULL) ? block + cvector_soa__column_offset_(elem_sizes, k, new_cap)
+                                   : NULL;
+    if ((column != NULL) && (size > 0)) {
+      memcpy(column, columns[k], size * elem_sizes[k]);
+    }
+    columns[k] = column;
+  }
+  free(old_block);
+  return true;
+}
+
+/* PRIVATE: Scatters fields of 'n' records of 'record_size' bytes into rows starting at 'at'.
+ * Column by column, so that each column is written sequentially. */
+static inline void cvector_soa__scatter_(void **columns, const size_t *elem_sizes,
+                                         const size_t *offsets, size_t count, size_t at,
+                                         const void *records, size_t n, size_t record_size) {
+  for (size_t k = 0; k < count; k++) {
+    size_t elem_size = elem_sizes[k];
+    char *dst = ((char *)columns[k]) + at * elem_size;
+    const char *src = ((const char *)records) + offsets[k];
+    for (size_t r = 0; r < n; r++, dst += elem_size, src += record_size) {
+      cvector_soa__copy_(dst, src, elem_size);
+    }
+  }
+}
+
+/* PRIVATE: Gathers fields of row 'at' into 'record'. */
+static inline void cvector_soa__gather_(void *const *columns, const size_t *elem_sizes,
+                                        const size_t *offsets, size_t count, size_t at,
+                                        void *record) {
+  for (size_t k = 0; k < count; k++) {
+    cvector_soa__copy_(((char *)record) + offsets[k],
+                       ((const char *)columns[k]) + at * elem_sizes[k], elem_sizes[k]);
+  }
+}
+
+/* PRIVATE: Resizes every column to 'cap' rows. */
+#define cvector_soa__resize_columns_(vec, cap)                                                     \
+  do {                                                                                             \
+    size_t cvector__new_cap_m = (cap);                                                             \
+    if (cvector_soa__resize_((vec)->cvector_soa__columns_m, (vec)->cvector_soa__elem_size_m,       \
+                             cvector_soa__count_(vec), cvector__size(vec),                         \
+                             cvector__new_cap_m)) {                                                \
+      cvector__setcap_((vec), cvector__new_cap_m);                                                 \
+    }                                                                                              \
+  } while (0)
+
+/* PRIVATE: Grows columns with vector's growth policy to fit at least 'min_cap' rows. */
+#define cvector_soa__grow_(vec, min_cap)                                                           \
+  do {                                                                                             \
+    size_t cvector__min_cap_m = (min_cap);                                                         \
+    if (cvector__min_cap_m > cvector__cap_(vec)) {                                                 \
+      cvector_soa__resize_columns_(                                                                \
+          (vec), cvector__grow_cap_((cvector__flags_(vec)),                                        \
+                                    sizeof(cvector_soa__record_type_(vec)),                        \
+                                    (cvector__cap_(vec)), cvector__min_cap_m));                    \
+    }                                                                                              \
+  } while (0)
+
+/* PUBLIC: Initializes vector, 'fields' is the X-macro the type was created with. */
+#define cvector__soa_init(vec, fields)                                                             \
+  do {                                                                                             \
+    __typeof__(vec) cvector__soa_m = (vec);                                                        \
+    size_t cvector__column_m = 0;                                                                  \
+    memset(cvector__soa_m, 0, sizeof(*cvector__soa_m));                                            \
+    fields(CVECTOR_SOA__INIT_)                                                                     \
+    cvector__set_flags_(cvector__soa_m, (CVECTOR__DEFAULT_GROWTH << CVECTOR__GROWTH_SHIFT_));      \
+  } while (0)
+
+/* PUBLIC: Returns column of field 'name' (pointer to its first element). */
+#define cvector__soa_column(vec, name) ((vec)->name)
+
+/* PUBLIC: Returns field 'name' of row 'index'. Can be assigned to. */
+#define cvector__soa_index(vec, name, index) ((vec)->name[(index)])
+
+/* PUBLIC: Returns row 'index' gathered into a record. */
+#define cvector__soa_get(vec, index)                                                               \
+  ({                                                                                               \
+    cvector_soa__record_type_(vec) cvector__record_m;                                              \
+    cvector_soa__gather_((vec)->cvector_soa__columns_m, (vec)->cvector_soa__elem_size_m,           \
+                         (vec)->cvector_soa__offset_m, cvector_soa__count_(vec), (index),          \
+                         &cvector__record_m);                                                      \
+    cvector__record_m;                                                                             \
+  })
+
+/* PUBLIC: Makes room for at least 'cap' rows. Allocates exactly 'cap' rows. */
+#define cvector__soa_reserve(vec, cap)                                                             \
+  do {                                                                                             \
+    size_t cvector__min_cap_m = (cap);                                                             \
+    if (cvector__min_cap_m > cvector__cap_(vec)) {                                                 \
+      cvector_soa__resize_columns_((vec), cvector__min_cap_m);                                     \
+    }                                                                                              \
+  } while (0)
+
+/* PUBLIC: Appends 'n' records from array 'records', scattering their fields into the columns
+ * after at most one resize. Nothing is added if memory can't be allocated.
+ */
+#define cvector__soa_add_n(vec, records, n)                                                        \
+  do {                                                                                             \
+    size_t cvector__count_m = (n);                                                                 \
+    const cvector_soa__record_type_(vec) *cvector__records_m = (records);                          \
+    cvector_soa__grow_((vec), (cvector__size(vec) + cvector__count_m));                            \
+    if (cvector__count_m <= cvector__cap_(vec) - cvector__size(vec)) {                             \
+      cvector_soa__scatter_((vec)->cvector_soa__columns_m, (vec)->cvector_soa__elem_size_m,        \
+                            (vec)->cvector_soa__offset_m, cvector_soa__count_(vec),                \
+                            cvector__size(vec), cvector__records_m, cvector__count_m,              \
+                            sizeof(*cvector__records_m));                                          \
+      cvector__setsize_((vec), (cvector__size(vec) + cvector__count_m));                           \
+    }                                                                                              \
+  } while (0)
+
+/* PUBLIC: Appends one record. */
+#define cvector__soa_add(vec, record)                                                              \
+  do {                                                                                             \
+    cvector_soa__record_type_(vec) cvector__record_m = (record);                                   \
+    cvector__soa_add_n((vec), &cvector__record_m, 1);                                              \
+  } while (0)
+
+/* PUBLIC: Removes every row, keeping the columns' capacity. */
+#define cvector__soa_clear(vec) (cvector__setsize_((vec), 0))
+
+/* PUBLIC: Frees the columns. */
+#define cvector__soa_free(vec)                                                                     \
+  do {                                                                                             \
+    cvector_soa__resize_((vec)->cvector_soa__columns_m, (vec)->cvector_soa__elem_size_m,           \
+                         cvector_soa__count_(vec), 0, 0);                                          \
+    cvector__setsize_((vec), 0);                                                                   \
+    cvector__setcap_((vec), 0);                                                                    \
+  } while (0)
+
+/*
+ * Macro to create row iterator type over structure of arrays vector type 'cvector__type_'.
+ *
+ *   CVector_soa_iterator(cvector_soa_point_t) cvector_soa_point_iterator_t;
+ *
+ *   cvector_soa_point_iterator_t iterator;
+ *   cvector_soa_iterator__init(&iterator, &points);
+ *
+ *   while (!cvector_soa_iterator__done(&iterator)) {
+ *     cvector_soa_iterator__next(&iterator);
+ *     double x = cvector_soa_iterator__field(&iterator, x);
+ *   }
+ */
+#define CVector_soa_iterator(cvector__type_)                                                       \
+  typedef struct {                                                                                 \
+    cvector__type_ *cvector_soa_iterator__vec_m;                                                   \
+    /* Index of next row */                                                                        \
+    size_t cvector_soa_iterator__next_index_m;                                                     \
+  }
+
+/* PUBLIC: Initializes iterator before first row of vector. */
+#define cvector_soa_iterator__init(iterator, vec)                                                  \
+  do {                                                                                             \
+    (iterator)->cvector_soa_iterator__vec_m = (vec);                                               \
+    (iterator)->cvector_soa_iterator__next_index_m = 0;                                            \
+  } while (0)
+
+/* PUBLIC: Returns whether every row was visited. */
+#define cvector_soa_iterator__done(iterator)                                                       \
+  ((iterator)->cvector_soa_iterator__next_index_m >=                                               \
+   cvector__size((iterator)->cvector_soa_iterator__vec_m))
+
+/* PUBLIC: Moves to next row and returns its index. */
+#define cvector_soa_iterator__next(iterator) ((iterator)->cvector_soa_iterator__next_index_m++)
+
+/* PUBLIC: Returns field 'name' of current row (the one last returned by next). */
+#define cvector_soa_iterator__field(iterator, name)                                                \
+  (cvector__soa_index((iterator)->cvector_soa_iterator__vec_m, name,                               \
+                      ((iterator)->cvector_soa_iterator__next_index_m - 1)))
+
+#endif /* cvector_soa_h */
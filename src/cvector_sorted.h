@@ -0,0 +1,474 @@
+/*
+ * Sorted vectors for cvector: sorting, binary search, sorted bulk insert and Eytzinger lookups.
+ *
+ * A sorted 'CVector(T)' is a compact lookup table. This header sorts it, searches it in
+ * O(log n), and merges batches into it while keeping it sorted:
+ *
+ *   - 'cvector__sort' is an introsort (quicksort, heapsort once recursion gets too deep, insertion
+ *     sort for small ranges), in place.
+ *   - 'cvector__radix_sort' sorts vectors of integers in ascending order with an LSD radix sort,
+ *     one pass per key byte, skipping bytes all keys share. Signedness comes from the element type.
+ *   - 'cvector__lower_bound' and 'cvector__binary_search' use a branch-free binary search.
+ *   - 'cvector__insert_sorted' sorts a batch and merges it into the vector in one backward pass.
+ *   - 'CVector_eytzinger(T)' is a read only copy of a sorted vector in Eytzinger (BFS) order: the
+ *     elements visited by a search sit next to each other near the top, so lookups are branch-free
+ *     and touch few cache lines even on tables far bigger than the cache.
+ *
+ * Comparators are qsort-like: 'int compare(const void *a, const void *b)'.
+ *
+ * For example:
+ *
+ * cvector__sort(&vector_int, compare_int);
+ *
+ * ptrdiff_t at = cvector__binary_search(&vector_int, 42, compare_int);  // -1 if missing
+ *
+ * CVector_eytzinger(int) cvector_eytzinger_int_t;
+ *
+ * cvector_eytzinger_int_t view;
+ * cvector__eytzinger_build(&view, &vector_int);
+ * const int *found = cvector__eytzinger_find(&view, 42, compare_int);   // NULL if missing
+ * cvector__eytzinger_free(&view);
+ */
+
+#ifndef cvector_sorted_h
+#define cvector_sorted_h
+
+#include "cvector.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Ranges of at most this many elements are finished with insertion sort. */
+#ifndef CVECTOR_SORTED__INSERTION_SIZE
+#define CVECTOR_SORTED__INSERTION_SIZE 16
+#endif
+
+/* PRIVATE: qsort-like comparator. */
+typedef int (*cvector_sorted_compare_t)(const void *, const void *);
+
+/* PRIVATE: Address of element 'index'. */
+#define cvector_sorted__at_(elems, index, elem_size) (((char *)(elems)) + (index) * (elem_size))
+
+/* PRIVATE: Swaps two elements of 'size' bytes. */
+static inline void cvector_sorted__swap_(char *a, char *b, size_t size) {
+  char tmp[64];
+  while (size > 0) {
+    size_t chunk = (size < sizeof(tmp)) ? size : sizeof(tmp);
+    memcpy(tmp, a, chunk);
+    memcpy(a, b, chunk);
+    memcpy(b, tmp, chunk);
+    a += chunk;
+    b += chunk;
+    size -= chunk;
+  }
+}
+
+/* PRIVATE: Insertion sort of 'size' elements. */
+static inline void cvector_sorted__insertion_sort_(char *elems, size_t size, size_t elem_size,
+                                                   cvector_sorted_compare_t compare) {
+  for (size_t i = 1; i < size; i++) {
+    for (size_t j = i; (j > 0) && (compare(cvector_sorted__at_(elems, j - 1, elem_size),
+                                           cvector_sorted__at_(elems, j, elem_size)) > 0);
+         j--) {
+      cvector_sorted__swap_(cvector_sorted__at_(elems, j - 1, elem_size),
+                            cvector_sorted__at_(elems, j, elem_size), elem_size);
+    }
+  }
+}
+
+/* PRIVATE: Moves element 'root' of heap of 'size' elements down to its place. */
+static inline void cvector_sorted__sift_down_(char *elems, size_t root, size_t size,
+                                              size_t elem_size, cvector_sorted_compare_t compare) {
+  for (size_t child = 2 * root + 1; child < size; child = 2 * root + 1) {
+    if ((child + 1 < size) && (compare(cvector_sorted__at_(elems, child, elem_size),
+                                       cvector_sorted__at_(elems, child + 1, elem_size)) < 0)) {
+      child++;
+    }
+    if (compare(cvector_sorted__at_(elems, root, elem_size),
+                cvector_sorted__at_(elems, child, elem_size)) >= 0) {
+      return;
+    }
+    cvector_sorted__swap_(cvector_sorted__at_(elems, root, elem_size),
+                          cvector_sorted__at_(elems, child, elem_size), elem_size);
+    root = child;
+  }
+}
+
+/* PRIVATE: Heapsort, bounds introsort to O(n log n) on adversarial input. */
+static inline void cvector_sorted__heap_sort_(char *elems, size_t size, size_t elem_size,
+                                              cvector_sorted_compare_t compare) {
+  for (size_t root = size / 2; root-- > 0;) {
+    cvector_sorted__sift_down_(elems, root, size, elem_size, compare);
+  }
+  for (size_t end = size; end-- > 1;) {
+    cvector_sorted__swap_(elems, cvector_sorted__at_(elems, end, elem_size), elem_size);
+    cvector_sorted__sift_down_(elems, 0, end, elem_size, compare);
+  }
+}
+
+/* PRIVATE: Introsort of 'size' elements, falling back to heapsort after 'depth' partitions. */
+static inline void cvector_sorted__intro_sort_(char *elems, size_t size, size_t elem_size,
+                                               cvector_sorted_compare_t compare, size_t depth) {
+  while (size > CVECTOR_SORTED__INSERTION_SIZE) {
+    if (depth-- == 0) {
+      cvector_sorted__heap_sort_(elems, size, elem_size, compare);
+      return;
+    }
+
+    // Median of first, middle and last element becomes pivot, parked at index 0.
+    char *first = elems;
+    char *middle = cvector_sorted__at_(elems, size / 2, elem_size);
+    char *last = cvector_sorted__at_(elems, size - 1, elem_size);
+    if (compare(middle, first) < 0) {
+      cvector_sorted__swap_(middle, first, elem_size);
+    }
+    if (compare(last, middle) < 0) {
+      cvector_sorted__swap_(last, middle, elem_size);
+      if (compare(middle, first) < 0) {
+        cvector_sorted__swap_(middle, first, elem_size);
+      }
+    }
+    cvector_sorted__swap_(first, middle, elem_size);
+
+    size_t i = 0;
+    size_t j = size;
+    for (;;) {
+      do {
+        i++;
+      } while ((i < size) && (compare(cvector_sorted__at_(elems, i, elem_size), elems) < 0));
+      do {
+        j--;
+      } while (compare(elems, cvector_sorted__at_(elems, j, elem_size)) < 0);
+      if (i >= j) {
+        break;
+      }
+      cvector_sorted__swap_(cvector_sorted__at_(elems, i, elem_size),
+                            cvector_sorted__at_(elems, j, elem_size), elem_size);
+    }
+    cvector_sorted__swap_(elems, cvector_sorted__at_(elems, j, elem_size), elem_size);
+
+    // Recurse into smaller side, loop on the bigger one: stack depth stays O(log n).
+    char *right = cvector_sorted__at_(elems, j + 1, elem_size);
+    size_t right_size = size - j - 1;
+    if (j < right_size) {
+      cvector_sorted__intro_sort_(elems, j, elem_size, compare, depth);
+      elems = right;
+      size = right_size;
+    } else {
+      cvector_sorted__intro_sort_(right, right_size, elem_size, compare, depth);
+      size = j;
+    }
+  }
+  cvector_sorted__insertion_sort_(elems, size, elem_size, compare);
+}
+
+/* PRIVATE: Sorts 'size' elements. */
+static inline void cvector_sorted__sort_(void *elems, size_t size, size_t elem_size,
+                                         cvector_sorted_compare_t compare) {
+  size_t depth = 0;
+  for (size_t left = size; left > 1; left >>= 1) {
+    depth += 2;
+  }
+  cvector_sorted__intro_sort_(elems, size, elem_size, compare, depth);
+}
+
+/* PRIVATE: Integer at 'elem' of 'width' bytes (1, 2, 4 or 8) as unsigned key, sign flipped for
+ * signed types so that unsigned order matches signed order. */
+static inline uint64_t cvector_sorted__radix_key_(const char *elem, size_t width, bool is_signed) {
+  uint64_t key;
+  switch (width) {
+  case 1: {
+    uint8_t value;
+    memcpy(&value, elem, 1);
+    key = value;
+    break;
+  }
+  case 2: {
+    uint16_t value;
+    memcpy(&value, elem, 2);
+    key = value;
+    break;
+  }
+  case 4: {
+    uint32_t value;
+    memcpy(&value, elem, 4);
+    key = value;
+    break;
+  }
+  default:
+    memcpy(&key, elem, 8);
+    break;
+  }
+  return is_signed ? (key ^ ((uint64_t)1 << (8 * width - 1))) : key;
+}
+
+/* PRIVATE: LSD radix sort of 'size' integers of 'width' bytes, one pass per byte.
+ * Histograms of all bytes are counted in a single read, bytes shared by every key are skipped. */
+static inline void cvector_sorted__radix_sort_(void *elems, size_t size, size_t width,
+                                               bool is_signed) {
+  if (size < 2) {
+    return;
+  }
+
+  char *scratch = malloc(size * width);
+  if (scratch == NULL) {
+    return;
+  }
+
+  size_t(*counts)[256] = calloc(width, sizeof(*counts));
+  if (counts == NULL) {
+    free(scratch);
+    return;
+  }
+
+  for (size_t i = 0; i < size; i++) {
+    uint64_t key = cvector_sorted__radix_key_(cvector_sorted__at_(elems, i, width), width,
+                                              is_signed);
+    for (size_t byte = 0; byte < width; byte++) {
+      counts[byte][(key >> (8 * byte)) & 0xff]++;
+    }
+  }
+
+  char *src = elems;
+  char *dst = scratch;
+  for (size_t byte = 0; byte < width; byte++) {
+    size_t *count = counts[byte];
+    if (count[cvector_sorted__radix_key_(src, width, is_signed) >> (8 * byte) & 0xff] == size) {
+      continue;
+    }
+
+    size_t offset = 0;
+    for (size_t bucket = 0; bucket < 256; bucket++) {
+      size_t bucket_size = count[bucket];
+      count[bucket] = offset;
+      offset += bucket_size;
+    }
+
+    for (size_t i = 0; i < size; i++) {
+      char *elem = cvector_sorted__at_(src, i, width);
+      uint64_t key = cvector_sorted__radix_key_(elem, width, is_signed);
+      memcpy(cvector_sorted__at_(dst, count[(key >> (8 * byte)) & 0xff]++, width), elem, width);
+    }
+
+    char *sorted = dst;
+    dst = src;
+    src = sorted;
+  }
+
+  if (src != elems) {
+    memcpy(elems, src, size * width);
+  }
+  free(counts);
+  free(scratch);
+}
+
+/* PRIVATE: Index of first element not less than 'key', 'size' if there is none. Branch-free: the
+ * search window halves every step and only its start moves (a conditional move). */
+static inline size_t cvector_sorted__lower_bound_(const void *elems, size_t size, size_t elem_size,
+                                                  const void *key,
+                                                  cvector_sorted_compare_t compare) {
+  if (size == 0) {
+    return 0;
+  }
+
+  const char *base = elems;
+  while (size > 1) {
+    size_t half = size / 2;
+    const char *probe = base + half * elem_size;
+    base = (compare(probe, key) < 0) ? probe : base;
+    size -= half;
+  }
+  return (size_t)(base - (const char *)elems) / elem_size + (compare(base, key) < 0);
+}
+
+/* PRIVATE: Merges sorted 'batch' of 'count' elements into sorted 'elems' of 'size' elements
+ * (with room for 'size' + 'count'), back to front so that nothing is moved twice.
+ * Existing elements stay in front of equal batch elements. */
+static inline void cvector_sorted__merge_back_(char *elems, size_t size, const char *batch,
+                                               size_t count, size_t elem_size,
+                                               cvector_sorted_compare_t compare) {
+  size_t out = size + count;
+  while (count > 0) {
+    char *dst = cvector_sorted__at_(elems, --out, elem_size);
+    if ((size > 0) && (compare(cvector_sorted__at_(elems, size - 1, elem_size),
+                               cvector_sorted__at_(batch, count - 1, elem_size)) > 0)) {
+      memcpy(dst, cvector_sorted__at_(elems, --size, elem_size), elem_size);
+    } else {
+      memcpy(dst, cvector_sorted__at_(batch, --count, elem_size), elem_size);
+    }
+  }
+}
+
+/* PUBLIC: Sorts vector in place with introsort. Not stable. */
+#define cvector__sort(vec, compare)                                                                \
+  ((cvector__unshare(vec) == 0)                                                                    \
+       ? cvector_sorted__sort_((cvector__elem_(vec)), cvector__size(vec),                          \
+                               cvector__elem_size_(vec), (compare))                                \
+       : (void)0)
+
+/* PUBLIC: Sorts vector of integers in ascending order with radix sort.
+ * Fails to compile for non integer element types and integers of more than 8 bytes. Uses a scratch
+ * buffer as big as the vector, the vector is left as is if it can't be allocated.
+ */
+#define cvector__radix_sort(vec)                                                                   \
+  do {                                                                                             \
+    _Static_assert((__typeof__(*(cvector__elem_(vec))))0.5 == 0,                                   \
+                   "cvector__radix_sort needs integer elements");                                  \
+    _Static_assert((sizeof(*(cvector__elem_(vec))) == 1) ||                                        \
+                       (sizeof(*(cvector__elem_(vec))) == 2) ||                                    \
+                       (sizeof(*(cvector__elem_(vec))) == 4) ||                                    \
+                       (sizeof(*(cvector__elem_(vec))) == 8),                                      \
+                   "cvector__radix_sort needs elements of 1, 2, 4 or 8 bytes");                    \
+    if (cvector__unshare(vec) == 0) {                                                              \
+      cvector_sorted__radix_sort_((cvector__elem_(vec)), cvector__size(vec),                       \
+                                  cvector__elem_size_(vec),                                        \
+                                  ((__typeof__(*(cvector__elem_(vec))))-1 < 0));                   \
+    }                                                                                              \
+  } while (0)
+
+/* PUBLIC: Returns index of first element not less than 'key' in sorted vector, size if none. */
+#define cvector__lower_bound(vec, key, compare)                                                    \
+  ({                                                                                               \
+    __typeof__(*(cvector__elem_(vec))) cvector__key_m = (key);                                     \
+    cvector_sorted__lower_bound_((cvector__elem_(vec)), cvector__size(vec),                        \
+                                 cvector__elem_size_(vec), &cvector__key_m, (compare));            \
+  })
+
+/* PUBLIC: Returns index of an element equal to 'key' in sorted vector, or -1 if there is none. */
+#define cvector__binary_search(vec, key, compare)                                                  \
+  ({                                                                                               \
+    __typeof__(*(cvector__elem_(vec))) cvector__key_m = (key);                                     \
+    size_t cvector__at_m =                                                                         \
+        cvector_sorted__lower_bound_((cvector__elem_(vec)), cvector__size(vec),                    \
+                                     cvector__elem_size_(vec), &cvector__key_m, (compare));        \
+    ((cvector__at_m < cvector__size(vec)) &&                                                       \
+     ((compare)(&cvector__index((vec), cvector__at_m), &cvector__key_m) == 0))                     \
+        ? (ptrdiff_t)cvector__at_m                                                                 \
+        : (ptrdiff_t)-1;                                                                           \
+  })
+
+/* PUBLIC: Inserts 'n' elements copied from array 'values' (in any order) into sorted vector,
+ * keeping it sorted. The batch is sorted on its own, then merged in a single backward pass after
+ * at most one resize. Cost is O(n log n + size) instead of one memmove per element.
+ * Returns -1 (error) if the scratch copy of the batch or the grown buffer can't be allocated, the
+ * vector is then unchanged.
+ */
+#define cvector__insert_sorted(vec, values, n, compare)                                            \
+  ({                                                                                               \
+    size_t cvector__count_m = (n);                                                                 \
+    size_t cvector__bytes_m = cvector__count_m * cvector__elem_size_(vec);                         \
+    int cvector__result_m = 0;                                                                     \
+    if (cvector__count_m > 0) {                                                                    \
+      cvector__result_m = -1;                                                                      \
+      cvector__grow_((vec), (cvector__size(vec) + cvector__count_m));                              \
+      char *cvector__batch_m = (cvector__count_m <= cvector__cap_(vec) - cvector__size(vec))       \
+                                   ? malloc(cvector__bytes_m)                                      \
+                                   : NULL;                                                         \
+      if (cvector__batch_m != NULL) {                                                              \
+        memcpy(cvector__batch_m, (values), cvector__bytes_m);                                      \
+        cvector_sorted__sort_(cvector__batch_m, cvector__count_m, cvector__elem_size_(vec),        \
+                              (compare));                                                          \
+        cvector_sorted__merge_back_((char *)(cvector__elem_(vec)), cvector__size(vec),             \
+                                    cvector__batch_m, cvector__count_m, cvector__elem_size_(vec),  \
+                                    (compare));                                                    \
+        cvector__setsize_((vec), (cvector__size(vec) + cvector__count_m));                         \
+        free(cvector__batch_m);                                                                    \
+        cvector__result_m = 0;                                                                     \
+      }                                                                                            \
+    }                                                                                              \
+    cvector__result_m;                                                                             \
+  })
+
+/*
+ * Macro to create Eytzinger view type of elements of type 'cvector__elem_type_'.
+ * Element 1 is the root of an implicit search tree, children of element k are 2k and 2k + 1.
+ */
+#define CVector_eytzinger(cvector__elem_type_)                                                     \
+  typedef struct {                                                                                 \
+    /* Elements in BFS order, from index 1 (index 0 is unused) */                                  \
+    cvector__elem_type_ *cvector_eytzinger__elem_m;                                                \
+    size_t cvector_eytzinger__size_m;                                                              \
+  }
+
+/* PRIVATE: Copies sorted 'elems' into 'tree' in BFS order by in-order walk of the tree.
+ * Returns index of next sorted element. */
+static inline size_t cvector_eytzinger__fill_(char *tree, const char *elems, size_t size,
+                                              size_t elem_size, size_t next, size_t node) {
+  if (node <= size) {
+    next = cvector_eytzinger__fill_(tree, elems, size, elem_size, next, 2 * node);
+    memcpy(cvector_sorted__at_(tree, node, elem_size), cvector_sorted__at_(elems, next, elem_size),
+           elem_size);
+    next = cvector_eytzinger__fill_(tree, elems, size, elem_size, next + 1, 2 * node + 1);
+  }
+  return next;
+}
+
+/* PRIVATE: Tree index of first element not less than 'key', 0 if there is none.
+ * The walk goes down to a leaf without branching on the comparison. Going right appends a 1 bit to
+ * the index, so the answer is the last node where the walk went left: strip the trailing 1 bits
+ * and the 0 bit before them. */
+static inline size_t cvector_eytzinger__lower_bound_(const void *tree, size_t size,
+                                                     size_t elem_size, const void *key,
+                                                     cvector_sorted_compare_t compare) {
+  size_t node = 1;
+  while (node <= size) {
+    // Four levels down, clamped to the last node so the address stays inside the tree.
+    size_t ahead = 16 * node;
+    ahead = (ahead <= size) ? ahead : size;
+    __builtin_prefetch(cvector_sorted__at_(tree, ahead, elem_size));
+    node = 2 * node + (compare(cvector_sorted__at_(tree, node, elem_size), key) < 0);
+  }
+  return node >> __builtin_ffsll((long long)~node);
+}
+
+/* PUBLIC: Returns number of elements in view. */
+#define cvector__eytzinger_size(view) ((view)->cvector_eytzinger__size_m)
+
+/* PUBLIC: Builds view from sorted vector of the same element type. The vector isn't needed after.
+ * Returns -1 (error) if the view can't be allocated.
+ */
+#define cvector__eytzinger_build(view, vec)                                                        \
+  ({                                                                                               \
+    size_t cvector__elem_size_m = cvector__elem_size_(vec);                                        \
+    (view)->cvector_eytzinger__size_m = cvector__size(vec);                                        \
+    (view)->cvector_eytzinger__elem_m = malloc((cvector__size(vec) + 1) * cvector__elem_size_m);   \
+    if ((view)->cvector_eytzinger__elem_m != NULL) {                                               \
+      cvector_eytzinger__fill_((char *)((view)->cvector_eytzinger__elem_m),                        \
+                               (const char *)(cvector__elem_(vec)), cvector__size(vec),            \
+                               cvector__elem_size_m, 0, 1);                                        \
+    }                                                                                              \
+    ((view)->cvector_eytzinger__elem_m != NULL) ? 0 : -1;                                          \
+  })
+
+/* PUBLIC: Returns pointer to first element not less than 'key', or NULL if there is none. */
+#define cvector__eytzinger_lower_bound(view, key, compare)                                         \
+  ({                                                                                               \
+    __typeof__(*((view)->cvector_eytzinger__elem_m)) cvector__key_m = (key);                       \
+    size_t cvector__node_m = cvector_eytzinger__lower_bound_(                                      \
+        (view)->cvector_eytzinger__elem_m, cvector__eytzinger_size(view),                          \
+        sizeof(cvector__key_m), &cvector__key_m, (compare));                                       \
+    (cvector__node_m != 0) ? (const __typeof__(cvector__key_m) *)(&(                               \
+                                 (view)->cvector_eytzinger__elem_m[cvector__node_m]))              \
+                           : NULL;                                                                 \
+  })
+
+/* PUBLIC: Returns pointer to an element equal to 'key', or NULL if there is none. */
+#define cvector__eytzinger_find(view, key, compare)                                                \
+  ({                                                                                               \
+    __typeof__(*((view)->cvector_eytzinger__elem_m)) cvector__needle_m = (key);                    \
+    const __typeof__(cvector__needle_m) *cvector__found_m =                                        \
+        cvector__eytzinger_lower_bound((view), cvector__needle_m, (compare));                      \
+    ((cvector__found_m != NULL) && ((compare)(cvector__found_m, &cvector__needle_m) == 0))         \
+        ? cvector__found_m                                                                         \
+        : NULL;                                                                                    \
+  })
+
+/* PUBLIC: Frees view. */
+#define cvector__eytzinger_free(view)                                                              \
+  do {                                                                                             \
+    free((view)->cvector_eytzinger__elem_m);                                                       \
+    (view)->cvector_eytzinger__elem_m = NULL;                                                      \
+    (view)->cvector_eytzinger__size_m = 0;                                                         \
+  } while (0)
+
+#endif /* cvector_sorted_h */
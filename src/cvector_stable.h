@@ -0,0 +1,203 @@
+/*
+ * Stable address vectors for cvector.
+ *
+ * Growing a 'CVector(T)' moves its buffer, so pointers from 'cvector__index_ref',
+ * 'cvector__last_ref' or 'cvector_iterator__next_ref' dangle after the next 'cvector__add'.
+ * 'CVector_stable(T)' stores elements in segments whose sizes double (see cvector_segment.h):
+ *
+ *   - Growing allocates the next segment and never copies existing elements, so references stay
+ *     valid for the life of the vector (until the element is popped or the vector freed).
+ *   - No append pays an O(n) copy, the worst one allocates a segment.
+ *   - Indexing finds the segment with a single count-leading-zeros.
+ *
+ * For example:
+ *
+ * CVector_stable(int) cvector_stable_int_t;
+ *
+ * cvector_stable_int_t vector;
+ * cvector__stable_init(&vector);
+ *
+ * cvector__stable_add(&vector, 1);
+ * int *first = cvector__stable_index_ref(&vector, 0);
+ * for (int i = 0; i < 1000000; i++) {
+ *   cvector__stable_add(&vector, i);               // 'first' stays valid
+ * }
+ *
+ * cvector__stable_free(&vector);
+ */
+
+#ifndef cvector_stable_h
+#define cvector_stable_h
+
+#include "cvector.h"
+#include "cvector_segment.h"
+
+/*
+ * Macro to create stable address vector type of elements of type 'cvector__elem_type_'.
+ * Cap counts elements of allocated segments, which are always the first ones of the table.
+ */
+#define CVector_stable(cvector__elem_type_)                                                        \
+  typedef struct {                                                                                 \
+    /* Segments, allocated in order and never moved */                                             \
+    cvector__elem_type_ *cvector_stable__segments_m[CVECTOR_SEGMENT__COUNT_];                      \
+    size_t cvector__size_m;                                                                        \
+    size_t cvector__cap_m;                                                                         \
+  }
+
+/* PRIVATE: Allocates next segment. Cap stays unchanged if it can't be allocated. */
+#define cvector_stable__grow_(vec)                                                                 \
+  do {                                                                                             \
+    size_t cvector__segment_m = cvector_segment__of_(cvector__cap_(vec));                          \
+    __typeof__((vec)->cvector_stable__segments_m[0]) cvector__elems_m =                            \
+        malloc(cvector_segment__size_(cvector__segment_m) *                                        \
+               sizeof(*((vec)->cvector_stable__segments_m[0])));                                   \
+    if (cvector__elems_m != NULL) {                                                                \
+      (vec)->cvector_stable__segments_m[cvector__segment_m] = cvector__elems_m;                    \
+      cvector__setcap_((vec), (cvector__cap_(vec) + cvector_segment__size_(cvector__segment_m)));  \
+    }                                                                                              \
+  } while (0)
+
+/* PUBLIC: Initializes empty vector, no allocation is made until the first add. */
+#define cvector__stable_init(vec)                                                                  \
+  do {                                                                                             \
+    memset((vec)->cvector_stable__segments_m, 0, sizeof((vec)->cvector_stable__segments_m));       \
+    cvector__setsize_((vec), 0);                                                                   \
+    cvector__setcap_((vec), 0);                                                                    \
+  } while (0)
+
+/* PUBLIC: Returns reference to element at given index. Stays valid while the element exists. */
+#define cvector__stable_index_ref(vec, index)                                                      \
+  ({                                                                                               \
+    size_t cvector__at_m = (index);                                                                \
+    size_t cvector__segment_m = cvector_segment__of_(cvector__at_m);                               \
+    (&((vec)->cvector_stable__segments_m[cvector__segment_m]                                       \
+                                        [cvector_segment__offset_(cvector__at_m,                   \
+                                                                  cvector__segment_m)]));          \
+  })
+
+/* PUBLIC: Returns element at given index. */
+#define cvector__stable_index(vec, index) (*cvector__stable_index_ref((vec), (index)))
+
+/* PUBLIC: Returns reference to last element. Vector must not be empty. */
+#define cvector__stable_last_ref(vec) (cvector__stable_index_ref((vec), (cvector__size(vec) - 1)))
+
+/* PUBLIC: Returns last element. Vector must not be empty. */
+#define cvector__stable_last(vec) (*cvector__stable_last_ref(vec))
+
+/* PUBLIC: Makes room for at least 'cap' elements by allocating segments up front. */
+#define cvector__stable_reserve(vec, cap)                                                          \
+  do {                                                                                             \
+    size_t cvector__min_cap_m = (cap);                                                             \
+    size_t cvector__old_cap_m = ~(size_t)0;                                                        \
+    while ((cvector__cap_(vec) < cvector__min_cap_m) &&                                            \
+           (cvector__cap_(vec) != cvector__old_cap_m)) {                                           \
+      cvector__old_cap_m = cvector__cap_(vec);                                                     \
+      cvector_stable__grow_(vec);                                                                  \
+    }                                                                                              \
+  } while (0)
+
+/* PUBLIC: Adds element at the back. Never moves existing elements.
+ * The element is dropped if the next segment can't be allocated, like 'cvector__add'. */
+#define cvector__stable_add(vec, val)                                                              \
+  do {                                                                                             \
+    if (cvector__size(vec) >= cvector__cap_(vec)) {                                                \
+      cvector_stable__grow_(vec);                                                                  \
+    }                                                                                              \
+    if (cvector__size(vec) < cvector__cap_(vec)) {                                                 \
+      cvector__stable_index((vec), cvector__size(vec)) = (val);                                    \
+      cvector__setsize_((vec), (cvector__size(vec) + 1));                                          \
+    }                                                                                              \
+  } while (0)
+
+/* PUBLIC: Removes and returns last element, keeping every segment. Vector must not be empty. */
+#define cvector__stable_pop(vec)                                                                   \
+  ({                                                                                               \
+    cvector__setsize_((vec), (cvector__size(vec) - 1));                                            \
+    (cvector__stable_index((vec), cvector__size(vec)));                                            \
+  })
+
+/* PUBLIC: Frees segments holding no element. References to remaining elements stay valid. */
+#define cvector__stable_shrink_to_fit(vec)                                                         \
+  do {                                                                                             \
+    size_t cvector__keep_m =                                                                       \
+        (cvector__size(vec) == 0) ? 0 : cvector_segment__of_(cvector__size(vec) - 1) + 1;          \
+    for (size_t cvector__segment_m = cvector__keep_m;                                              \
+         cvector__segment_m < CVECTOR_SEGMENT__COUNT_; cvector__segment_m++) {                     \
+      free((vec)->cvector_stable__segments_m[cvector__segment_m]);                                 \
+      (vec)->cvector_stable__segments_m[cvector__segment_m] = NULL;                                \
+    }                                                                                              \
+    cvector__setcap_((vec), cvector_segment__total_(cvector__keep_m));                             \
+  } while (0)
+
+/* PUBLIC: Removes every element, keeping the segments for reuse. */
+#define cvector__stable_clear(vec) (cvector__setsize_((vec), 0))
+
+/* PUBLIC: Frees every segment. */
+#define cvector__stable_free(vec)                                                                  \
+  do {                                                                                             \
+    cvector__setsize_((vec), 0);                                                                   \
+    cvector__stable_shrink_to_fit(vec);                                                            \
+  } while (0)
+
+/*
+ * Macro to create iterator type over stable vector type 'cvector__type_'. Walks a segment at a
+ * time, so 'next' is a pointer increment except when crossing into the next segment.
+ *
+ *   CVector_stable_iterator(cvector_stable_int_t) cvector_stable_int_iterator_t;
+ *
+ *   cvector_stable_int_iterator_t iterator;
+ *   cvector_stable_iterator__init(&iterator, &vector);
+ *
+ *   while (!cvector_stable_iterator__done(&iterator)) {
+ *     int value = cvector_stable_iterator__next(&iterator);
+ *   }
+ */
+#define CVector_stable_iterator(cvector__type_)                                                    \
+  typedef struct {                                                                                 \
+    cvector__type_ *cvector_stable_iterator__vec_m;                                                \
+    /* Index of next element */                                                                    \
+    size_t cvector_stable_iterator__next_index_m;                                                  \
+    /* Next segment to enter */                                                                    \
+    size_t cvector_stable_iterator__segment_m;                                                     \
+    /* Next element, and end of its segment */                                                     \
+    __typeof__(((cvector__type_ *)0)->cvector_stable__segments_m[0])                               \
+        cvector_stable_iterator__cur_m;                                                            \
+    __typeof__(((cvector__type_ *)0)->cvector_stable__segments_m[0])                               \
+        cvector_stable_iterator__end_m;                                                            \
+  }
+
+/* PUBLIC: Initializes iterator before first element of vector. */
+#define cvector_stable_iterator__init(iterator, vec)                                               \
+  do {                                                                                             \
+    (iterator)->cvector_stable_iterator__vec_m = (vec);                                            \
+    (iterator)->cvector_stable_iterator__next_index_m = 0;                                         \
+    (iterator)->cvector_stable_iterator__segment_m = 0;                                            \
+    (iterator)->cvector_stable_iterator__cur_m = NULL;                                             \
+    (iterator)->cvector_stable_iterator__end_m = NULL;                                             \
+  } while (0)
+
+/* PUBLIC: Returns whether every element was visited. */
+#define cvector_stable_iterator__done(iterator)                                                    \
+  ((iterator)->cvector_stable_iterator__next_index_m >=                                            \
+   cvector__size((iterator)->cvector_stable_iterator__vec_m))
+
+/* PUBLIC: Moves to next element and returns reference to it. */
+#define cvector_stable_iterator__next_ref(iterator)                                                \
+  ({                                                                                               \
+    if ((iterator)->cvector_stable_iterator__cur_m ==                                              \
+        (iterator)->cvector_stable_iterator__end_m) {                                              \
+      size_t cvector__segment_m = (iterator)->cvector_stable_iterator__segment_m++;                \
+      (iterator)->cvector_stable_iterator__cur_m =                                                 \
+          (iterator)->cvector_stable_iterator__vec_m->cvector_stable__segments_m                   \
+              [cvector__segment_m];                                                                \
+      (iterator)->cvector_stable_iterator__end_m =                                                 \
+          (iterator)->cvector_stable_iterator__cur_m + cvector_segment__size_(cvector__segment_m); \
+    }                                                                                              \
+    (iterator)->cvector_stable_iterator__next_index_m++;                                           \
+    ((iterator)->cvector_stable_iterator__cur_m++);                                                \
+  })
+
+/* PUBLIC: Moves to next element and returns it. */
+#define cvector_stable_iterator__next(iterator) (*cvector_stable_iterator__next_ref(iterator))
+
+#endif /* cvector_stable_h */
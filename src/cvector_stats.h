@@ -0,0 +1,316 @@
+/*
+ * Instrumentation for cvector, compiled in only when CVECTOR_STATS is defined.
+ *
+ * Growth and shrinking happen inside 'cvector__add', 'cvector__pop' and friends, so nothing shows
+ * how often a vector resizes or how much it copies. With CVECTOR_STATS defined (before the first
+ * include of cvector.h, or with -DCVECTOR_STATS) every vector counts:
+ *
+ *   - adds: elements added by 'cvector__add' / 'cvector__add_n'.
+ *   - resizes and shrinks: buffer resizes that grow or shrink cap.
+ *   - bytes copied: bytes of elements moved when a resize moved the buffer (an upper bound, large
+ *     blocks are often remapped rather than copied).
+ *   - peak cap: largest cap reached, in bytes.
+ *   - wasted: bytes of cap left unused when buffers were freed.
+ *
+ * The same counters are kept per call site ('file:line' of the 'cvector__*' call), in buffers
+ * owned by each thread so counting never shares a cache line. 'cvector__stats_dump' adds the
+ * buffers of every thread up and prints one line per call site. Sites with many resizes are the
+ * ones worth a 'cvector__init_with_cap' or 'cvector__reserve'.
+ *
+ * When <sys/sdt.h> is available, resizes and frees also fire USDT probes 'cvector:resize',
+ * 'cvector:shrink' and 'cvector:release', with arguments (buffer, old cap bytes, new cap bytes,
+ * bytes copied). Attach to them with bpftrace, perf or SystemTap:
+ *
+ *   bpftrace -e 'usdt:./app:cvector:resize { @[ustack] = count(); }'
+ *
+ * Without CVECTOR_STATS the hooks expand to nothing, vectors carry no extra field and
+ * 'cvector__stats_dump' reports no site.
+ *
+ * For example:
+ *
+ * #define CVECTOR_STATS
+ * #include "cvector.h"
+ *
+ * cvector_int_t vector;
+ * cvector__init(&vector);
+ * for (int i = 0; i < 1000; i++) {
+ *   cvector__add(&vector, i);
+ * }
+ * size_t resizes = cvector__stats(&vector)->cvector_stats__resizes_m;   // 11
+ * cvector__free(&vector);
+ *
+ * cvector__stats_dump(stderr);
+ */
+
+#ifndef cvector_stats_h
+#define cvector_stats_h
+
+#ifdef CVECTOR_STATS
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define CVECTOR_STATS__PROBE_(name, mem, old_bytes, new_bytes, copied)                             \
+  DTRACE_PROBE4(cvector, name, (mem), (old_bytes), (new_bytes), (copied))
+#endif
+#endif
+
+#ifndef CVECTOR_STATS__PROBE_
+#define CVECTOR_STATS__PROBE_(name, mem, old_bytes, new_bytes, copied) ((void)0)
+#endif
+
+/* Maximum number of call sites counted. Later sites are still counted per vector. */
+#ifndef CVECTOR_STATS__MAX_SITES
+#define CVECTOR_STATS__MAX_SITES 1024
+#endif
+
+/* Counters of a vector, of a call site, or of a sum of them. */
+typedef struct {
+  size_t cvector_stats__adds_m;
+  size_t cvector_stats__resizes_m;
+  size_t cvector_stats__shrinks_m;
+  size_t cvector_stats__bytes_copied_m;
+  size_t cvector_stats__peak_cap_m;
+  size_t cvector_stats__wasted_m;
+} cvector_stats_t;
+
+/* PRIVATE: Call site, one static instance per expansion of a counting macro. */
+typedef struct {
+  const char *cvector_stats_site__file_m;
+  int cvector_stats_site__line_m;
+  /* 0 until registered, then index in the site table + 1 (or past the table when it is full) */
+  unsigned int cvector_stats_site__id_m;
+} cvector_stats_site_t;
+
+/* PRIVATE: Counters of every call site, owned by one thread. */
+typedef struct cvector_stats_thread_ {
+  cvector_stats_t cvector_stats_thread__sites_m[CVECTOR_STATS__MAX_SITES];
+  struct cvector_stats_thread_ *cvector_stats_thread__next_m;
+} cvector_stats_thread_t;
+
+/* PRIVATE: Program wide state. Weak so that every translation unit including this header shares a
+ * single copy, and a dump sees the call sites of the whole program. */
+__attribute__((weak)) const cvector_stats_site_t *cvector_stats__sites_m[CVECTOR_STATS__MAX_SITES];
+__attribute__((weak)) unsigned int cvector_stats__site_count_m;
+__attribute__((weak)) bool cvector_stats__lock_m;
+/* Buffers of every thread that counted something, never freed so that counts outlive threads. */
+__attribute__((weak)) cvector_stats_thread_t *cvector_stats__threads_m;
+__attribute__((weak)) __thread cvector_stats_thread_t *cvector_stats__thread_m;
+
+/* PRIVATE: Static site for the 'cvector__*' call being expanded. */
+#define cvector_stats__site_()                                                                     \
+  ({                                                                                               \
+    static cvector_stats_site_t cvector_stats__site_m = {__FILE__, __LINE__, 0};                   \
+    &cvector_stats__site_m;                                                                        \
+  })
+
+/* PRIVATE: Gives 'site' an id, shared with every other site of the same file and line so that
+ * the resize inside a 'cvector__add' is counted with its adds. */
+static __attribute__((noinline, cold)) unsigned int
+cvector_stats__register_(cvector_stats_site_t *site) {
+  while (__atomic_test_and_set(&cvector_stats__lock_m, __ATOMIC_ACQUIRE)) {
+  }
+
+  unsigned int id = site->cvector_stats_site__id_m;
+  for (unsigned int i = 0; (id == 0) && (i < cvector_stats__site_count_m); i++) {
+    if ((cvector_stats__sites_m[i]->cvector_stats_site__line_m ==
+         site->cvector_stats_site__line_m) &&
+        (strcmp(cvector_stats__sites_m[i]->cvector_stats_site__file_m,
+                site->cvector_stats_site__file_m) == 0)) {
+      id = i + 1;
+    }
+  }
+  if ((id == 0) && (cvector_stats__site_count_m < CVECTOR_STATS__MAX_SITES)) {
+    cvector_stats__sites_m[cvector_stats__site_count_m] = site;
+    id = cvector_stats__site_count_m + 1;
+    __atomic_store_n(&cvector_stats__site_count_m, id, __ATOMIC_RELEASE);
+  } else if (id == 0) {
+    id = CVECTOR_STATS__MAX_SITES + 1;
+  }
+  __atomic_store_n(&(site->cvector_stats_site__id_m), id, __ATOMIC_RELEASE);
+
+  __atomic_clear(&cvector_stats__lock_m, __ATOMIC_RELEASE);
+  return id;
+}
+
+/* PRIVATE: Allocates the calling thread's buffer and links it for dumps. */
+static __attribute__((noinline, cold)) cvector_stats_thread_t *
+cvector_stats__thread_init_(void) {
+  cvector_stats_thread_t *thread = calloc(1, sizeof(cvector_stats_thread_t));
+  if (thread != NULL) {
+    thread->cvector_stats_thread__next_m =
+        __atomic_load_n(&cvector_stats__threads_m, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&cvector_stats__threads_m,
+                                        &(thread->cvector_stats_thread__next_m), thread, true,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+    cvector_stats__thread_m = thread;
+  }
+  return thread;
+}
+
+/* PRIVATE: Returns the calling thread's counters of 'site', NULL if they can't be kept. */
+static inline cvector_stats_t *cvector_stats__counters_(cvector_stats_site_t *site) {
+  unsigned int id = __atomic_load_n(&(site->cvector_stats_site__id_m), __ATOMIC_ACQUIRE);
+  if (__builtin_expect(id == 0, 0)) {
+    id = cvector_stats__register_(site);
+  }
+  cvector_stats_thread_t *thread = cvector_stats__thread_m;
+  if (__builtin_expect(thread == NULL, 0)) {
+    thread = cvector_stats__thread_init_();
+  }
+  if ((id > CVECTOR_STATS__MAX_SITES) || (thread == NULL)) {
+    return NULL;
+  }
+  return &(thread->cvector_stats_thread__sites_m[id - 1]);
+}
+
+/* PRIVATE: Adds 'event' to 'stats'. Only the owner thread writes, dumps may read concurrently. */
+static inline void cvector_stats__record_(cvector_stats_t *stats, const cvector_stats_t *event) {
+#define CVECTOR_STATS__BUMP_(field)                                                                \
+  __atomic_store_n(&(stats->field),                                                                \
+                   __atomic_load_n(&(stats->field), __ATOMIC_RELAXED) + event->field,              \
+                   __ATOMIC_RELAXED)
+  CVECTOR_STATS__BUMP_(cvector_stats__adds_m);
+  CVECTOR_STATS__BUMP_(cvector_stats__resizes_m);
+  CVECTOR_STATS__BUMP_(cvector_stats__shrinks_m);
+  CVECTOR_STATS__BUMP_(cvector_stats__bytes_copied_m);
+  CVECTOR_STATS__BUMP_(cvector_stats__wasted_m);
+#undef CVECTOR_STATS__BUMP_
+  if (event->cvector_stats__peak_cap_m >
+      __atomic_load_n(&(stats->cvector_stats__peak_cap_m), __ATOMIC_RELAXED)) {
+    __atomic_store_n(&(stats->cvector_stats__peak_cap_m), event->cvector_stats__peak_cap_m,
+                     __ATOMIC_RELAXED);
+  }
+}
+
+/* PRIVATE: Counts 'event' for the vector and for the call site. */
+static inline void cvector_stats__event_(cvector_stats_t *vector, cvector_stats_site_t *site,
+                                         cvector_stats_t event) {
+  cvector_stats__record_(vector, &event);
+  cvector_stats_t *counters = cvector_stats__counters_(site);
+  if (counters != NULL) {
+    cvector_stats__record_(counters, &event);
+  }
+}
+
+/* PRIVATE: Counts a resize of buffer 'old_mem' holding 'size' elements from 'old_cap' to
+ * 'new_cap' elements, now at 'new_mem'. */
+static inline void cvector_stats__resize_(cvector_stats_t *vector, cvector_stats_site_t *site,
+                                          const void *old_mem, const void *new_mem,
+                                          size_t elem_size, size_t size, size_t old_cap,
+                                          size_t new_cap) {
+  bool grows = new_cap > old_cap;
+  size_t copied = ((old_mem != NULL) && (new_mem != old_mem)) ? size * elem_size : 0;
+  cvector_stats_t event = {
+      .cvector_stats__resizes_m = grows ? 1 : 0,
+      .cvector_stats__shrinks_m = grows ? 0 : 1,
+      .cvector_stats__bytes_copied_m = copied,
+      .cvector_stats__peak_cap_m = new_cap * elem_size,
+  };
+  if (grows) {
+    CVECTOR_STATS__PROBE_(resize, new_mem, old_cap * elem_size, new_cap * elem_size, copied);
+  } else {
+    CVECTOR_STATS__PROBE_(shrink, new_mem, old_cap * elem_size, new_cap * elem_size, copied);
+  }
+  cvector_stats__event_(vector, site, event);
+}
+
+/* PRIVATE: Counts the release of heap buffer 'mem' of 'cap' elements, 'size' of them in use. */
+static inline void cvector_stats__release_(cvector_stats_t *vector, cvector_stats_site_t *site,
+                                           const void *mem, size_t elem_size, size_t size,
+                                           size_t cap) {
+  if (mem != NULL) {
+    size_t wasted = (cap > size) ? (cap - size) * elem_size : 0;
+    cvector_stats_t event = {.cvector_stats__wasted_m = wasted};
+    CVECTOR_STATS__PROBE_(release, mem, cap * elem_size, 0, wasted);
+    cvector_stats__event_(vector, site, event);
+  }
+}
+
+/* PUBLIC: Sums the counters of every call site over every thread into 'total' (peak cap is the
+ * largest one). Returns number of call sites. */
+static inline size_t cvector__stats_total(cvector_stats_t *total) {
+  memset(total, 0, sizeof(*total));
+  unsigned int count = __atomic_load_n(&cvector_stats__site_count_m, __ATOMIC_ACQUIRE);
+  for (cvector_stats_thread_t *thread =
+           __atomic_load_n(&cvector_stats__threads_m, __ATOMIC_ACQUIRE);
+       thread != NULL; thread = thread->cvector_stats_thread__next_m) {
+    for (unsigned int i = 0; i < count; i++) {
+      cvector_stats__record_(total, &(thread->cvector_stats_thread__sites_m[i]));
+    }
+  }
+  return count;
+}
+
+/* PUBLIC: Prints counters of every call site, summed over every thread, to 'out'.
+ * Returns number of call sites printed. */
+static inline size_t cvector__stats_dump(FILE *out) {
+  unsigned int count = __atomic_load_n(&cvector_stats__site_count_m, __ATOMIC_ACQUIRE);
+  fprintf(out, "%-40s %12s %10s %10s %16s %16s %16s\n", "site", "adds", "resizes", "shrinks",
+          "bytes_copied", "peak_cap_bytes", "wasted_bytes");
+  for (unsigned int i = 0; i < count; i++) {
+    cvector_stats_t site = {0};
+    for (cvector_stats_thread_t *thread =
+             __atomic_load_n(&cvector_stats__threads_m, __ATOMIC_ACQUIRE);
+         thread != NULL; thread = thread->cvector_stats_thread__next_m) {
+      cvector_stats__record_(&site, &(thread->cvector_stats_thread__sites_m[i]));
+    }
+
+    char name[40];
+    snprintf(name, sizeof(name), "%s:%d", cvector_stats__sites_m[i]->cvector_stats_site__file_m,
+             cvector_stats__sites_m[i]->cvector_stats_site__line_m);
+    fprintf(out, "%-40s %12zu %10zu %10zu %16zu %16zu %16zu\n", name, site.cvector_stats__adds_m,
+            site.cvector_stats__resizes_m, site.cvector_stats__shrinks_m,
+            site.cvector_stats__bytes_copied_m, site.cvector_stats__peak_cap_m,
+            site.cvector_stats__wasted_m);
+  }
+  return count;
+}
+
+/* PUBLIC: Returns the counters of vector 'vec' (a 'const cvector_stats_t *'). */
+#define cvector__stats(vec) ((const cvector_stats_t *)&((vec)->cvector__stats_m))
+
+/* PRIVATE: Hooks used by cvector.h. */
+#define CVECTOR_STATS__FIELDS_ cvector_stats_t cvector__stats_m;
+
+#define cvector__stats_init_(vec) (memset(&((vec)->cvector__stats_m), 0, sizeof(cvector_stats_t)))
+
+#define cvector__stats_add_(vec, n)                                                                \
+  cvector_stats__event_(&((vec)->cvector__stats_m), cvector_stats__site_(),                        \
+                        (cvector_stats_t){.cvector_stats__adds_m = (n)})
+
+#define cvector__stats_resize_(vec, mem, cap)                                                      \
+  cvector_stats__resize_(&((vec)->cvector__stats_m), cvector_stats__site_(), cvector__elem_(vec),  \
+                         (mem), cvector__elem_size_(vec), cvector__size(vec), cvector__cap_(vec),  \
+                         (cap))
+
+#define cvector__stats_release_(vec)                                                               \
+  do {                                                                                             \
+    if (!(cvector__flags_(vec) & CVECTOR__FLAG_INLINE_)) {                                         \
+      cvector_stats__release_(&((vec)->cvector__stats_m), cvector_stats__site_(),                  \
+                              cvector__elem_(vec), cvector__elem_size_(vec), cvector__size(vec),   \
+                              cvector__cap_(vec));                                                 \
+    }                                                                                              \
+  } while (0)
+
+#else
+
+/* PRIVATE: Hooks used by cvector.h, compiled out. */
+#define CVECTOR_STATS__FIELDS_
+#define cvector__stats_init_(vec) ((void)0)
+#define cvector__stats_add_(vec, n) ((void)0)
+#define cvector__stats_resize_(vec, mem, cap) ((void)0)
+#define cvector__stats_release_(vec) ((void)0)
+
+/* PUBLIC: Without CVECTOR_STATS nothing is counted and no call site is printed. */
+#define cvector__stats_dump(out) ((void)(out), (size_t)0)
+
+#endif /* CVECTOR_STATS */
+
+#endif /* cvector_stats_h */
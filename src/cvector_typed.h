@@ -0,0 +1,161 @@
+/*
+ * Type specialized functions for cvector.
+ *
+ * Every 'cvector__*' macro is expanded in full at each call site, growth path included. The
+ * generators below wrap the same macros into typed functions instead:
+ *
+ *   - The hot paths (add within cap, index, pop without shrinking) are 'static inline' so they
+ *     still compile down to a compare and a store.
+ *   - The paths that resize (growth, shrinking, reserve) are separate functions marked
+ *     noinline and cold, so call sites only carry a call and the compiler lays them out of the way.
+ *   - No GNU statement expression is needed to use them, 'pop' is a plain function.
+ *
+ * Vectors made by the generators are regular 'CVector(T)' and work with every 'cvector__*' macro.
+ *
+ * Single translation unit, everything 'static':
+ *
+ * CVECTOR_DEFINE(vec_int, int)
+ *
+ * vec_int_t numbers;
+ * vec_int_init(&numbers);
+ * vec_int_add(&numbers, 42);
+ * int last = vec_int_pop(&numbers);
+ * vec_int_free(&numbers);
+ *
+ * Shared between translation units, with one out-of-line copy of the cold functions:
+ *
+ * // vec_int.h
+ * CVECTOR_DECLARE(vec_int, int)
+ *
+ * // vec_int.c
+ * #include "vec_int.h"
+ * CVECTOR_IMPL(vec_int, int)
+ */
+
+#ifndef cvector_typed_h
+#define cvector_typed_h
+
+#include "cvector.h"
+
+/* PRIVATE: Attributes of the functions that resize. */
+#define CVECTOR_TYPED__COLD_ __attribute__((noinline, cold))
+
+/* PRIVATE: Linkage of the functions that resize when generated for a single translation unit.
+ * Marked unused so that the ones a unit doesn't call aren't reported by -Wunused-function. */
+#define CVECTOR_TYPED__STATIC_ static __attribute__((unused))
+
+/* PRIVATE: Declarations of the functions that resize, with linkage 'linkage'. */
+#define CVECTOR_TYPED__COLD_DECLS_(name, T, linkage)                                               \
+  linkage name##_t name##_grow_(name##_t vec, size_t min_cap);                                     \
+  linkage name##_t name##_shrink_(name##_t vec);                                                   \
+  linkage void name##_reserve(name##_t *vec, size_t cap);                                          \
+  linkage void name##_shrink_to_fit(name##_t *vec);                                                \
+  linkage void name##_add_n(name##_t *vec, const T *values, size_t n);
+
+/* PRIVATE: Definitions of the functions that resize, with linkage 'linkage'. */
+#define CVECTOR_TYPED__COLD_DEFS_(name, T, linkage)                                                \
+  /* Makes room for at least 'min_cap' elements following the growth policy. The vector goes in    \
+   * and out by value so that callers' vectors don't escape and can stay in registers. */          \
+  linkage CVECTOR_TYPED__COLD_ name##_t name##_grow_(name##_t vec, size_t min_cap) {               \
+    cvector__grow_(&vec, min_cap);                                                                 \
+    return vec;                                                                                    \
+  }                                                                                                \
+  /* Shrinks when the load factor is low, see 'cvector__shrink_'. By value like 'grow_'. */        \
+  linkage CVECTOR_TYPED__COLD_ name##_t name##_shrink_(name##_t vec) {                             \
+    cvector__shrink_(&vec);                                                                        \
+    return vec;                                                                                    \
+  }                                                                                                \
+  /* Same as 'cvector__reserve'. */                                                                \
+  linkage CVECTOR_TYPED__COLD_ void name##_reserve(name##_t *vec, size_t cap) {                    \
+    cvector__reserve(vec, cap);                                                                    \
+  }                                                                                                \
+  /* Same as 'cvector__shrink_to_fit'. */                                                          \
+  linkage CVECTOR_TYPED__COLD_ void name##_shrink_to_fit(name##_t *vec) {                          \
+    cvector__shrink_to_fit(vec);                                                                   \
+  }                                                                                                \
+  /* Same as 'cvector__add_n'. */                                                                  \
+  linkage CVECTOR_TYPED__COLD_ void name##_add_n(name##_t *vec, const T *values, size_t n) {       \
+    cvector__add_n(vec, values, n);                                                                \
+  }
+
+/* PRIVATE: Inline hot paths, calling the cold functions only when the buffer must change. */
+#define CVECTOR_TYPED__HOT_(name, T)                                                               \
+  /* Same as 'cvector__init'. */                                                                   \
+  static inline void name##_init(name##_t *vec) { cvector__init(vec); }                            \
+  /* Returns number of elements. */                                                                \
+  static inline size_t name##_size(const name##_t *vec) { return cvector__size(vec); }             \
+  /* Returns number of elements the buffer holds. */                                               \
+  static inline size_t name##_cap(const name##_t *vec) { return cvector__cap_(vec); }              \
+  /* Returns element at given index. */                                                            \
+  static inline T name##_index(const name##_t *vec, size_t index) {                                \
+    return cvector__index(vec, index);                                                             \
+  }                                                                                                \
+  /* Returns reference to element at given index. */                                               \
+  static inline T *name##_index_ref(name##_t *vec, size_t index) {                                 \
+    return cvector__index_ref(vec, index);                                                         \
+  }                                                                                                \
+  /* Same as 'cvector__set_at_index', returns -1 if index is out of bound. */                      \
+  static inline int name##_set_at_index(name##_t *vec, size_t index, T val) {                      \
+    return cvector__set_at_index(vec, index, val);                                                 \
+  }                                                                                                \
+  /* Same as 'cvector__add', growth is an out of line call. Dropped on OOM. */                     \
+  static inline void name##_add(name##_t *vec, T val) {                                            \
+    if (__builtin_expect(cvector__size(vec) >= cvector__cap_(vec), 0)) {                           \
+      *vec = name##_grow_(*vec, cvector__size(vec) + 1);                                           \
+      if (cvector__size(vec) >= cvector__cap_(vec)) {                                              \
+        return;                                                                                    \
+      }                                                                                            \
+    }                                                                                              \
+    cvector__elem_(vec)[cvector__size(vec)] = val;                                                 \
+    cvector__setsize_(vec, cvector__size(vec) + 1);                                                \
+    cvector__stats_add_(vec, 1);                                                                   \
+  }                                                                                                \
+  /* Same as 'cvector__pop', shrinking is an out of line call. Vector must not be empty. */        \
+  static inline T name##_pop(name##_t *vec) {                                                      \
+    if (__builtin_expect(((cvector__size(vec) << 10) <=                                            \
+                          (cvector__cap_(vec) * CVECTOR__LOAD_FACTOR_Q10_)) &&                     \
+                             (cvector__size(vec) >= CVECTOR__MIN_SHRINK_SIZE),                     \
+                         0)) {                                                                     \
+      *vec = name##_shrink_(*vec);                                                                 \
+    }                                                                                              \
+    cvector__setsize_(vec, cvector__size(vec) - 1);                                                \
+    cvector__share_trim_(vec);                                                                     \
+    return cvector__index(vec, cvector__size(vec));                                                \
+  }                                                                                                \
+  /* Same as 'cvector__pop_noshrink'. Vector must not be empty. */                                 \
+  static inline T name##_pop_noshrink(name##_t *vec) {                                             \
+    cvector__setsize_(vec, cvector__size(vec) - 1);                                                \
+    cvector__share_trim_(vec);                                                                     \
+    return cvector__index(vec, cvector__size(vec));                                                \
+  }                                                                                                \
+  /* Same as 'cvector__free'. */                                                                   \
+  static inline void name##_free(name##_t *vec) { cvector__free(vec); }                            \
+  /* Removes every element, keeping the buffer. */                                                 \
+  static inline void name##_clear(name##_t *vec) {                                                 \
+    cvector__setsize_(vec, 0);                                                                     \
+    cvector__share_trim_(vec);                                                                     \
+  }
+
+/*
+ * PUBLIC: Generates vector type 'name_t' of elements of type 'T' and its 'name_*' functions, all
+ * 'static' to the translation unit.
+ */
+#define CVECTOR_DEFINE(name, T)                                                                    \
+  CVector(T) name##_t;                                                                             \
+  CVECTOR_TYPED__COLD_DECLS_(name, T, CVECTOR_TYPED__STATIC_)                                      \
+  CVECTOR_TYPED__HOT_(name, T)                                                                     \
+  CVECTOR_TYPED__COLD_DEFS_(name, T, CVECTOR_TYPED__STATIC_)
+
+/*
+ * PUBLIC: Generates vector type 'name_t' and its inline functions, and declares the functions that
+ * resize. One translation unit must define them with 'CVECTOR_IMPL(name, T)'.
+ */
+#define CVECTOR_DECLARE(name, T)                                                                   \
+  CVector(T) name##_t;                                                                             \
+  CVECTOR_TYPED__COLD_DECLS_(name, T, extern)                                                      \
+  CVECTOR_TYPED__HOT_(name, T)
+
+/* PUBLIC: Defines the functions declared by 'CVECTOR_DECLARE(name, T)', once per program. */
+#define CVECTOR_IMPL(name, T) CVECTOR_TYPED__COLD_DEFS_(name, T, )
+
+#endif /* cvector_typed_h */
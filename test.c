@@ -1,7 +1,29 @@
 #include "src/cvector.h"
+#include "src/cvector_alloc.h"
+#include "src/cvector_bits.h"
+#include "src/cvector_concurrent.h"
+#include "src/cvector_deque.h"
+#include "src/cvector_file.h"
+#include "src/cvector_incremental.h"
+#include "src/cvector_io.h"
+#include "src/cvector_map.h"
+#include "src/cvector_mmap.h"
+#include "src/cvector_packed.h"
+#include "src/cvector_parallel.h"
+#include "src/cvector_sharded.h"
+#include "src/cvector_simd.h"
+#include "src/cvector_soa.h"
+#include "src/cvector_sorted.h"
+#include "src/cvector_stable.h"
+#include "src/cvector_stats.h"
+#include "src/cvector_typed.h"
 
 #include <assert.h>
+#include <limits.h>
 #include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
 
 void test__vector_init() {
   CVector(int) vector_int_t;
@@ -198,6 +220,47 @@ void test__vector_pop() {
   }
 }
 
+void test__vector_pop_noshrink() {
+  CVector(int) vector_int_t;
+  vector_int_t vector_int;
+  cvector__init(&vector_int);
+
+  for (int i = 0; i < 128; i++) {
+    cvector__add(&vector_int, i);
+  }
+
+  for (int i = 127; i >= 0; i--) {
+    assert(cvector__pop_noshrink(&vector_int) == i);
+  }
+  assert(cvector__size(&vector_int) == 0);
+  assert(cvector__cap_(&vector_int) == 128);
+
+  cvector__free(&vector_int);
+}
+
+void test__vector_shrink() {
+  CVector(int) vector_int_t;
+  vector_int_t vector_int;
+  cvector__init(&vector_int);
+
+  for (int i = 0; i < 128; i++) {
+    cvector__add(&vector_int, i);
+  }
+
+  // load factor is above 0.25 down to size 33
+  while (cvector__size(&vector_int) > 32) {
+    cvector__pop(&vector_int);
+  }
+  assert(cvector__cap_(&vector_int) == 128);
+
+  // size 32 / cap 128 hits the load factor, shrinks to 64
+  cvector__pop(&vector_int);
+  assert(cvector__cap_(&vector_int) == 64);
+  assert(cvector__size(&vector_int) == 31);
+
+  cvector__free(&vector_int);
+}
+
 void test__iterator_new() {
   CVector(int) vector_int_t;
   CVector_iterator(vector_int_t) iterator_int_t;
@@ -400,17 +463,2173 @@ void test__vector_free() {
   assert(cvector__wrapped_buffer(&cvector_int) == NULL);
 }
 
+void test__vector_resize() {
+  CVector(int) vector_int_t;
+  vector_int_t vector_int;
+  cvector__init(&vector_int);
+
+  for (int i = 0; i < 100; i++) {
+    cvector__add(&vector_int, i);
+  }
+
+  // grow well past current cap, elements must survive the move
+  cvector__resize_(&vector_int, 1 << 20);
+  assert(cvector__cap_(&vector_int) == (1 << 20));
+
+  // shrink back down to size
+  cvector__resize_(&vector_int, 100);
+  assert(cvector__cap_(&vector_int) == 100);
+
+  for (int i = 0; i < 100; i++) {
+    assert(cvector__index(&vector_int, i) == i);
+  }
+
+  cvector__free(&vector_int);
+}
+
+void test__vector_add_n() {
+  CVector(int) vector_int_t;
+  vector_int_t vector_int;
+  cvector__init(&vector_int);
+
+  int values[100];
+  for (int i = 0; i < 100; i++) {
+    values[i] = i;
+  }
+
+  cvector__add_n(&vector_int, values, 100);
+  assert(cvector__size(&vector_int) == 100);
+  assert(cvector__cap_(&vector_int) == 128);
+
+  cvector__extend_from(&vector_int, values, 0);
+  assert(cvector__size(&vector_int) == 100);
+
+  cvector__extend_from(&vector_int, values, 50);
+  assert(cvector__size(&vector_int) == 150);
+  assert(cvector__cap_(&vector_int) == 256);
+
+  for (int i = 0; i < 150; i++) {
+    assert(cvector__index(&vector_int, i) == (i % 100));
+  }
+
+  cvector__free(&vector_int);
+}
+
+void test__vector_extend() {
+  CVector(int) vector_int_t;
+  vector_int_t vector_a;
+  vector_int_t vector_b;
+  cvector__init(&vector_a);
+  cvector__init(&vector_b);
+
+  for (int i = 0; i < 10; i++) {
+    cvector__add(&vector_a, i);
+    cvector__add(&vector_b, 10 + i);
+  }
+
+  cvector__extend(&vector_a, &vector_b);
+  assert(cvector__size(&vector_a) == 20);
+
+  // extending with itself doubles the vector
+  cvector__extend(&vector_a, &vector_a);
+  assert(cvector__size(&vector_a) == 40);
+
+  for (int i = 0; i < 40; i++) {
+    assert(cvector__index(&vector_a, i) == (i % 20));
+  }
+
+  cvector__free(&vector_a);
+  cvector__free(&vector_b);
+}
+
+void test__vector_insert_range() {
+  CVector(int) vector_int_t;
+  vector_int_t vector_int;
+  cvector__init(&vector_int);
+
+  int head[3] = {0, 1, 2};
+  int tail[3] = {6, 7, 8};
+  int middle[3] = {3, 4, 5};
+
+  assert(cvector__insert_range(&vector_int, 0, tail, 3) == 0);
+  assert(cvector__insert_range(&vector_int, 0, head, 3) == 0);
+  assert(cvector__insert_range(&vector_int, 3, middle, 3) == 0);
+
+  // out of bound
+  assert(cvector__insert_range(&vector_int, 10, middle, 3) == -1);
+  assert(cvector__size(&vector_int) == 9);
+
+  for (int i = 0; i < 9; i++) {
+    assert(cvector__index(&vector_int, i) == i);
+  }
+
+  cvector__free(&vector_int);
+}
+
+void test__vector_erase_range() {
+  CVector(int) vector_int_t;
+  vector_int_t vector_int;
+  cvector__init(&vector_int);
+
+  for (int i = 0; i < 10; i++) {
+    cvector__add(&vector_int, i);
+  }
+
+  assert(cvector__erase_range(&vector_int, 2, 3) == 0);
+  assert(cvector__size(&vector_int) == 7);
+  assert(cvector__index(&vector_int, 1) == 1);
+  assert(cvector__index(&vector_int, 2) == 5);
+  assert(cvector__last(&vector_int) == 9);
+
+  // out of bound
+  assert(cvector__erase_range(&vector_int, 5, 3) == -1);
+  assert(cvector__size(&vector_int) == 7);
+
+  assert(cvector__erase_range(&vector_int, 0, 7) == 0);
+  assert(cvector__size(&vector_int) == 0);
+
+  cvector__free(&vector_int);
+}
+
+void test__vector_growth() {
+  CVector(int) vector_int_t;
+  vector_int_t vector_int;
+
+  {
+    cvector__init(&vector_int);
+    cvector__set_growth(&vector_int, CVECTOR__GROWTH_1_5X);
+
+    size_t caps[] = {1, 2, 3, 4, 6, 6, 9, 9, 9, 13};
+    for (int i = 0; i < 10; i++) {
+      cvector__add(&vector_int, i);
+      assert(cvector__cap_(&vector_int) == caps[i]);
+    }
+    cvector__free(&vector_int);
+  }
+
+  {
+    cvector__init(&vector_int);
+    cvector__set_growth(&vector_int, CVECTOR__GROWTH_PAGE);
+
+    cvector__add(&vector_int, 1);
+    assert(cvector__cap_(&vector_int) == CVECTOR__PAGE_SIZE / sizeof(int));
+
+    for (size_t i = 0; i < CVECTOR__PAGE_SIZE / sizeof(int); i++) {
+      cvector__add(&vector_int, 1);
+    }
+    assert(cvector__cap_(&vector_int) == (2 * CVECTOR__PAGE_SIZE) / sizeof(int));
+    cvector__free(&vector_int);
+
+    // 24 byte elements don't divide the page, buffers still end on a page boundary
+    typedef struct {
+      char bytes[24];
+    } bytes_24_t;
+    CVector(bytes_24_t) vector_24_t;
+    vector_24_t vector_24;
+    cvector__init(&vector_24);
+    cvector__set_growth(&vector_24, CVECTOR__GROWTH_PAGE);
+    for (int i = 0; i < 2000; i++) {
+      cvector__add(&vector_24, ((bytes_24_t){{0}}));
+      assert((cvector__cap_(&vector_24) * sizeof(bytes_24_t)) % CVECTOR__PAGE_SIZE == 0);
+    }
+    assert(cvector__cap_(&vector_24) == 2048);
+    cvector__free(&vector_24);
+  }
+
+  {
+    cvector__init(&vector_int);
+    cvector__set_growth(&vector_int, CVECTOR__GROWTH_CHUNK);
+
+    size_t step = CVECTOR__GROWTH_CHUNK_SIZE / sizeof(int);
+    cvector__add(&vector_int, 1);
+    assert(cvector__cap_(&vector_int) == step);
+    cvector__free(&vector_int);
+  }
+}
+
+void test__vector_reserve() {
+  CVector(int) vector_int_t;
+  vector_int_t vector_int;
+  cvector__init(&vector_int);
+
+  cvector__reserve(&vector_int, 100);
+  assert(cvector__cap_(&vector_int) == 100);
+
+  // never shrinks
+  cvector__reserve(&vector_int, 10);
+  assert(cvector__cap_(&vector_int) == 100);
+
+  for (int i = 0; i < 100; i++) {
+    cvector__add(&vector_int, i);
+  }
+  assert(cvector__cap_(&vector_int) == 100);
+
+  cvector__free(&vector_int);
+}
+
+void test__vector_shrink_to_fit() {
+  CVector(int) vector_int_t;
+  vector_int_t vector_int;
+  cvector__init(&vector_int);
+
+  for (int i = 0; i < 100; i++) {
+    cvector__add(&vector_int, i);
+  }
+  assert(cvector__cap_(&vector_int) == 128);
+
+  cvector__shrink_to_fit(&vector_int);
+  assert(cvector__cap_(&vector_int) == 100);
+  assert(cvector__last(&vector_int) == 99);
+
+  cvector__erase_range(&vector_int, 0, 100);
+  cvector__shrink_to_fit(&vector_int);
+  assert(cvector__cap_(&vector_int) == 0);
+  assert(cvector__wrapped_buffer(&vector_int) == NULL);
+
+  cvector__free(&vector_int);
+}
+
+void test__vector_noshrink() {
+  CVector(int) vector_int_t;
+  vector_int_t vector_int;
+  cvector__init(&vector_int);
+  cvector__set_shrink(&vector_int, false);
+
+  for (int i = 0; i < 1000; i++) {
+    cvector__add(&vector_int, i);
+  }
+
+  for (int i = 0; i < 1000; i++) {
+    cvector__pop(&vector_int);
+  }
+  assert(cvector__cap_(&vector_int) == 1024);
+
+  cvector__set_shrink(&vector_int, true);
+  for (int i = 0; i < 1000; i++) {
+    cvector__add(&vector_int, i);
+  }
+
+  for (int i = 0; i < 1000; i++) {
+    cvector__pop(&vector_int);
+  }
+  assert(cvector__cap_(&vector_int) < 1024);
+
+  cvector__free(&vector_int);
+}
+
+void test__vector_small() {
+  CVector_small(int, 16) vector_small_int_t;
+  CVector_iterator(vector_small_int_t) iterator_small_int_t;
+
+  vector_small_int_t vector_small_int;
+  cvector__init_small(&vector_small_int);
+
+  assert(cvector__size(&vector_small_int) == 0);
+  assert(cvector__cap_(&vector_small_int) == 16);
+
+  for (int i = 0; i < 16; i++) {
+    cvector__add(&vector_small_int, i);
+  }
+
+  // still inline
+  assert(cvector__wrapped_buffer(&vector_small_int) == vector_small_int.cvector__inline_m);
+  assert(cvector__cap_(&vector_small_int) == 16);
+
+  // spills to heap
+  for (int i = 16; i < 100; i++) {
+    cvector__add(&vector_small_int, i);
+  }
+
+  assert(cvector__wrapped_buffer(&vector_small_int) != vector_small_int.cvector__inline_m);
+  assert(cvector__cap_(&vector_small_int) == 128);
+
+  iterator_small_int_t iterator_small_int;
+  cvector_iterator__init(&iterator_small_int, &vector_small_int);
+
+  int i = 0;
+  for (;;) {
+    if (cvector_iterator__done(&iterator_small_int)) {
+      break;
+    }
+
+    assert(cvector_iterator__next(&iterator_small_int) == i);
+    i++;
+  }
+
+  for (int i = 99; i >= 0; i--) {
+    assert(cvector__pop(&vector_small_int) == i);
+  }
+
+  cvector__free(&vector_small_int);
+
+  // freeing while inline must not touch the heap
+  cvector__init_small(&vector_small_int);
+  cvector__add(&vector_small_int, 1);
+  assert(cvector__pop(&vector_small_int) == 1);
+  cvector__free(&vector_small_int);
+}
+
+void test__vector_arena() {
+  CVector(int) vector_int_t;
+
+  cvector_arena_t arena;
+  cvector_arena__init(&arena, 64 * 1024);
+
+  vector_int_t vector_a;
+  vector_int_t vector_b;
+  cvector__init_with_allocator(&vector_a, cvector_arena__allocator(&arena));
+  cvector__init_with_allocator(&vector_b, cvector_arena__allocator(&arena));
+
+  // interleaved growth forces copies, growth of the last block happens in place
+  for (int i = 0; i < 1000; i++) {
+    cvector__add(&vector_a, i);
+    cvector__add(&vector_b, -i);
+  }
+
+  for (int i = 0; i < 1000; i++) {
+    assert(cvector__index(&vector_a, i) == i);
+    assert(cvector__index(&vector_b, i) == -i);
+  }
+
+  // last block is grown in place
+  int *buffer = cvector__wrapped_buffer(&vector_b);
+  cvector__resize_(&vector_b, cvector__cap_(&vector_b) + 1);
+  assert(cvector__wrapped_buffer(&vector_b) == buffer);
+
+  // no per vector free, reset releases both
+  cvector_arena__reset(&arena);
+  assert(arena.cvector_arena__chunk_m->cvector_arena_chunk__prev_m == NULL);
+
+  cvector__init_with_allocator(&vector_a, cvector_arena__allocator(&arena));
+  cvector__add(&vector_a, 7);
+  assert(cvector__index(&vector_a, 0) == 7);
+
+  cvector_arena__destroy(&arena);
+}
+
+void test__vector_pool() {
+  CVector(long) vector_long_t;
+
+  cvector_pool_t pool;
+  cvector_pool__init(&pool);
+
+  assert(cvector_pool__class_(1) == 0);
+  assert(cvector_pool__class_(16) == 0);
+  assert(cvector_pool__class_(17) == 1);
+  assert(cvector_pool__class_(CVECTOR_POOL__MAX_CLASS) == cvector_pool__classes_ - 1);
+
+  vector_long_t vector_long;
+  cvector__init_with_allocator(&vector_long, cvector_pool__allocator(&pool));
+
+  // goes past CVECTOR_POOL__MAX_CLASS and falls through to libc
+  for (long i = 0; i < 100000; i++) {
+    cvector__add(&vector_long, i);
+  }
+
+  for (long i = 0; i < 100000; i++) {
+    assert(cvector__index(&vector_long, i) == i);
+  }
+
+  cvector__free(&vector_long);
+
+  // freed blocks are recycled
+  cvector__init_with_allocator(&vector_long, cvector_pool__allocator(&pool));
+  cvector__add(&vector_long, 1);
+  long *first = cvector__wrapped_buffer(&vector_long);
+  cvector__free(&vector_long);
+
+  cvector__init_with_allocator(&vector_long, cvector_pool__allocator(&pool));
+  cvector__add(&vector_long, 2);
+  assert(cvector__wrapped_buffer(&vector_long) == first);
+  cvector__free(&vector_long);
+
+  cvector_pool__destroy(&pool);
+}
+
+void test__vector_mmap() {
+  CVector(long) vector_long_t;
+
+  cvector_mmap_t huge;
+  cvector_mmap__init(&huge, 64 * 1024, true);
+
+  vector_long_t vector_long;
+  cvector__init_with_allocator(&vector_long, cvector_mmap__allocator(&huge));
+
+  // crosses the threshold and keeps growing through mremap
+  for (long i = 0; i < 1000000; i++) {
+    cvector__add(&vector_long, i);
+  }
+  assert(cvector_mmap__is_mapped_(&huge, cvector__cap_(&vector_long) * sizeof(long)));
+
+  for (long i = 0; i < 1000000; i++) {
+    assert(cvector__index(&vector_long, i) == i);
+  }
+
+  // shrinks back below the threshold onto the heap
+  while (cvector__size(&vector_long) > 100) {
+    cvector__pop(&vector_long);
+  }
+  cvector__shrink_to_fit(&vector_long);
+  assert(!cvector_mmap__is_mapped_(&huge, cvector__cap_(&vector_long) * sizeof(long)));
+
+  for (long i = 0; i < 100; i++) {
+    assert(cvector__index(&vector_long, i) == i);
+  }
+
+  cvector__free(&vector_long);
+}
+
+void test__vector_file() {
+  typedef struct record_t {
+    long id;
+    double score;
+  } record_t;
+
+  CVector(record_t) vector_record_t;
+  CVector_iterator(vector_record_t) iterator_record_t;
+
+  char path[] = "/tmp/cvector_test_XXXXXX";
+  close(mkstemp(path));
+
+  vector_record_t records;
+  cvector_file_t file;
+
+  // create and fill past the first chunk
+  assert(cvector__file_open(&records, &file, path, CVECTOR_FILE__RDWR) == 0);
+  assert(cvector__size(&records) == 0);
+
+  for (long i = 0; i < 100000; i++) {
+    cvector__add(&records, ((record_t){.id = i, .score = i * 0.5}));
+  }
+  cvector__file_close(&records, &file);
+
+  // attach read only, no load step
+  assert(cvector__file_open(&records, &file, path, CVECTOR_FILE__RDONLY) == 0);
+  assert(cvector__size(&records) == 100000);
+  assert(cvector__last(&records).id == 99999);
+
+  iterator_record_t iterator_record;
+  cvector_iterator__init(&iterator_record, &records);
+
+  long i = 0;
+  for (;;) {
+    if (cvector_iterator__done(&iterator_record)) {
+      break;
+    }
+
+    record_t record = cvector_iterator__next(&iterator_record);
+    assert(record.id == i);
+    assert(record.score == i * 0.5);
+    i++;
+  }
+  cvector__file_close(&records, &file);
+
+  // reopen for writing and append
+  assert(cvector__file_open(&records, &file, path, CVECTOR_FILE__RDWR) == 0);
+  cvector__add(&records, ((record_t){.id = -1}));
+  assert(cvector__file_sync(&records, &file) == 0);
+  cvector__file_close(&records, &file);
+
+  assert(cvector__file_open(&records, &file, path, CVECTOR_FILE__RDONLY) == 0);
+  assert(cvector__size(&records) == 100001);
+  assert(cvector__last(&records).id == -1);
+  cvector__file_close(&records, &file);
+
+  // shrinking an emptied vector keeps the mapping, closing twice is harmless
+  assert(cvector__file_open(&records, &file, path, CVECTOR_FILE__RDWR) == 0);
+  assert(cvector__erase_range(&records, 0, cvector__size(&records)) == 0);
+  cvector__shrink_to_fit(&records);
+  assert(cvector__cap_(&records) == 0);
+  cvector__file_close(&records, &file);
+  cvector__file_close(&records, &file);
+
+  assert(cvector__file_open(&records, &file, path, CVECTOR_FILE__RDWR) == 0);
+  assert(cvector__size(&records) == 0);
+  cvector__shrink_to_fit(&records);
+  cvector__add(&records, ((record_t){.id = 7}));
+  cvector__file_close(&records, &file);
+
+  assert(cvector__file_open(&records, &file, path, CVECTOR_FILE__RDONLY) == 0);
+  assert(cvector__size(&records) == 1);
+  assert(cvector__first(&records).id == 7);
+  cvector__file_close(&records, &file);
+
+  // header claiming more room than the file has is refused
+  int fd = open(path, O_RDWR);
+  uint64_t saved_cap, cap = (uint64_t)1 << 40;
+  off_t cap_offset = offsetof(cvector_file_header_t, cvector_file_header__cap_m);
+  assert(pread(fd, &saved_cap, sizeof(saved_cap), cap_offset) == sizeof(saved_cap));
+  assert(pwrite(fd, &cap, sizeof(cap), cap_offset) == sizeof(cap));
+  assert(cvector__file_open(&records, &file, path, CVECTOR_FILE__RDWR) == -1);
+  assert(cvector__file_open(&records, &file, path, CVECTOR_FILE__RDONLY) == -1);
+  assert(pwrite(fd, &saved_cap, sizeof(saved_cap), cap_offset) == sizeof(saved_cap));
+  close(fd);
+  assert(cvector__file_open(&records, &file, path, CVECTOR_FILE__RDONLY) == 0);
+  cvector__file_close(&records, &file);
+
+  // element size mismatch is refused
+  CVector(char) vector_char_t;
+  vector_char_t vector_char;
+  assert(cvector__file_open(&vector_char, &file, path, CVECTOR_FILE__RDONLY) == -1);
+
+  // missing file is refused in read only mode
+  unlink(path);
+  assert(cvector__file_open(&records, &file, path, CVECTOR_FILE__RDONLY) == -1);
+}
+
+void test__vector_fd() {
+  CVector(int) vector_int_t;
+
+  char path[] = "/tmp/cvector_test_XXXXXX";
+  int fd = mkstemp(path);
+  unlink(path);
+
+  vector_int_t vector_int;
+  cvector__init(&vector_int);
+  for (int i = 0; i < 2500; i++) {
+    cvector__add(&vector_int, i);
+  }
+
+  vector_int_t empty;
+  cvector__init(&empty);
+
+  assert(cvector__write_fd(fd, &vector_int) == 0);
+  assert(cvector__write_fd(fd, &empty) == 0);
+  assert(cvector__write_fd(fd, &vector_int) == 0);
+  assert(cvector__write_fd_end(fd) == 0);
+
+  // frame by frame, one exact allocation per frame
+  lseek(fd, 0, SEEK_SET);
+
+  vector_int_t read_int;
+  cvector__init(&read_int);
+
+  assert(cvector__read_fd(fd, &read_int) == 1);
+  assert(cvector__size(&read_int) == 2500);
+  assert(cvector__cap_(&read_int) == 2500);
+  for (int i = 0; i < 2500; i++) {
+    assert(cvector__index(&read_int, i) == i);
+  }
+
+  assert(cvector__read_fd(fd, &read_int) == 1);
+  assert(cvector__size(&read_int) == 0);
+
+  assert(cvector__read_fd(fd, &read_int) == 1);
+  assert(cvector__size(&read_int) == 2500);
+
+  assert(cvector__read_fd(fd, &read_int) == 0);
+
+  // chunked, never more than 1000 elements in memory
+  lseek(fd, 0, SEEK_SET);
+
+  cvector_io_reader_t reader;
+  cvector_io_reader__init(&reader);
+
+  size_t total = 0;
+  while (cvector__read_fd_chunk(fd, &read_int, &reader, 1000) == 1) {
+    assert(cvector__size(&read_int) <= 1000);
+    for (size_t i = 0; i < cvector__size(&read_int); i++) {
+      assert(cvector__index(&read_int, i) == (int)((total + i) % 2500));
+    }
+    total += cvector__size(&read_int);
+  }
+  assert(total == 5000);
+
+  // empty chunks are refused, they would never reach the end of the stream
+  lseek(fd, 0, SEEK_SET);
+  cvector_io_reader__init(&reader);
+  errno = 0;
+  assert(cvector__read_fd_chunk(fd, &read_int, &reader, 0) == -1);
+  assert(errno == EINVAL);
+  assert(cvector__read_fd_chunk(fd, &read_int, &reader, 5000) == 1);
+  assert(cvector__size(&read_int) == 2500);
+
+  // elements of another size are refused
+  lseek(fd, 0, SEEK_SET);
+
+  CVector(char) vector_char_t;
+  vector_char_t vector_char;
+  cvector__init(&vector_char);
+  assert(cvector__read_fd(fd, &vector_char) == -1);
+
+  // corrupt counts are refused before allocating, the vector is unchanged
+  cvector_io_frame_t corrupt = {.cvector_io_frame__magic_m = CVECTOR_IO__MAGIC,
+                                .cvector_io_frame__elem_size_m = sizeof(int),
+                                .cvector_io_frame__count_m = (uint64_t)1 << 62};
+  lseek(fd, 0, SEEK_SET);
+  assert(write(fd, &corrupt, sizeof(corrupt)) == sizeof(corrupt));
+  lseek(fd, 0, SEEK_SET);
+  errno = 0;
+  assert(cvector__read_fd(fd, &vector_int) == -1);
+  assert(errno == EPROTO);
+  assert(cvector__size(&vector_int) == 2500);
+  assert(cvector__index(&vector_int, 2499) == 2499);
+
+  close(fd);
+  cvector__free(&vector_int);
+  cvector__free(&read_int);
+  cvector__free(&vector_char);
+}
+
+CVector_concurrent(long) test__concurrent_long_t;
+
+CVector_deque_spsc(long) test__spsc_long_t;
+
+static test__spsc_long_t test__spsc;
+
+static void *test__spsc_producer(void *arg) {
+  (void)arg;
+  for (long i = 0; i < 100000; i++) {
+    while (!cvector__deque_spsc_push(&test__spsc, i)) {
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+
+void test__vector_deque() {
+  CVector_deque(int) deque_int_t;
+
+  deque_int_t deque;
+  cvector__deque_init(&deque);
+  assert(cvector__size(&deque) == 0);
+  assert(cvector__cap_(&deque) == 0);
+
+  // FIFO through many growths, the ring is wrapped when it grows
+  int next_in = 0, next_out = 0;
+  for (int round = 0; round < 2000; round++) {
+    cvector__deque_push_back(&deque, next_in++);
+    cvector__deque_push_back(&deque, next_in++);
+    assert(cvector__deque_pop_front(&deque) == next_out++);
+    assert((cvector__cap_(&deque) & (cvector__cap_(&deque) - 1)) == 0);
+  }
+  assert(cvector__size(&deque) == 2000);
+  for (size_t i = 0; i < cvector__size(&deque); i++) {
+    assert(cvector__deque_index(&deque, i) == next_out + (int)i);
+  }
+  assert(cvector__deque_front(&deque) == 2000);
+  assert(cvector__deque_back(&deque) == 3999);
+
+  // both ends
+  cvector__deque_push_front(&deque, -1);
+  cvector__deque_push_front(&deque, -2);
+  assert(cvector__deque_front(&deque) == -2);
+  assert(cvector__deque_index(&deque, 1) == -1);
+  assert(cvector__deque_pop_back(&deque) == 3999);
+  assert(cvector__deque_pop_front(&deque) == -2);
+  assert(cvector__deque_pop_front(&deque) == -1);
+  *cvector__deque_index_ref(&deque, 0) = 7;
+  assert(cvector__deque_front(&deque) == 7);
+
+  // front pushes on an empty deque wrap below position 0
+  cvector__deque_clear(&deque);
+  for (int i = 0; i < 100; i++) {
+    cvector__deque_push_front(&deque, i);
+  }
+  for (int i = 0; i < 100; i++) {
+    assert(cvector__deque_pop_back(&deque) == i);
+  }
+  assert(cvector__size(&deque) == 0);
+  cvector__deque_free(&deque);
+
+  cvector__deque_reserve(&deque, 100);
+  assert(cvector__cap_(&deque) == 128);
+  cvector__deque_free(&deque);
+
+  // bounded ring between two threads
+  assert(cvector__deque_spsc_init(&test__spsc, 100) == 0);
+  assert(cvector__deque_spsc_cap(&test__spsc) == 128);
+  long value;
+  assert(!cvector__deque_spsc_pop(&test__spsc, &value));
+  for (long i = 0; i < 128; i++) {
+    assert(cvector__deque_spsc_push(&test__spsc, i));
+  }
+  assert(!cvector__deque_spsc_push(&test__spsc, 128));
+  assert(cvector__deque_spsc_size(&test__spsc) == 128);
+  for (long i = 0; i < 128; i++) {
+    assert(cvector__deque_spsc_pop(&test__spsc, &value) && (value == i));
+  }
+
+  pthread_t producer;
+  pthread_create(&producer, NULL, test__spsc_producer, NULL);
+  for (long i = 0; i < 100000; i++) {
+    while (!cvector__deque_spsc_pop(&test__spsc, &value)) {
+      sched_yield();
+    }
+    assert(value == i);
+  }
+  pthread_join(producer, NULL);
+  assert(cvector__deque_spsc_size(&test__spsc) == 0);
+  cvector__deque_spsc_free(&test__spsc);
+}
+
+static void *test__concurrent_writer(void *arg) {
+  test__concurrent_long_t *results = arg;
+  for (long i = 0; i < 10000; i++) {
+    size_t index = cvector__concurrent_add(results, i);
+    assert(cvector__concurrent_index(results, index) == i);
+  }
+  return NULL;
+}
+
+void test__vector_concurrent() {
+  test__concurrent_long_t results;
+  cvector__concurrent_init(&results);
+
+  // segment math: 32, 64, 128, ... elements per segment
+  assert(cvector_segment__of_(0) == 0);
+  assert(cvector_segment__of_(31) == 0);
+  assert(cvector_segment__of_(32) == 1);
+  assert(cvector_segment__offset_(32, 1) == 0);
+  assert(cvector_segment__of_(95) == 1);
+  assert(cvector_segment__offset_(95, 1) == 63);
+  assert(cvector_segment__of_(96) == 2);
+
+  cvector__concurrent_add(&results, -1);
+  long *first = cvector__concurrent_index_ref(&results, 0);
+
+  pthread_t threads[4];
+  for (int i = 0; i < 4; i++) {
+    pthread_create(&threads[i], NULL, test__concurrent_writer, &results);
+  }
+  for (int i = 0; i < 4; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  assert(cvector__size(&results) == 40001);
+
+  // growth never moved the first element
+  assert(cvector__concurrent_index_ref(&results, 0) == first);
+  assert(*first == -1);
+
+  // every value was pushed exactly 4 times
+  long counts[10000] = {0};
+  for (size_t i = 1; i < cvector__size(&results); i++) {
+    counts[cvector__concurrent_index(&results, i)]++;
+  }
+  for (long i = 0; i < 10000; i++) {
+    assert(counts[i] == 4);
+  }
+
+  cvector__concurrent_free(&results);
+}
+
+CVector_sharded(long) test__sharded_long_t;
+
+typedef struct {
+  test__sharded_long_t *results;
+  size_t shard;
+  long count;
+} test__sharded_job_t;
+
+static void *test__sharded_writer(void *arg) {
+  test__sharded_job_t *job = arg;
+  for (long i = 0; i < job->count; i++) {
+    cvector__add(cvector__sharded_shard(job->results, job->shard), ((long)job->shard << 32) | i);
+  }
+  return NULL;
+}
+
+void test__vector_sharded() {
+  CVector(long) vector_long_t;
+
+  test__sharded_long_t results;
+  assert(cvector__sharded_init(&results, 4) == 0);
+  assert(cvector__sharded_count(&results) == 4);
+
+  // shards never share a cache line
+  assert(((uintptr_t)cvector__sharded_shard(&results, 0) % CVECTOR_SHARDED__CACHE_LINE) == 0);
+  assert(((uintptr_t)cvector__sharded_shard(&results, 1) -
+          (uintptr_t)cvector__sharded_shard(&results, 0)) >= CVECTOR_SHARDED__CACHE_LINE);
+
+  // uneven shards, big enough to be copied by several threads
+  test__sharded_job_t jobs[4];
+  pthread_t threads[4];
+  long counts[4] = {1000000, 10, 0, 700000};
+  for (size_t i = 0; i < 4; i++) {
+    jobs[i] = (test__sharded_job_t){.results = &results, .shard = i, .count = counts[i]};
+    pthread_create(&threads[i], NULL, test__sharded_writer, &jobs[i]);
+  }
+  for (size_t i = 0; i < 4; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  assert(cvector__sharded_size(&results) == 1700010);
+
+  vector_long_t all;
+  cvector__init(&all);
+  cvector__add(&all, -1);
+  assert(cvector__sharded_collect(&results, &all) == 0);
+
+  // appended in shard order, with one exact reservation
+  assert(cvector__size(&all) == 1700011);
+  assert(cvector__cap_(&all) == 1700011);
+  assert(cvector__index(&all, 0) == -1);
+  size_t at = 1;
+  for (size_t shard = 0; shard < 4; shard++) {
+    for (long i = 0; i < counts[shard]; i++) {
+      assert(cvector__index(&all, at++) == (((long)shard << 32) | i));
+    }
+  }
+
+  // shards are reusable after clear
+  size_t cap = cvector__cap_(cvector__sharded_shard(&results, 0));
+  cvector__sharded_clear(&results);
+  assert(cvector__sharded_size(&results) == 0);
+  assert(cvector__cap_(cvector__sharded_shard(&results, 0)) == cap);
+
+  cvector__add(cvector__sharded_shard(&results, 2), 7);
+  cvector__setsize_(&all, 0);
+  cvector__sharded_collect(&results, &all);
+  assert(cvector__size(&all) == 1);
+  assert(cvector__index(&all, 0) == 7);
+
+  cvector__free(&all);
+  cvector__sharded_free(&results);
+  assert(cvector__sharded_count(&results) == 0);
+}
+
+static void test__parallel_double(void *elem, void *ctx) {
+  long *value = elem;
+  *value *= 2;
+  (void)ctx;
+}
+
+static void test__parallel_to_int(const void *elem, void *out, void *ctx) {
+  *(int *)out = (int)(*(const long *)elem + *(long *)ctx);
+}
+
+static void test__parallel_sum(void *acc, const void *elem, void *ctx) {
+  *(long *)acc += *(const long *)elem;
+  (void)ctx;
+}
+
+static int test__parallel_compare(const void *a, const void *b) {
+  long x = *(const long *)a;
+  long y = *(const long *)b;
+  return (x > y) - (x < y);
+}
+
+void test__vector_parallel() {
+  CVector(long) vector_long_t;
+  CVector(int) vector_int_t;
+
+  cvector_parallel_t parallel;
+  assert(cvector_parallel__init(&parallel, 4) == 0);
+  assert(cvector_parallel__count(&parallel) == 4);
+
+  vector_long_t vector_long;
+  cvector__init(&vector_long);
+  long n = 1000003;
+  for (long i = 0; i < n; i++) {
+    cvector__add(&vector_long, i);
+  }
+
+  cvector__parallel_for_each(&parallel, &vector_long, test__parallel_double, NULL);
+  for (long i = 0; i < n; i++) {
+    assert(cvector__index(&vector_long, i) == 2 * i);
+  }
+
+  long offset = 1;
+  vector_int_t vector_int;
+  cvector__init(&vector_int);
+  cvector__parallel_map(&parallel, &vector_long, &vector_int, test__parallel_to_int, &offset);
+  assert(cvector__size(&vector_int) == (size_t)n);
+  for (long i = 0; i < n; i++) {
+    assert(cvector__index(&vector_int, i) == 2 * i + 1);
+  }
+
+  long sum = cvector__parallel_reduce(&parallel, &vector_long, 0L, test__parallel_sum, NULL);
+  assert(sum == n * (n - 1));
+
+  // pseudo random values with duplicates, sorted result must be a permutation
+  unsigned long seed = 42;
+  long expected = 0;
+  for (long i = 0; i < n; i++) {
+    seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+    cvector__set_at_index(&vector_long, (size_t)i, (long)(seed >> 44));
+    expected += (long)(seed >> 44);
+  }
+  cvector__parallel_sort(&parallel, &vector_long, test__parallel_compare);
+  for (long i = 1; i < n; i++) {
+    assert(cvector__index(&vector_long, i - 1) <= cvector__index(&vector_long, i));
+  }
+  assert(cvector__parallel_reduce(&parallel, &vector_long, 0L, test__parallel_sum, NULL) ==
+         expected);
+
+  // small and empty vectors
+  cvector__setsize_(&vector_long, 3);
+  cvector__set_at_index(&vector_long, 0, 9);
+  cvector__parallel_sort(&parallel, &vector_long, test__parallel_compare);
+  assert(cvector__index(&vector_long, 2) == 9);
+
+  cvector__setsize_(&vector_long, 0);
+  assert(cvector__parallel_reduce(&parallel, &vector_long, 0L, test__parallel_sum, NULL) == 0);
+
+  cvector__free(&vector_int);
+  cvector__free(&vector_long);
+  cvector_parallel__destroy(&parallel);
+}
+
+void test__vector_simd() {
+  CVector(int) vector_int_t;
+  CVector(float) vector_float_t;
+  CVector(double) vector_double_t;
+
+  vector_int_t vector_int;
+  vector_float_t vector_float;
+  vector_double_t vector_double;
+
+  // every flavour the CPU has, on sizes with and without a scalar tail
+  for (int level = CVECTOR_SIMD__SCALAR; level <= CVECTOR_SIMD__AVX512; level++) {
+    if (cvector_simd__set_level(level) != level) {
+      break;
+    }
+
+    for (int n = 0; n < 300; n += 37) {
+      cvector__init(&vector_int);
+      cvector__init(&vector_float);
+      cvector__init(&vector_double);
+      for (int i = 0; i < n; i++) {
+        int value = (i * 7919) % 101 - 50;
+        cvector__add(&vector_int, value);
+        cvector__add(&vector_float, (float)value);
+        cvector__add(&vector_double, (double)value / 2);
+      }
+
+      int min_int, max_int;
+      float min_float, max_float;
+      double min_double, max_double;
+      if (n == 0) {
+        assert(cvector__find(&vector_int, 0) == -1);
+        assert(cvector__count(&vector_float, 0.0f) == 0);
+        assert(cvector__minmax(&vector_double, &min_double, &max_double) == -1);
+        assert(cvector__sum(&vector_int) == 0);
+      } else {
+        int last = cvector__last(&vector_int);
+        ptrdiff_t first = -1;
+        size_t count = 0;
+        int64_t sum = 0;
+        int min = last;
+        int max = last;
+        for (int i = 0; i < n; i++) {
+          int value = cvector__index(&vector_int, i);
+          first = ((first == -1) && (value == last)) ? i : first;
+          count += (value == last);
+          sum += value;
+          min = (value < min) ? value : min;
+          max = (value > max) ? value : max;
+        }
+
+        assert(cvector__find(&vector_int, last) == first);
+        assert(cvector__find(&vector_float, (float)last) == first);
+        assert(cvector__find(&vector_double, (double)last / 2) == first);
+        assert(cvector__find(&vector_int, 1000) == -1);
+
+        assert(cvector__count(&vector_int, last) == count);
+        assert(cvector__count(&vector_float, (float)last) == count);
+        assert(cvector__count(&vector_double, (double)last / 2) == count);
+
+        assert(cvector__minmax(&vector_int, &min_int, &max_int) == 0);
+        assert((min_int == min) && (max_int == max));
+        assert(cvector__minmax(&vector_float, &min_float, &max_float) == 0);
+        assert((min_float == min) && (max_float == max));
+        assert(cvector__minmax(&vector_double, &min_double, &max_double) == 0);
+        assert((min_double == (double)min / 2) && (max_double == (double)max / 2));
+
+        // small integers, exact in any order
+        assert(cvector__sum(&vector_int) == sum);
+        assert(cvector__sum(&vector_float) == (float)sum);
+        assert(cvector__sum(&vector_double) == (double)sum / 2);
+      }
+
+      cvector__free(&vector_int);
+      cvector__free(&vector_float);
+      cvector__free(&vector_double);
+    }
+  }
+
+  // int sums don't overflow
+  cvector__init(&vector_int);
+  for (int i = 0; i < 100; i++) {
+    cvector__add(&vector_int, INT_MAX);
+  }
+  assert(cvector__sum(&vector_int) == (int64_t)INT_MAX * 100);
+  cvector__free(&vector_int);
+
+  cvector_simd__set_level(CVECTOR_SIMD__AVX512);
+}
+
+static int test__sorted_compare_int(const void *a, const void *b) {
+  int x = *(const int *)a;
+  int y = *(const int *)b;
+  return (x > y) - (x < y);
+}
+
+typedef struct {
+  long key;
+  char payload[40];
+} test__sorted_record_t;
+
+static int test__sorted_compare_record(const void *a, const void *b) {
+  long x = ((const test__sorted_record_t *)a)->key;
+  long y = ((const test__sorted_record_t *)b)->key;
+  return (x > y) - (x < y);
+}
+
+void test__vector_sorted() {
+  CVector(int) vector_int_t;
+  CVector(unsigned char) vector_uchar_t;
+  CVector(long) vector_long_t;
+  CVector(test__sorted_record_t) vector_record_t;
+  CVector_eytzinger(int) eytzinger_int_t;
+
+  // introsort on many sizes, sorted, reversed and duplicate heavy input
+  for (int n = 0; n < 2000; n = n * 3 + 1) {
+    vector_int_t vector_int;
+    cvector__init(&vector_int);
+    for (int i = 0; i < n; i++) {
+      cvector__add(&vector_int, (i * 7919) % 13);
+    }
+    cvector__sort(&vector_int, test__sorted_compare_int);
+    for (int i = 1; i < n; i++) {
+      assert(cvector__index(&vector_int, i - 1) <= cvector__index(&vector_int, i));
+    }
+    cvector__free(&vector_int);
+  }
+
+  vector_record_t records;
+  cvector__init(&records);
+  for (long i = 0; i < 5000; i++) {
+    test__sorted_record_t record = {.key = 5000 - i};
+    memset(record.payload, (int)(record.key % 128), sizeof(record.payload));
+    cvector__add(&records, record);
+  }
+  cvector__sort(&records, test__sorted_compare_record);
+  for (long i = 0; i < 5000; i++) {
+    assert(cvector__index(&records, i).key == i + 1);
+    assert(cvector__index(&records, i).payload[39] == (char)((i + 1) % 128));
+  }
+  cvector__free(&records);
+
+  // radix sort, signed and unsigned element types
+  vector_long_t vector_long;
+  cvector__init(&vector_long);
+  unsigned long seed = 7;
+  for (int i = 0; i < 10000; i++) {
+    seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+    cvector__add(&vector_long, (long)seed);
+  }
+  cvector__add(&vector_long, LONG_MIN);
+  cvector__add(&vector_long, LONG_MAX);
+  cvector__add(&vector_long, 0);
+  cvector__radix_sort(&vector_long);
+  assert(cvector__first(&vector_long) == LONG_MIN);
+  assert(cvector__last(&vector_long) == LONG_MAX);
+  for (size_t i = 1; i < cvector__size(&vector_long); i++) {
+    assert(cvector__index(&vector_long, i - 1) <= cvector__index(&vector_long, i));
+  }
+  cvector__free(&vector_long);
+
+  vector_uchar_t vector_uchar;
+  cvector__init(&vector_uchar);
+  for (int i = 0; i < 1000; i++) {
+    cvector__add(&vector_uchar, (unsigned char)(255 - i % 256));
+  }
+  cvector__radix_sort(&vector_uchar);
+  for (size_t i = 1; i < cvector__size(&vector_uchar); i++) {
+    assert(cvector__index(&vector_uchar, i - 1) <= cvector__index(&vector_uchar, i));
+  }
+  cvector__free(&vector_uchar);
+
+  // negative keys, and keys sharing every byte but the lowest
+  vector_int_t vector_int;
+  cvector__init(&vector_int);
+  for (int i = 0; i < 300; i++) {
+    cvector__add(&vector_int, (i % 2) ? -i : i % 200);
+  }
+  cvector__radix_sort(&vector_int);
+  assert(cvector__first(&vector_int) == -299);
+  for (size_t i = 1; i < cvector__size(&vector_int); i++) {
+    assert(cvector__index(&vector_int, i - 1) <= cvector__index(&vector_int, i));
+  }
+
+  // searching even numbers 0, 2, ... 198
+  cvector__setsize_(&vector_int, 0);
+  for (int i = 0; i < 100; i++) {
+    cvector__add(&vector_int, 2 * i);
+  }
+  assert(cvector__lower_bound(&vector_int, -5, test__sorted_compare_int) == 0);
+  assert(cvector__lower_bound(&vector_int, 0, test__sorted_compare_int) == 0);
+  assert(cvector__lower_bound(&vector_int, 7, test__sorted_compare_int) == 4);
+  assert(cvector__lower_bound(&vector_int, 198, test__sorted_compare_int) == 99);
+  assert(cvector__lower_bound(&vector_int, 199, test__sorted_compare_int) == 100);
+  assert(cvector__binary_search(&vector_int, 42, test__sorted_compare_int) == 21);
+  assert(cvector__binary_search(&vector_int, 43, test__sorted_compare_int) == -1);
+  assert(cvector__binary_search(&vector_int, 500, test__sorted_compare_int) == -1);
+
+  // Eytzinger view answers like the sorted vector
+  eytzinger_int_t view;
+  assert(cvector__eytzinger_build(&view, &vector_int) == 0);
+  assert(cvector__eytzinger_size(&view) == 100);
+  for (int key = -1; key < 201; key++) {
+    const int *found = cvector__eytzinger_find(&view, key, test__sorted_compare_int);
+    const int *bound = cvector__eytzinger_lower_bound(&view, key, test__sorted_compare_int);
+    size_t at = cvector__lower_bound(&vector_int, key, test__sorted_compare_int);
+    if ((key >= 0) && (key % 2 == 0) && (key < 200)) {
+      assert((found != NULL) && (*found == key));
+    } else {
+      assert(found == NULL);
+    }
+    assert((at == 100) ? (bound == NULL) : (*bound == cvector__index(&vector_int, at)));
+  }
+  cvector__eytzinger_free(&view);
+
+  // batch of odd numbers (unsorted, with duplicates) merged in
+  int batch[] = {199, 1, 51, 51, -1, 1000};
+  assert(cvector__insert_sorted(&vector_int, batch, 6, test__sorted_compare_int) == 0);
+  assert(cvector__size(&vector_int) == 106);
+  assert(cvector__first(&vector_int) == -1);
+  assert(cvector__index(&vector_int, 2) == 1);
+  assert(cvector__last(&vector_int) == 1000);
+  for (size_t i = 1; i < cvector__size(&vector_int); i++) {
+    assert(cvector__index(&vector_int, i - 1) <= cvector__index(&vector_int, i));
+  }
+  assert(cvector__insert_sorted(&vector_int, batch, 0, test__sorted_compare_int) == 0);
+  assert(cvector__size(&vector_int) == 106);
+
+  cvector__free(&vector_int);
+}
+
+#define TEST__PARTICLE_FIELDS(X) X(double, x) X(char, tag) X(int, id) X(short, kind)
+
+typedef struct {
+  TEST__PARTICLE_FIELDS(CVECTOR_SOA__FIELD)
+} test__particle_t;
+
+void test__vector_soa() {
+  CVector_soa(test__particle_t, TEST__PARTICLE_FIELDS) vector_particle_t;
+  CVector_soa_iterator(vector_particle_t) iterator_particle_t;
+
+  vector_particle_t particles;
+  cvector__soa_init(&particles, TEST__PARTICLE_FIELDS);
+  assert(cvector__size(&particles) == 0);
+  assert(cvector__cap_(&particles) == 0);
+
+  // single adds grow every column together
+  for (int i = 0; i < 100; i++) {
+    cvector__soa_add(&particles,
+                     ((test__particle_t){.x = i * 0.5, .tag = (char)('a' + i % 26), .id = i,
+                                         .kind = (short)(-i)}));
+  }
+  assert(cvector__size(&particles) == 100);
+  assert(cvector__cap_(&particles) >= 100);
+  assert(((uintptr_t)cvector__soa_column(&particles, x) % CVECTOR_SOA__ALIGN) == 0);
+  assert(((uintptr_t)cvector__soa_column(&particles, tag) % CVECTOR_SOA__ALIGN) == 0);
+  assert(((uintptr_t)cvector__soa_column(&particles, id) % CVECTOR_SOA__ALIGN) == 0);
+  assert(((uintptr_t)cvector__soa_column(&particles, kind) % CVECTOR_SOA__ALIGN) == 0);
+  for (int i = 0; i < 100; i++) {
+    assert(cvector__soa_index(&particles, x, i) == i * 0.5);
+    assert(cvector__soa_index(&particles, tag, i) == (char)('a' + i % 26));
+    assert(cvector__soa_index(&particles, id, i) == i);
+    assert(cvector__soa_index(&particles, kind, i) == -i);
+  }
+
+  // fields can be assigned, records gathered back
+  cvector__soa_index(&particles, id, 42) = 4242;
+  test__particle_t particle = cvector__soa_get(&particles, 42);
+  assert((particle.x == 21.0) && (particle.tag == 'q') && (particle.id == 4242));
+  assert(particle.kind == -42);
+
+  // bulk append from an array of records
+  test__particle_t records[1000];
+  for (int i = 0; i < 1000; i++) {
+    records[i] = (test__particle_t){.x = -i, .tag = 'z', .id = 100 + i, .kind = (short)i};
+  }
+  cvector__soa_add_n(&particles, records, 1000);
+  assert(cvector__size(&particles) == 1100);
+  assert(cvector__soa_index(&particles, id, 42) == 4242);
+  assert(cvector__soa_index(&particles, x, 99) == 49.5);
+
+  // iterator walks rows in order
+  iterator_particle_t iterator;
+  cvector_soa_iterator__init(&iterator, &particles);
+  size_t rows = 0;
+  while (!cvector_soa_iterator__done(&iterator)) {
+    size_t row = cvector_soa_iterator__next(&iterator);
+    assert(row == rows++);
+    if (row >= 100) {
+      assert(cvector_soa_iterator__field(&iterator, id) == (int)row);
+      assert(cvector_soa_iterator__field(&iterator, tag) == 'z');
+      assert(cvector_soa_iterator__field(&iterator, kind) == (short)(row - 100));
+    }
+  }
+  assert(rows == 1100);
+
+  // exact reserve, clear keeps capacity
+  cvector__soa_reserve(&particles, 5000);
+  assert(cvector__cap_(&particles) == 5000);
+  assert(cvector__soa_index(&particles, x, 1099) == -999.0);
+  cvector__soa_clear(&particles);
+  assert(cvector__size(&particles) == 0);
+  assert(cvector__cap_(&particles) == 5000);
+  cvector__soa_add_n(&particles, records, 0);
+  assert(cvector__size(&particles) == 0);
+
+  cvector__soa_free(&particles);
+  assert(cvector__cap_(&particles) == 0);
+  assert(cvector__soa_column(&particles, x) == NULL);
+}
+
+void test__vector_bits() {
+  CVector_bits bits_t;
+
+  bits_t bits;
+  cvector__bits_init(&bits);
+  assert(cvector__size(&bits) == 0);
+  assert(cvector__bits_count(&bits) == 0);
+  assert(cvector__bits_find_next(&bits, 0) == -1);
+
+  // adds cross word boundaries, resizing clears the new bits and the cut ones
+  for (size_t i = 0; i < 200; i++) {
+    cvector__bits_add(&bits, i % 3 == 0);
+  }
+  assert(cvector__size(&bits) == 200);
+  assert(cvector__bits_count(&bits) == 67);
+  assert(cvector__bits_test(&bits, 63) && !cvector__bits_test(&bits, 64));
+  assert(cvector__bits_resize(&bits, 100) == 0);
+  assert(cvector__bits_count(&bits) == 34);
+  assert(cvector__bits_resize(&bits, 1000) == 0);
+  assert(cvector__bits_count(&bits) == 34);
+  assert(!cvector__bits_test(&bits, 102));
+  cvector__bits_set(&bits, 999);
+  cvector__bits_clear(&bits, 0);
+  assert(cvector__bits_test(&bits, 999) && !cvector__bits_test(&bits, 0));
+  assert(cvector__bits_find_next(&bits, 0) == 3);
+  assert(cvector__bits_find_next(&bits, 100) == 999);
+  assert(cvector__bits_find_next(&bits, 1000) == -1);
+  cvector__bits_clear_all(&bits);
+  assert(cvector__bits_count(&bits) == 0);
+  assert(cvector__size(&bits) == 1000);
+  cvector__bits_free(&bits);
+  assert(cvector__size(&bits) == 0);
+
+  // every kernel flavour against bool arrays, sizes not multiple of any vector width
+  size_t n = 100003;
+  size_t m = 70001;
+  bool *a = malloc(n);
+  bool *b = malloc(m);
+  bool *expected = malloc(n);
+  bits_t x, y;
+  cvector__bits_init(&x);
+  cvector__bits_init(&y);
+  for (int level = CVECTOR_SIMD__SCALAR; level <= CVECTOR_SIMD__AVX512; level++) {
+    if (cvector_simd__set_level(level) != level) {
+      continue;
+    }
+    for (int op = 0; op < 4; op++) {
+      unsigned long seed = 42 + (unsigned long)op;
+      cvector__bits_resize(&x, 0);
+      cvector__bits_resize(&y, 0);
+      for (size_t i = 0; i < n; i++) {
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        a[i] = (seed >> 60) < 5;
+        cvector__bits_add(&x, a[i]);
+        if (i < m) {
+          b[i] = (seed >> 40) & 1;
+          cvector__bits_add(&y, b[i]);
+        }
+      }
+
+      size_t count = 0;
+      for (size_t i = 0; i < n; i++) {
+        count += a[i];
+      }
+      assert(cvector__bits_count(&x) == count);
+
+      // 'y' is shorter: its missing bits are 0
+      for (size_t i = 0; i < n; i++) {
+        bool other = (i < m) && b[i];
+        expected[i] = (op == 0)   ? (a[i] && other)
+                      : (op == 1) ? (a[i] || other)
+                      : (op == 2) ? (a[i] != other)
+                                  : (a[i] && !other);
+      }
+      if (op == 0) {
+        cvector__bits_and(&x, &y);
+      } else if (op == 1) {
+        cvector__bits_or(&x, &y);
+      } else if (op == 2) {
+        cvector__bits_xor(&x, &y);
+      } else {
+        cvector__bits_andnot(&x, &y);
+      }
+
+      count = 0;
+      ptrdiff_t next = cvector__bits_find_next(&x, 0);
+      for (size_t i = 0; i < n; i++) {
+        assert(cvector__bits_test(&x, i) == expected[i]);
+        if (expected[i]) {
+          assert(next == (ptrdiff_t)i);
+          next = cvector__bits_find_next(&x, i + 1);
+          count++;
+        }
+      }
+      assert(next == -1);
+      assert(cvector__bits_count(&x) == count);
+
+      // the longer vector into the shorter one keeps bits past its size clear
+      cvector__bits_or(&y, &x);
+      assert(cvector__size(&y) == m);
+      assert(cvector__bits_find_next(&y, m - 1) <= (ptrdiff_t)(m - 1));
+    }
+  }
+  cvector_simd__set_level(CVECTOR_SIMD__AVX512);
+  cvector__bits_free(&x);
+  cvector__bits_free(&y);
+  free(a);
+  free(b);
+  free(expected);
+}
+
+typedef struct {
+  int x;
+  int y;
+} test__point_t;
+
+static uint64_t test__point_hash(test__point_t point) {
+  return cmap__hash_default(((uint64_t)(unsigned int)point.x << 32) | (unsigned int)point.y);
+}
+
+static bool test__point_eq(test__point_t a, test__point_t b) {
+  return (a.x == b.x) && (a.y == b.y);
+}
+
+void test__vector_map() {
+  CMap(int, long) map_int_long_t;
+
+  map_int_long_t map;
+  cmap__init(&map);
+  assert(cmap__size(&map) == 0);
+  assert(cmap__get_ref(&map, 1) == NULL);
+  assert(!cmap__remove(&map, 1));
+
+  int n = 100000;
+  for (int i = 0; i < n; i++) {
+    assert(cmap__put(&map, i * 7, (long)i) == 0);
+  }
+  assert(cmap__size(&map) == (size_t)n);
+  for (int i = 0; i < n; i++) {
+    assert(cmap__get(&map, i * 7, -1L) == i);
+    assert(!cmap__contains(&map, i * 7 + 1));
+  }
+
+  // replacing keeps size, entries are in insertion order
+  assert(cmap__put(&map, 7, 100L) == 0);
+  assert(cmap__size(&map) == (size_t)n);
+  *cmap__get_ref(&map, 14) += 1;
+  assert(cmap__value_at(&map, 2) == 3);
+  assert(cmap__key_at(&map, 1) == 7);
+
+  // removing moves last entry in place, tombstones get reused
+  for (int i = 0; i < n; i += 2) {
+    assert(cmap__remove(&map, i * 7));
+  }
+  assert(cmap__size(&map) == (size_t)n / 2);
+  for (int i = 0; i < n; i++) {
+    assert(cmap__contains(&map, i * 7) == (i % 2 == 1));
+  }
+  long sum = 0;
+  for (size_t i = 0; i < cmap__size(&map); i++) {
+    assert(cmap__key_at(&map, i) % 2 == 1);
+    sum += cmap__value_at(&map, i);
+  }
+  assert(sum == (long)(n / 2) * (n / 2) + 99);
+  for (int round = 0; round < 10; round++) {
+    for (int i = 0; i < 1000; i++) {
+      assert(cmap__put(&map, -i - 1, (long)round) == 0);
+    }
+    for (int i = 0; i < 1000; i++) {
+      assert(cmap__remove(&map, -i - 1));
+    }
+  }
+  assert(cmap__size(&map) == (size_t)n / 2);
+  assert(cmap__get(&map, 7, 0L) == 100);
+
+  cmap__shrink_to_fit(&map);
+  assert(cmap__get(&map, 21, 0L) == 3);
+  assert(cmap__reserve(&map, 2 * (size_t)n) == 0);
+  assert(cmap__get(&map, 21, 0L) == 3);
+
+  cmap__clear(&map);
+  assert(cmap__size(&map) == 0);
+  assert(!cmap__contains(&map, 7));
+  assert(cmap__put(&map, 7, 1L) == 0);
+  assert(cmap__get(&map, 7, 0L) == 1);
+  cmap__free(&map);
+  assert(cmap__size(&map) == 0);
+
+  // strings with their own hash and equality, keys compared by content
+  CMap(const char *, int) map_str_int_t;
+  map_str_int_t words;
+  cmap__init(&words);
+  char key[16];
+  for (int i = 0; i < 1000; i++) {
+    snprintf(key, sizeof(key), "word%d", i);
+    assert(cmap__put_with(&words, strdup(key), i, cmap__hash_str, cmap__eq_str) == 0);
+  }
+  snprintf(key, sizeof(key), "word%d", 420);
+  assert(cmap__get_with(&words, key, -1, cmap__hash_str, cmap__eq_str) == 420);
+  assert(!cmap__contains_with(&words, "word1000", cmap__hash_str, cmap__eq_str));
+  for (size_t i = 0; i < cmap__size(&words); i++) {
+    free((char *)cmap__key_at(&words, i));
+  }
+  cmap__free(&words);
+
+  // struct keys
+  CMap(test__point_t, int) map_point_int_t;
+  map_point_int_t points;
+  cmap__init(&points);
+  for (int x = 0; x < 100; x++) {
+    for (int y = 0; y < 100; y++) {
+      test__point_t point = {x, y};
+      cmap__put_with(&points, point, x * y, test__point_hash, test__point_eq);
+    }
+  }
+  test__point_t point = {12, 34};
+  assert(cmap__get_with(&points, point, -1, test__point_hash, test__point_eq) == 12 * 34);
+  assert(cmap__remove_with(&points, point, test__point_hash, test__point_eq));
+  assert(!cmap__contains_with(&points, point, test__point_hash, test__point_eq));
+  assert(cmap__size(&points) == 100 * 100 - 1);
+  cmap__free(&points);
+}
+
+void test__vector_packed() {
+  CVector_packed(uint64_t) packed_u64_t;
+  CVector_packed_iterator(packed_u64_t) packed_u64_iterator_t;
+
+  // each generator is one encoding: delta, FOR, constant stride, raw, wide delta
+  uint64_t seed = 42;
+  for (int kind = 0; kind < 5; kind++) {
+    packed_u64_t vector;
+    cvector__packed_init(&vector);
+    assert(cvector__size(&vector) == 0);
+
+    size_t n = 100000;
+    uint64_t *expected = malloc(n * sizeof(uint64_t));
+    uint64_t value = 1000000000;
+    for (size_t i = 0; i < n; i++) {
+      seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+      if (kind == 0) {
+        value += (seed >> 54);
+      } else if (kind == 1) {
+        value = 5000000 + (seed >> 52);
+      } else if (kind == 2) {
+        value += 1000;
+      } else if (kind == 3) {
+        value = seed;
+      } else {
+        value += (seed >> 36);
+      }
+      expected[i] = value;
+      cvector__packed_add(&vector, value);
+    }
+    assert(cvector__size(&vector) == n);
+
+    for (size_t i = 0; i < n; i++) {
+      assert(cvector__packed_index(&vector, i) == expected[i]);
+    }
+    assert(cvector__packed_last(&vector) == expected[n - 1]);
+
+    packed_u64_iterator_t iterator;
+    cvector_packed_iterator__init(&iterator, &vector);
+    size_t count = 0;
+    while (!cvector_packed_iterator__done(&iterator)) {
+      assert(cvector_packed_iterator__next(&iterator) == expected[count]);
+      count++;
+    }
+    assert(count == n);
+
+    // 10 bit gaps, 12 bit values, no bits at all, 64 bits, 28 bit gaps
+    cvector__packed_shrink_to_fit(&vector);
+    size_t bytes = cvector__packed_bytes(&vector);
+    size_t raw = n * sizeof(uint64_t);
+    assert((kind != 0) || (bytes * 4 < raw));
+    assert((kind != 1) || (bytes * 4 < raw));
+    assert((kind != 2) || (bytes * 20 < raw));
+    assert((kind != 3) || (bytes < raw + raw / 8));
+    assert((kind != 4) || (bytes * 2 < raw));
+
+    cvector__packed_clear(&vector);
+    assert(cvector__size(&vector) == 0);
+    cvector__packed_add(&vector, 7);
+    assert(cvector__packed_index(&vector, 0) == 7);
+
+    cvector__packed_free(&vector);
+    assert(cvector__size(&vector) == 0);
+    free(expected);
+  }
+
+  // iterator resumes where it stopped once the tail it finished was packed
+  packed_u64_t growing;
+  cvector__packed_init(&growing);
+  packed_u64_iterator_t resumed;
+  cvector_packed_iterator__init(&resumed, &growing);
+  uint64_t next = 0;
+  for (uint64_t i = 0; i < 1000; i++) {
+    cvector__packed_add(&growing, i * 3);
+    if (i % 50 == 0) {
+      while (!cvector_packed_iterator__done(&resumed)) {
+        assert(cvector_packed_iterator__next(&resumed) == next * 3);
+        next++;
+      }
+    }
+  }
+  while (!cvector_packed_iterator__done(&resumed)) {
+    assert(cvector_packed_iterator__next(&resumed) == next * 3);
+    next++;
+  }
+  assert(next == 1000);
+  cvector__packed_free(&growing);
+
+  // narrower element types, blocks mixing encodings
+  CVector_packed(unsigned int) packed_uint_t;
+  packed_uint_t vector;
+  cvector__packed_init(&vector);
+  for (unsigned int i = 0; i < 1000; i++) {
+    cvector__packed_add(&vector, (i < 500) ? i : UINT_MAX - i * 7919);
+  }
+  for (unsigned int i = 0; i < 1000; i++) {
+    assert(cvector__packed_index(&vector, i) == ((i < 500) ? i : UINT_MAX - i * 7919));
+  }
+  cvector__packed_free(&vector);
+}
+
+void test__vector_stable() {
+  CVector_stable(long) stable_long_t;
+  CVector_stable_iterator(stable_long_t) stable_long_iterator_t;
+
+  stable_long_t vector;
+  cvector__stable_init(&vector);
+  assert(cvector__size(&vector) == 0);
+  assert(cvector__cap_(&vector) == 0);
+
+  // references taken early survive every later growth
+  cvector__stable_add(&vector, 100);
+  long *first = cvector__stable_index_ref(&vector, 0);
+  long *refs[20];
+  for (long i = 1; i < 100000; i++) {
+    cvector__stable_add(&vector, i);
+    if (i < 20) {
+      refs[i] = cvector__stable_last_ref(&vector);
+    }
+  }
+  assert(cvector__size(&vector) == 100000);
+  assert(first == cvector__stable_index_ref(&vector, 0) && (*first == 100));
+  for (long i = 1; i < 20; i++) {
+    assert((refs[i] == cvector__stable_index_ref(&vector, i)) && (*refs[i] == i));
+  }
+  assert(cvector__cap_(&vector) == cvector_segment__total_(cvector_segment__of_(99999) + 1));
+
+  *first = 0;
+  for (long i = 0; i < 100000; i++) {
+    assert(cvector__stable_index(&vector, i) == i);
+  }
+
+  // iterator crosses segment boundaries
+  stable_long_iterator_t iterator;
+  cvector_stable_iterator__init(&iterator, &vector);
+  long expected = 0;
+  while (!cvector_stable_iterator__done(&iterator)) {
+    assert(cvector_stable_iterator__next(&iterator) == expected++);
+  }
+  assert(expected == 100000);
+
+  // pop keeps segments, shrink frees only the empty ones
+  size_t cap = cvector__cap_(&vector);
+  assert(cvector__stable_pop(&vector) == 99999);
+  assert(cvector__stable_last(&vector) == 99998);
+  while (cvector__size(&vector) > 40) {
+    cvector__stable_pop(&vector);
+  }
+  assert(cvector__cap_(&vector) == cap);
+  cvector__stable_shrink_to_fit(&vector);
+  assert(cvector__cap_(&vector) == 96);
+  assert(first == cvector__stable_index_ref(&vector, 0));
+  assert(cvector__stable_index(&vector, 39) == 39);
+
+  cvector__stable_clear(&vector);
+  assert(cvector__size(&vector) == 0);
+  cvector__stable_reserve(&vector, 1000);
+  assert(cvector__cap_(&vector) >= 1000);
+  cvector__stable_free(&vector);
+  assert(cvector__cap_(&vector) == 0);
+
+  // empty vector iterates nothing
+  cvector_stable_iterator__init(&iterator, &vector);
+  assert(cvector_stable_iterator__done(&iterator));
+}
+
+void test__vector_incremental() {
+  CVector_incremental(long) incremental_long_t;
+
+  incremental_long_t vector;
+  cvector__incremental_init(&vector);
+  assert(!cvector__incremental_migrating(&vector));
+
+  // every element readable at any point of a migration
+  for (long i = 0; i < 20000; i++) {
+    cvector__incremental_add(&vector, i);
+    assert(cvector__incremental_last(&vector) == i);
+    if ((i == 1023) || (i == 1024) || (i == 1100) || (i == 19999)) {
+      for (long j = 0; j <= i; j++) {
+        assert(cvector__incremental_index(&vector, j) == j);
+      }
+    }
+  }
+  assert(cvector__size(&vector) == 20000);
+  assert(cvector__cap_(&vector) == 32768);
+
+  // growth to 1024 left 512 elements behind, migrated a step per add starting with the growing one
+  cvector__incremental_free(&vector);
+  for (long i = 0; i < 513; i++) {
+    cvector__incremental_add(&vector, i);
+  }
+  assert(cvector__incremental_migrating(&vector));
+  assert(vector.cvector_incremental__moved_m == CVECTOR_INCREMENTAL__STEP);
+  cvector__incremental_add(&vector, 513);
+  assert(vector.cvector_incremental__moved_m == 2 * CVECTOR_INCREMENTAL__STEP);
+
+  // writes through references land in the buffer reads come from
+  *cvector__incremental_index_ref(&vector, 500) = -500;
+  *cvector__incremental_index_ref(&vector, 1) = -1;
+  assert(cvector__incremental_index(&vector, 500) == -500);
+  assert(cvector__incremental_index(&vector, 1) == -1);
+
+  // popping into the old part shortens the migration
+  while (cvector__size(&vector) > 200) {
+    cvector__incremental_pop(&vector);
+  }
+  assert(cvector__incremental_migrating(&vector));
+  assert(cvector__incremental_pop(&vector) == 199);
+  while (cvector__size(&vector) > 100) {
+    cvector__incremental_pop(&vector);
+  }
+  assert(!cvector__incremental_migrating(&vector));
+  assert(cvector__incremental_index(&vector, 99) == 99);
+
+  // flush finishes at once
+  for (long i = 100; i < 1025; i++) {
+    cvector__incremental_add(&vector, i);
+  }
+  assert(cvector__incremental_migrating(&vector));
+  cvector__incremental_flush(&vector);
+  assert(!cvector__incremental_migrating(&vector));
+  assert(cvector__incremental_index(&vector, 1) == -1);
+  assert(cvector__incremental_index(&vector, 1024) == 1024);
+
+  cvector__incremental_free(&vector);
+  assert(cvector__size(&vector) == 0);
+  assert(cvector__cap_(&vector) == 0);
+
+  // slower growth policies still double, so no add has to finish a migration at once
+  cvector__set_growth(&vector, CVECTOR__GROWTH_1_5X);
+  for (long i = 0; i < 100000; i++) {
+    size_t cap = cvector__cap_(&vector);
+    if ((cap > 0) && (cvector__size(&vector) == cap)) {
+      assert(!cvector__incremental_migrating(&vector));
+      cvector__incremental_add(&vector, i);
+      assert(cvector__cap_(&vector) >= 2 * cap);
+    } else {
+      cvector__incremental_add(&vector, i);
+    }
+  }
+  assert(cvector__incremental_index(&vector, 99999) == 99999);
+  cvector__incremental_free(&vector);
+}
+
+CVECTOR_DEFINE(test__vec_int, int)
+
+CVECTOR_DECLARE(test__vec_double, double)
+CVECTOR_IMPL(test__vec_double, double)
+
+void test__vector_typed() {
+  test__vec_int_t numbers;
+  test__vec_int_init(&numbers);
+  assert(test__vec_int_size(&numbers) == 0);
+  assert(test__vec_int_cap(&numbers) == 0);
+
+  for (int i = 0; i < 1000; i++) {
+    test__vec_int_add(&numbers, i);
+  }
+  assert(test__vec_int_size(&numbers) == 1000);
+  assert(test__vec_int_cap(&numbers) == 1024);
+  assert(test__vec_int_index(&numbers, 999) == 999);
+  *test__vec_int_index_ref(&numbers, 0) = -1;
+  assert(test__vec_int_set_at_index(&numbers, 1, -2) == 0);
+  assert(test__vec_int_set_at_index(&numbers, 1000, 0) == -1);
+
+  // typed vectors are plain vectors, macros work on them
+  assert(cvector__first(&numbers) == -1);
+  assert(cvector__index(&numbers, 1) == -2);
+
+  // popping shrinks like 'cvector__pop'
+  for (int i = 999; i >= 10; i--) {
+    assert(test__vec_int_pop(&numbers) == i);
+  }
+  assert(test__vec_int_cap(&numbers) < 1024);
+  assert(test__vec_int_pop_noshrink(&numbers) == 9);
+
+  int values[] = {7, 8, 9};
+  test__vec_int_add_n(&numbers, values, 3);
+  assert(test__vec_int_size(&numbers) == 12);
+  assert(test__vec_int_index(&numbers, 11) == 9);
+  test__vec_int_shrink_to_fit(&numbers);
+  assert(test__vec_int_cap(&numbers) == 12);
+  test__vec_int_clear(&numbers);
+  assert(test__vec_int_size(&numbers) == 0);
+  test__vec_int_free(&numbers);
+
+  // declared and implemented separately
+  test__vec_double_t doubles;
+  test__vec_double_init(&doubles);
+  test__vec_double_reserve(&doubles, 100);
+  assert(test__vec_double_cap(&doubles) == 100);
+  test__vec_double_add(&doubles, 0.5);
+  assert(test__vec_double_pop(&doubles) == 0.5);
+  test__vec_double_free(&doubles);
+}
+
+static void *test__vector_share_thread(void *arg) {
+  CVector(int) vector_int_t;
+  vector_int_t *reader = arg;
+  for (int i = 0; i < 100; i++) {
+    cvector__add(reader, -i);
+  }
+  return NULL;
+}
+
+/* Allocator of at most 'budget' bytes per block, to simulate running out of memory. */
+static void *test__budget_alloc(void *ctx, size_t size) {
+  return (size <= *(size_t *)ctx) ? malloc(size) : NULL;
+}
+
+static void *test__budget_realloc(void *ctx, void *mem, size_t old_size, size_t new_size) {
+  (void)old_size;
+  return (new_size <= *(size_t *)ctx) ? realloc(mem, new_size) : NULL;
+}
+
+static void test__budget_free(void *ctx, void *mem, size_t size) {
+  (void)ctx;
+  (void)size;
+  free(mem);
+}
+
+void test__vector_oom() {
+  CVector(int) vector_int_t;
+
+  size_t budget = 64 * sizeof(int);
+  cvector_allocator_t allocator;
+  cvector_allocator__init(&allocator, test__budget_alloc, test__budget_realloc, test__budget_free,
+                          &budget);
+
+  vector_int_t vector;
+  cvector__init_with_allocator(&vector, &allocator);
+  for (int i = 0; i < 100; i++) {
+    cvector__add(&vector, i);
+  }
+
+  // failed growth keeps buffer and cap, extra elements are dropped
+  int *buffer = cvector__wrapped_buffer(&vector);
+  assert(cvector__cap_(&vector) == 64);
+  assert(cvector__size(&vector) == 64);
+  assert(cvector__index(&vector, 63) == 63);
+
+  cvector__reserve(&vector, 1000);
+  assert(cvector__cap_(&vector) == 64);
+  assert(cvector__wrapped_buffer(&vector) == buffer);
+
+  int values[] = {-1, -2};
+  assert(cvector__insert_range(&vector, 0, values, 2) == -1);
+  cvector__add_n(&vector, values, 2);
+  assert(cvector__insert_sorted(&vector, values, 2, test__sorted_compare_int) == -1);
+  assert(cvector__size(&vector) == 64);
+  assert(cvector__index(&vector, 0) == 0);
+
+  // a shared buffer that can't be copied stays shared and unchanged
+  vector_int_t reader;
+  assert(cvector__share(&reader, &vector) == 0);
+  budget = 0;
+  assert(cvector__set_at_index(&reader, 0, -1) == -1);
+  assert(cvector__erase_range(&reader, 0, 1) == -1);
+  assert(cvector__shared(&reader));
+  assert(cvector__index(&reader, 0) == 0);
+  assert(cvector__index(&vector, 0) == 0);
+
+  budget = 64 * sizeof(int);
+  assert(cvector__set_at_index(&reader, 0, -1) == 0);
+  assert(cvector__index(&vector, 0) == 0);
+  cvector__free(&reader);
+  cvector__free(&vector);
+
+  // failed put or reserve leaves the map unchanged
+  CMap(int, long) map_int_long_t;
+  map_int_long_t map;
+  cmap__init(&map);
+  cvector__init_with_allocator(cmap__entries_(&map), &allocator);
+  int added = 0;
+  while (cmap__put(&map, added, (long)added) == 0) {
+    added++;
+  }
+  assert(added == (int)(budget / sizeof(cvector__index(cmap__entries_(&map), 0))));
+  assert(cmap__size(&map) == (size_t)added);
+  assert(cmap__reserve(&map, 1000) == -1);
+  assert(cmap__size(&map) == (size_t)added);
+  assert(cmap__get(&map, added, -1L) == -1);
+  for (int i = 0; i < added; i++) {
+    assert(cmap__get(&map, i, -1L) == i);
+  }
+  cmap__free(&map);
+
+  // failed bit vector growth leaves the bits unchanged
+  CVector_bits bits_t;
+  bits_t bits;
+  cvector__bits_init(&bits);
+  cvector__init_with_allocator(cvector_bits__vec_(&bits), &allocator);
+  assert(cvector__bits_resize(&bits, budget * 8) == 0);
+  cvector__bits_set(&bits, 3);
+  assert(cvector__bits_resize(&bits, budget * 8 + 1) == -1);
+  cvector__bits_add(&bits, true);
+  assert(cvector__size(&bits) == budget * 8);
+  assert(cvector__bits_count(&bits) == 1);
+  assert(cvector__bits_test(&bits, 3));
+  cvector__bits_free(&bits);
+
+  // frame too big for the buffer is refused with ENOMEM, the vector is unchanged
+  char path[] = "/tmp/cvector_test_XXXXXX";
+  int fd = mkstemp(path);
+  unlink(path);
+
+  vector_int_t big;
+  cvector__init(&big);
+  for (int i = 0; i < 1000; i++) {
+    cvector__add(&big, i);
+  }
+  assert(cvector__write_fd(fd, &big) == 0);
+  lseek(fd, 0, SEEK_SET);
+
+  cvector__init_with_allocator(&vector, &allocator);
+  cvector__add(&vector, 42);
+  errno = 0;
+  assert(cvector__read_fd(fd, &vector) == -1);
+  assert(errno == ENOMEM);
+  assert(cvector__size(&vector) == 1);
+  assert(cvector__index(&vector, 0) == 42);
+
+  // chunk that can't be allocated stays pending in the reader, the call can be retried
+  lseek(fd, 0, SEEK_SET);
+  cvector_io_reader_t chunks;
+  cvector_io_reader__init(&chunks);
+  errno = 0;
+  assert(cvector__read_fd_chunk(fd, &vector, &chunks, 1000) == -1);
+  assert(errno == ENOMEM);
+  assert(cvector__size(&vector) == 1);
+
+  budget = 1024 * sizeof(int);
+  assert(cvector__read_fd_chunk(fd, &vector, &chunks, 1000) == 1);
+  assert(cvector__size(&vector) == 1000);
+  assert(cvector__last(&vector) == 999);
+  budget = 64 * sizeof(int);
+
+  close(fd);
+  cvector__free(&big);
+  cvector__free(&vector);
+
+  // failed collect leaves the vector unchanged
+  CVector(long) vector_long_t;
+  test__sharded_long_t shards;
+  assert(cvector__sharded_init(&shards, 2) == 0);
+  for (long i = 0; i < 100; i++) {
+    cvector__add(cvector__sharded_shard(&shards, 1), i);
+  }
+  vector_long_t collected;
+  cvector__init_with_allocator(&collected, &allocator);
+  cvector__add(&collected, 42L);
+  assert(cvector__sharded_collect(&shards, &collected) == -1);
+  assert(cvector__size(&collected) == 1);
+  assert(cvector__index(&collected, 0) == 42);
+  cvector__free(&collected);
+  cvector__sharded_free(&shards);
+}
+
+void test__vector_share() {
+  CVector(int) vector_int_t;
+
+  vector_int_t vector;
+  cvector__init(&vector);
+  for (int i = 0; i < 100; i++) {
+    cvector__add(&vector, i);
+  }
+  assert(cvector__cap_(&vector) == 128);
+
+  // sharing copies nothing
+  vector_int_t reader;
+  assert(cvector__share(&reader, &vector) == 0);
+  assert(cvector__shared(&vector) && cvector__shared(&reader));
+  assert(cvector__elem_(&reader) == cvector__elem_(&vector));
+  assert(cvector__size(&reader) == 100);
+  assert(cvector__index(&reader, 99) == 99);
+
+  // first write copies, the other vector is unchanged
+  cvector__add(&reader, 100);
+  assert(!cvector__shared(&reader));
+  assert(cvector__elem_(&reader) != cvector__elem_(&vector));
+  assert(cvector__size(&reader) == 101);
+  assert(cvector__size(&vector) == 100);
+  assert(cvector__index(&reader, 50) == 50);
+  cvector__free(&reader);
+
+  assert(cvector__share(&reader, &vector) == 0);
+  assert(cvector__set_at_index(&reader, 0, -1) == 0);
+  assert(cvector__index(&reader, 0) == -1);
+  assert(cvector__index(&vector, 0) == 0);
+  cvector__free(&reader);
+
+  // popping copies nothing, but the next add can't write over the shared elements
+  assert(cvector__share(&reader, &vector) == 0);
+  assert(cvector__pop(&reader) == 99);
+  assert(cvector__pop_noshrink(&reader) == 98);
+  assert(cvector__shared(&reader));
+  cvector__add(&reader, -98);
+  assert(cvector__index(&vector, 98) == 98);
+  assert(cvector__index(&reader, 98) == -98);
+  cvector__free(&reader);
+
+  assert(cvector__share(&reader, &vector) == 0);
+  assert(cvector__erase_range(&reader, 0, 10) == 0);
+  assert(cvector__index(&reader, 0) == 10);
+  assert(cvector__index(&vector, 0) == 0);
+  cvector__free(&reader);
+
+  // the last vector holding the buffer takes it back, with its cap
+  int *elems = cvector__elem_(&vector);
+  assert(cvector__shared(&vector));
+  cvector__unshare(&vector);
+  assert(!cvector__shared(&vector));
+  assert(cvector__elem_(&vector) == elems);
+  assert(cvector__cap_(&vector) == 128);
+
+  // readers in other threads, each writing its own copy
+  vector_int_t readers[4];
+  pthread_t threads[4];
+  for (int i = 0; i < 4; i++) {
+    assert(cvector__share(&readers[i], &vector) == 0);
+  }
+  for (int i = 0; i < 4; i++) {
+    pthread_create(&threads[i], NULL, test__vector_share_thread, &readers[i]);
+  }
+  for (int i = 0; i < 4; i++) {
+    pthread_join(threads[i], NULL);
+    assert(cvector__size(&readers[i]) == 200);
+    assert(cvector__index(&readers[i], 99) == 99);
+    assert(cvector__index(&readers[i], 199) == -99);
+    cvector__free(&readers[i]);
+  }
+  assert(cvector__index(&vector, 99) == 99);
+  cvector__free(&vector);
+
+  // sorting a shared vector sorts a copy
+  cvector__init(&vector);
+  for (int i = 0; i < 10; i++) {
+    cvector__add(&vector, 10 - i);
+  }
+  assert(cvector__share(&reader, &vector) == 0);
+  cvector__sort(&reader, test__sorted_compare_int);
+  assert(cvector__index(&reader, 0) == 1);
+  assert(cvector__index(&vector, 0) == 10);
+  cvector__free(&reader);
+  cvector__free(&vector);
+
+  // inline elements of small vectors are copied
+  CVector_small(int, 8) small_int_t;
+  small_int_t small;
+  small_int_t small_reader;
+  cvector__init_small(&small);
+  cvector__add(&small, 1);
+  assert(cvector__share(&small_reader, &small) == 0);
+  assert(!cvector__shared(&small_reader));
+  assert(cvector__index(&small_reader, 0) == 1);
+  cvector__free(&small_reader);
+  cvector__free(&small);
+
+  // typed vectors
+  test__vec_int_t numbers;
+  test__vec_int_t numbers_reader;
+  test__vec_int_init(&numbers);
+  test__vec_int_add(&numbers, 1);
+  test__vec_int_add(&numbers, 2);
+  assert(cvector__share(&numbers_reader, &numbers) == 0);
+  test__vec_int_clear(&numbers_reader);
+  test__vec_int_add(&numbers_reader, 3);
+  assert(test__vec_int_index(&numbers, 0) == 1);
+  assert(test__vec_int_index(&numbers_reader, 0) == 3);
+  test__vec_int_free(&numbers_reader);
+  test__vec_int_free(&numbers);
+}
+
+static void *test__vector_stats_thread(void *arg) {
+  CVector(int) vector_int_t;
+  vector_int_t vector;
+  cvector__init(&vector);
+  for (int i = 0; i < 100; i++) {
+    cvector__add(&vector, i);
+  }
+  cvector__free(&vector);
+  return arg;
+}
+
+void test__vector_stats() {
+#ifdef CVECTOR_STATS
+  CVector(int) vector_int_t;
+
+  vector_int_t vector;
+  cvector__init(&vector);
+  const cvector_stats_t *stats = cvector__stats(&vector);
+  assert(stats->cvector_stats__adds_m == 0);
+
+  // cap goes 1, 2, 4, ..., 128
+  for (int i = 0; i < 100; i++) {
+    cvector__add(&vector, i);
+  }
+  assert(stats->cvector_stats__adds_m == 100);
+  assert(stats->cvector_stats__resizes_m == 8);
+  assert(stats->cvector_stats__shrinks_m == 0);
+  assert(stats->cvector_stats__peak_cap_m == 128 * sizeof(int));
+  assert(stats->cvector_stats__bytes_copied_m <= (1 + 2 + 4 + 8 + 16 + 32 + 64) * sizeof(int));
+
+  int values[] = {1, 2, 3};
+  cvector__add_n(&vector, values, 3);
+  assert(stats->cvector_stats__adds_m == 103);
+  assert(cvector__insert_range(&vector, 0, values, 2) == 0);
+  assert(stats->cvector_stats__adds_m == 105);
+
+  while (cvector__size(&vector) > 31) {
+    cvector__pop(&vector);
+  }
+  assert(stats->cvector_stats__shrinks_m == 1);
+  assert(cvector__cap_(&vector) == 64);
+
+  // 33 of 64 elements unused
+  cvector__free(&vector);
+  assert(stats->cvector_stats__wasted_m == 33 * sizeof(int));
+
+  // presized vector never resizes past its first allocation
+  cvector__init_with_cap(&vector, 100);
+  for (int i = 0; i < 100; i++) {
+    cvector__add(&vector, i);
+  }
+  assert(stats->cvector_stats__adds_m == 100);
+  assert(stats->cvector_stats__resizes_m == 1);
+  assert(stats->cvector_stats__wasted_m == 0);
+  cvector__free(&vector);
+
+  // counters of other threads are part of the totals
+  cvector_stats_t before;
+  cvector_stats_t after;
+  cvector__stats_total(&before);
+  pthread_t thread;
+  pthread_create(&thread, NULL, test__vector_stats_thread, NULL);
+  pthread_join(thread, NULL);
+  cvector__stats_total(&after);
+  assert(after.cvector_stats__adds_m == before.cvector_stats__adds_m + 100);
+  assert(after.cvector_stats__resizes_m == before.cvector_stats__resizes_m + 8);
+
+  // one line per call site, the 'cvector__add' of the thread among them
+  FILE *out = tmpfile();
+  assert(cvector__stats_dump(out) > 0);
+  rewind(out);
+  char line[256];
+  bool found = false;
+  while (fgets(line, sizeof(line), out) != NULL) {
+    found = found || ((strstr(line, "test.c:") != NULL) && (strstr(line, " 100 ") != NULL));
+  }
+  assert(found);
+  fclose(out);
+#else
+  assert(cvector__stats_dump(stdout) == 0);
+  pthread_t thread;
+  pthread_create(&thread, NULL, test__vector_stats_thread, NULL);
+  pthread_join(thread, NULL);
+#endif
+}
+
 int main() {
   // vector apis
   test__vector_init();
   test__vector_free();
+  test__vector_resize();
   test__vector_init_with_cap();
   test__vector_add();
   test__vector_setsize();
   test__vector_setcap();
   test__vector_loop();
   test__vector_pop();
+  test__vector_pop_noshrink();
+  test__vector_shrink();
   test__vector_set_at_index();
+  test__vector_small();
+  test__vector_growth();
+  test__vector_reserve();
+  test__vector_shrink_to_fit();
+  test__vector_noshrink();
+  test__vector_typed();
+  test__vector_share();
+
+  // bulk apis
+  test__vector_add_n();
+  test__vector_extend();
+  test__vector_insert_range();
+  test__vector_erase_range();
+
+  // simd kernels
+  test__vector_simd();
+
+  // sorted vectors
+  test__vector_sorted();
+
+  // structure of arrays
+  test__vector_soa();
+
+  // maps
+  test__vector_map();
+
+  // bit vectors
+  test__vector_bits();
+
+  // packed vectors
+  test__vector_packed();
+
+  // stable vectors
+  test__vector_stable();
+  test__vector_incremental();
+
+  // allocators
+  test__vector_arena();
+  test__vector_pool();
+  test__vector_mmap();
+  test__vector_oom();
+
+  // concurrency
+  test__vector_concurrent();
+  test__vector_deque();
+  test__vector_sharded();
+  test__vector_parallel();
+
+  // instrumentation
+  test__vector_stats();
+
+  // persistence
+  test__vector_file();
+  test__vector_fd();
 
   // iterator apis
   test__iterator_new();